@@ -56,6 +56,8 @@ typedef struct dma_info {
 	void		*rxp[MAXDD];	/* parallel array of pointers to packets */
 	ulong		rxdpa;		/* physical address of descriptor ring */
 	uint		rxdalign;	/* #bytes added to alloc'd mem to align rxd */
+	void		*rxpool[MAXDD];	/* recycled rx buffers, reused before allocating */
+	uint		nrxpool;	/* # buffers in rxpool */
 
 	/* tunables */
 	uint		ntxd;		/* # tx descriptors */
@@ -155,6 +157,10 @@ dma_detach(dma_info_t *di)
 	ASSERT(di->txin == di->txout);
 	ASSERT(di->rxin == di->rxout);
 
+	/* free recycled rx buffers */
+	while (di->nrxpool > 0)
+		PKTFREE(di->drv, di->rxpool[--di->nrxpool], FALSE);
+
 	/* free dma descriptor rings */
 	if (di->txd)
 		DMA_FREE_CONSISTENT(di->dev, (void *)((uint)di->txd - di->txdalign), (DMAMAXRINGSZ + DMARINGALIGN), di->txdpa);
@@ -310,117 +316,32 @@ dma_rxenabled(dma_info_t *di)
 	return ((rc != 0xffffffff) && (rc & RC_RE));
 }
 
-/*
- * The BCM47XX family supports full 32bit dma engine buffer addressing so
- * dma buffers can cross 4 Kbyte page boundaries.
- */
-int
-dma_txfast(dma_info_t *di, void *p0, uint32 coreflags)
-{
-	void *p, *next;
-	uchar *data;
-	uint len;
-	uint txout;
-	uint32 ctrl;
-	uint32 pa;
-
-	DMA_TRACE(("%s: dma_txfast\n", di->name));
-
-	txout = di->txout;
-	ctrl = 0;
-
-	/*
-	 * Walk the chain of packet buffers
-	 * allocating and initializing transmit descriptor entries.
-	 */
-	for (p = p0; p; p = next) {
-		data = PKTDATA(di->drv, p);
-		len = PKTLEN(di->drv, p);
-		next = PKTNEXT(di->drv, p);
-
-		/* return nonzero if out of tx descriptors */
-		if (NEXTTXD(txout) == di->txin)
-			goto outoftxd;
-
-		if (len == 0)
-			continue;
-
-		/* get physical address of buffer start */
-		pa = (uint32) DMA_MAP(di->dev, data, len, DMA_TX, p);
-
-		/* build the descriptor control value */
-		ctrl = len & CTRL_BC_MASK;
-
-		ctrl |= coreflags;
-		
-		if (p == p0)
-			ctrl |= CTRL_SOF;
-		if (next == NULL)
-			ctrl |= (CTRL_IOC | CTRL_EOF);
-		if (txout == (di->ntxd - 1))
-			ctrl |= CTRL_EOT;
-
-		/* init the tx descriptor */
-		W_SM(&di->txd[txout].ctrl, BUS_SWAP32(ctrl));
-		W_SM(&di->txd[txout].addr, BUS_SWAP32(pa + di->dataoffset));
-
-		ASSERT(di->txp[txout] == NULL);
-
-		txout = NEXTTXD(txout);
-	}
-
-	/* if last txd eof not set, fix it */
-	if (!(ctrl & CTRL_EOF))
-		W_SM(&di->txd[PREVTXD(txout)].ctrl, BUS_SWAP32(ctrl | CTRL_IOC | CTRL_EOF));
-
-	/* save the packet */
-	di->txp[PREVTXD(txout)] = p0;
-
-	/* bump the tx descriptor index */
-	di->txout = txout;
-
-	/* kick the chip */
-	W_REG(&di->regs->xmtptr, I2B(txout));
-
-	/* tx flow control */
-	di->txavail = di->ntxd - NTXDACTIVE(di->txin, di->txout) - 1;
-
-	return (0);
-
-outoftxd:
-	DMA_ERROR(("%s: dma_txfast: out of txds\n", di->name));
-	PKTFREE(di->drv, p0, TRUE);
-	di->txavail = 0;
-	di->hnddma.txnobuf++;
-	return (-1);
-}
-
 #define	PAGESZ		4096
 #define	PAGEBASE(x)	((uint)(x) & ~4095)
 
 /*
- * Just like above except go through the extra effort of splitting
- * buffers that cross 4Kbyte boundaries into multiple tx descriptors.
+ * Build the tx descriptors for one frame without telling the chip.
+ * Buffers that cross 4 Kbyte boundaries are split into several
+ * descriptors if 'split' is set. Returns FALSE if the ring is full,
+ * in which case nothing is posted and the frame stays with the caller.
+ * A frame without any data is freed right away.
  */
-int
-dma_tx(dma_info_t *di, void *p0, uint32 coreflags)
+static bool
+dma_txpost(dma_info_t *di, void *p0, uint32 coreflags, bool split)
 {
 	void *p, *next;
 	uchar *data;
 	uint plen, len;
-	uchar *page, *start, *end;
+	uchar *start, *end;
 	uint txout;
 	uint32 ctrl;
 	uint32 pa;
 
-	DMA_TRACE(("%s: dma_tx\n", di->name));
-
 	txout = di->txout;
 	ctrl = 0;
 
 	/*
 	 * Walk the chain of packet buffers
-	 * splitting those that cross 4 Kbyte boundaries
 	 * allocating and initializing transmit descriptor entries.
 	 */
 	for (p = p0; p; p = next) {
@@ -428,20 +349,15 @@ dma_tx(dma_info_t *di, void *p0, uint32 coreflags)
 		plen = PKTLEN(di->drv, p);
 		next = PKTNEXT(di->drv, p);
 
-		if (plen == 0)
-			continue;
-
-		for (page = (uchar*)PAGEBASE(data);
-			page <= (uchar*)PAGEBASE(data + plen - 1);
-			page += PAGESZ) {
-
-			/* return nonzero if out of tx descriptors */
+		for (start = data; start < (data + plen); start = end) {
+			/* out of tx descriptors */
 			if (NEXTTXD(txout) == di->txin)
-				goto outoftxd;
+				return (FALSE);
 
-			start = (page == (uchar*)PAGEBASE(data))?  data: page;
-			end = (page == (uchar*)PAGEBASE(data + plen))?
-				(data + plen): (page + PAGESZ);
+			if (split)
+				end = MIN(data + plen, (uchar*)PAGEBASE(start) + PAGESZ);
+			else
+				end = data + plen;
 			len = end - start;
 
 			/* build the descriptor control value */
@@ -469,6 +385,12 @@ dma_tx(dma_info_t *di, void *p0, uint32 coreflags)
 		}
 	}
 
+	/* nothing to send, the frame would never be reclaimed */
+	if (txout == di->txout) {
+		PKTFREE(di->drv, p0, TRUE);
+		return (TRUE);
+	}
+
 	/* if last txd eof not set, fix it */
 	if (!(ctrl & CTRL_EOF))
 		W_SM(&di->txd[PREVTXD(txout)].ctrl, BUS_SWAP32(ctrl | CTRL_IOC | CTRL_EOF));
@@ -479,20 +401,88 @@ dma_tx(dma_info_t *di, void *p0, uint32 coreflags)
 	/* bump the tx descriptor index */
 	di->txout = txout;
 
-	/* kick the chip */
-	W_REG(&di->regs->xmtptr, I2B(txout));
+	return (TRUE);
+}
+
+/* tell the chip about all posted descriptors */
+static void
+dma_txkick(dma_info_t *di)
+{
+	W_REG(&di->regs->xmtptr, I2B(di->txout));
 
 	/* tx flow control */
 	di->txavail = di->ntxd - NTXDACTIVE(di->txin, di->txout) - 1;
+}
+
+static int
+dma_txone(dma_info_t *di, void *p0, uint32 coreflags, bool split)
+{
+	if (!dma_txpost(di, p0, coreflags, split)) {
+		DMA_ERROR(("%s: dma_tx: out of txds\n", di->name));
+		PKTFREE(di->drv, p0, TRUE);
+		di->txavail = 0;
+		di->hnddma.txnobuf++;
+		return (-1);
+	}
+
+	/* kick the chip */
+	dma_txkick(di);
 
 	return (0);
+}
 
-outoftxd:
-	DMA_ERROR(("%s: dma_tx: out of txds\n", di->name));
-	PKTFREE(di->drv, p0, TRUE);
-	di->txavail = 0;
-	di->hnddma.txnobuf++;
-	return (-1);
+/*
+ * The BCM47XX family supports full 32bit dma engine buffer addressing so
+ * dma buffers can cross 4 Kbyte page boundaries.
+ */
+int
+dma_txfast(dma_info_t *di, void *p0, uint32 coreflags)
+{
+	DMA_TRACE(("%s: dma_txfast\n", di->name));
+
+	return (dma_txone(di, p0, coreflags, FALSE));
+}
+
+/*
+ * Just like above except go through the extra effort of splitting
+ * buffers that cross 4Kbyte boundaries into multiple tx descriptors.
+ */
+int
+dma_tx(dma_info_t *di, void *p0, uint32 coreflags)
+{
+	DMA_TRACE(("%s: dma_tx\n", di->name));
+
+	return (dma_txone(di, p0, coreflags, TRUE));
+}
+
+/*
+ * Post up to n frames like dma_txfast() but write xmtptr only once,
+ * every register write is an uncached bus access. Returns the number
+ * of frames posted, the remaining ones are left to the caller.
+ */
+int
+dma_txfast_bulk(dma_info_t *di, void **pkts, uint n, uint32 coreflags)
+{
+	uint i;
+
+	DMA_TRACE(("%s: dma_txfast_bulk %d\n", di->name, n));
+
+	for (i = 0; i < n; i++) {
+		if (!dma_txpost(di, pkts[i], coreflags, FALSE)) {
+			DMA_ERROR(("%s: dma_txfast_bulk: out of txds\n", di->name));
+			di->hnddma.txnobuf++;
+			break;
+		}
+	}
+
+	/* kick the chip once for the whole batch */
+	if (i > 0)
+		dma_txkick(di);
+
+	if (i < n)
+		di->txavail = 0;
+
+	return (i);
 }
 
 /* returns a pointer to the next frame received, or NULL if there are no more */
@@ -509,7 +499,7 @@ dma_rx(dma_info_t *di)
 			skiplen -= di->rxbufsize;
 			if (skiplen < 0)
 				skiplen = 0;
-			PKTFREE(di->drv, p, FALSE);
+			dma_rxrecycle(di, p);
 			continue;
 		}
 
@@ -521,7 +511,7 @@ dma_rx(dma_info_t *di)
 			DMA_ERROR(("%s: dma_rx: bad frame length (%d)\n", di->name, len));
 			if (len > 0)
 				skiplen = len - (di->rxbufsize - di->rxoffset);
-			PKTFREE(di->drv, p, FALSE);
+			dma_rxrecycle(di, p);
 			di->hnddma.rxgiants++;
 			continue;
 		}
@@ -562,7 +552,9 @@ dma_rxfill(dma_info_t *di)
 	DMA_TRACE(("%s: dma_rxfill: post %d\n", di->name, n));
 
 	for (i = 0; i < n; i++) {
-		if ((p = PKTGET(di->drv, rxbufsize, FALSE)) == NULL) {
+		if (di->nrxpool > 0)
+			p = di->rxpool[--di->nrxpool];
+		else if ((p = PKTGET(di->drv, rxbufsize, FALSE)) == NULL) {
 			DMA_ERROR(("%s: dma_rxfill: out of rxbufs\n", di->name));
 			di->hnddma.rxnobuf++;
 			break;
@@ -662,6 +654,22 @@ dma_rxreclaim(dma_info_t *di)
 	DMA_TRACE(("%s: dma_rxreclaim\n", di->name));
 
 	while ((p = dma_getnextrxp(di, TRUE)))
+		dma_rxrecycle(di, p);
+}
+
+/*
+ * Take back a receive buffer instead of freeing it, e.g. a frame the
+ * driver dropped or copied. dma_rxfill() posts it again before it
+ * allocates new ones. Buffers still referenced elsewhere and those not
+ * fitting into the pool are freed. Must be serialized with dma_rx()
+ * and dma_rxfill() like they are among each other.
+ */
+void
+dma_rxrecycle(dma_info_t *di, void *p)
+{
+	if ((di->nrxpool < di->nrxd) && PKTRECYCLE(di->drv, p, di->rxbufsize))
+		di->rxpool[di->nrxpool++] = p;
+	else
 		PKTFREE(di->drv, p, FALSE);
 }
 
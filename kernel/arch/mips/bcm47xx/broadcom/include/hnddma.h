@@ -163,11 +163,13 @@ extern bool dma_txstopped(di_t *di);
 extern bool dma_rxstopped(di_t *di);
 extern int dma_txfast(di_t *di, void *p, uint32 coreflags);
 extern int dma_tx(di_t *di, void *p, uint32 coreflags);
+extern int dma_txfast_bulk(di_t *di, void **pkts, uint n, uint32 coreflags);
 extern void dma_fifoloopbackenable(di_t *di);
 extern void *dma_rx(di_t *di);
 extern void dma_rxfill(di_t *di);
 extern void dma_txreclaim(di_t *di, bool forceall);
 extern void dma_rxreclaim(di_t *di);
+extern void dma_rxrecycle(di_t *di, void *p);
 extern char *dma_dump(di_t *di, char *buf);
 extern char *dma_dumptx(di_t *di, char *buf);
 extern char *dma_dumprx(di_t *di, char *buf);
@@ -56,9 +56,35 @@ extern void osl_pci_write_config(void *loc, uint offset, uint size, uint val);
 #include <linux/kernel.h>
 #include <linux/string.h>
 
+/*
+ * Register access counters, one per R_REG/W_REG expansion. Sites
+ * register themselves with their first access. The counters are
+ * not atomic, they are statistics only.
+ */
+#ifdef CONFIG_BCM47XX_MMIO_STATS
+typedef struct osl_mmio_site {
+	const char		*file;
+	uint			line;
+	uint			reads;
+	uint			writes;
+	bool			registered;
+	struct osl_mmio_site	*next;
+} osl_mmio_site_t;
+extern void osl_mmio_register(osl_mmio_site_t *site);
+#define OSL_MMIO_COUNT(counter) do { \
+	static osl_mmio_site_t __osl_site = { __FILE__, __LINE__ }; \
+	if (!__osl_site.registered) \
+		osl_mmio_register(&__osl_site); \
+	__osl_site.counter++; \
+} while (0)
+#else
+#define OSL_MMIO_COUNT(counter)	do {} while (0)
+#endif
+
 /* register access macros */
 #define R_REG(r) ({ \
 	__typeof(*(r)) __osl_v; \
+	OSL_MMIO_COUNT(reads); \
 	switch (sizeof(*(r))) { \
 	case sizeof(uint8):	__osl_v = readb((volatile uint8*)(r)); break; \
 	case sizeof(uint16):	__osl_v = readw((volatile uint16*)(r)); break; \
@@ -67,6 +93,7 @@ extern void osl_pci_write_config(void *loc, uint offset, uint size, uint val);
 	__osl_v; \
 })
 #define W_REG(r, v) do { \
+	OSL_MMIO_COUNT(writes); \
 	switch (sizeof(*(r))) { \
 	case sizeof(uint8):	writeb((uint8)(v), (volatile uint8*)(r)); break; \
 	case sizeof(uint16):	writew((uint16)(v), (volatile uint16*)(r)); break; \
@@ -150,6 +177,7 @@ extern void osl_pci_write_config(void *loc, uint offset, uint size, uint val);
 /* packet primitives */
 #define	PKTGET(drv, len, send)		osl_pktget((drv), (len), (send))
 #define	PKTFREE(drv, skb, send)		osl_pktfree((skb))
+#define	PKTRECYCLE(drv, skb, len)	osl_pktrecycle((skb), (len))
 #define	PKTDATA(drv, skb)		(((struct sk_buff*)(skb))->data)
 #define	PKTLEN(drv, skb)		(((struct sk_buff*)(skb))->len)
 #define PKTHEADROOM(drv, skb)		(PKTDATA(drv,skb)-(((struct sk_buff*)(skb))->head))
@@ -166,6 +194,7 @@ extern void osl_pci_write_config(void *loc, uint offset, uint size, uint val);
 #define	PKTSETLINK(skb, x)		(((struct sk_buff*)(skb))->prev = (struct sk_buff*)(x))
 extern void *osl_pktget(void *drv, uint len, bool send);
 extern void osl_pktfree(void *skb);
+extern bool osl_pktrecycle(void *skb, uint len);
 
 #else	/* BINOSL */                                    
 
@@ -281,6 +310,7 @@ extern void osl_delay(uint usec);
 /* packet primitives */
 #define	PKTGET(drv, len, send)		osl_pktget((drv), (len), (send))
 #define	PKTFREE(drv, skb, send)		osl_pktfree((skb))
+#define	PKTRECYCLE(drv, skb, len)	osl_pktrecycle((skb), (len))
 #define	PKTDATA(drv, skb)		osl_pktdata((drv), (skb))
 #define	PKTLEN(drv, skb)		osl_pktlen((drv), (skb))
 #define	PKTNEXT(drv, skb)		osl_pktnext((drv), (skb))
@@ -295,6 +325,7 @@ extern void osl_delay(uint usec);
 #define	PKTSETLINK(skb, x)		osl_pktsetlink((skb), (x))
 extern void *osl_pktget(void *drv, uint len, bool send);
 extern void osl_pktfree(void *skb);
+extern bool osl_pktrecycle(void *skb, uint len);
 extern uchar *osl_pktdata(void *drv, void *skb);
 extern uint osl_pktlen(void *drv, void *skb);
 extern void *osl_pktnext(void *drv, void *skb);
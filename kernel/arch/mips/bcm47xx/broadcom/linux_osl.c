@@ -24,6 +24,11 @@
 #include <asm/paccess.h>
 #endif
 #include <pcicfg.h>
+#ifdef CONFIG_BCM47XX_MMIO_STATS
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#endif
 
 #define PCI_CFG_RETRY 10	
 
@@ -65,6 +70,40 @@ osl_pktfree(void *p)
 	}
 }
 
+/*
+ * Rx buffers come from dev_alloc_skb(), whose headroom is part of the
+ * buffer. Only skbs nobody else can see anymore are reset for reuse.
+ */
+#define	PKTRECYCLE_HEADROOM	16
+
+bool
+osl_pktrecycle(void *p, uint len)
+{
+	struct sk_buff *skb;
+
+	skb = (struct sk_buff*) p;
+
+	if (skb->next || skb->list || skb->sk || skb->dst || skb->destructor ||
+	    skb_cloned(skb) || skb_is_nonlinear(skb) || (atomic_read(&skb->users) != 1))
+		return (FALSE);
+#ifdef CONFIG_NETFILTER
+	if (skb->nfct)
+		return (FALSE);
+#endif
+
+	if ((uint)(skb->end - skb->head) < (PKTRECYCLE_HEADROOM + len))
+		return (FALSE);
+
+	skb->data = skb->tail = skb->head + PKTRECYCLE_HEADROOM;
+	skb->len = 0;
+	skb_put(skb, len);
+
+	/* ensure the cookie field is cleared */
+	PKTSETCOOKIE(skb, NULL);
+
+	return (TRUE);
+}
+
 uint32
 osl_pci_read_config(void *loc, uint offset, uint size)
 {
@@ -128,6 +167,80 @@ osl_assert(char *exp, char *file, int line)
 	panic(tempbuf);
 }
 
+/* only the inline register accessors count */
+#if defined(CONFIG_BCM47XX_MMIO_STATS) && !defined(BINOSL)
+
+static osl_mmio_site_t *osl_mmio_sites = NULL;
+static spinlock_t osl_mmio_lock = SPIN_LOCK_UNLOCKED;
+
+void
+osl_mmio_register(osl_mmio_site_t *site)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&osl_mmio_lock, flags);
+	if (!site->registered) {
+		site->next = osl_mmio_sites;
+		osl_mmio_sites = site;
+		site->registered = TRUE;
+	}
+	spin_unlock_irqrestore(&osl_mmio_lock, flags);
+}
+
+static int
+osl_mmio_show(struct seq_file *m, void *v)
+{
+	osl_mmio_site_t *site;
+
+	seq_printf(m, "%10s %10s  site\n", "reads", "writes");
+	for (site = osl_mmio_sites; site; site = site->next)
+		seq_printf(m, "%10u %10u  %s:%u\n", site->reads, site->writes, site->file, site->line);
+
+	return (0);
+}
+
+static int
+osl_mmio_open(struct inode *inode, struct file *file)
+{
+	return (single_open(file, osl_mmio_show, NULL));
+}
+
+/* any write clears the counters */
+static ssize_t
+osl_mmio_write(struct file *file, const char *buf, size_t count, loff_t *ppos)
+{
+	osl_mmio_site_t *site;
+
+	for (site = osl_mmio_sites; site; site = site->next)
+		site->reads = site->writes = 0;
+
+	return (count);
+}
+
+static struct file_operations osl_mmio_fops = {
+	.open		= osl_mmio_open,
+	.read		= seq_read,
+	.write		= osl_mmio_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init
+osl_mmio_init(void)
+{
+	struct proc_dir_entry *entry;
+
+	if ((entry = create_proc_entry("osl_mmio", S_IRUGO | S_IWUSR, NULL)) == NULL)
+		return (-ENOMEM);
+	entry->proc_fops = &osl_mmio_fops;
+
+	return (0);
+}
+
+module_init(osl_mmio_init);
+
+#endif	/* CONFIG_BCM47XX_MMIO_STATS && !BINOSL */
+
 /*
  * BINOSL selects the slightly slower function-call-based binary compatible osl.
  */
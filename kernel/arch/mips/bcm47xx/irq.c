@@ -13,6 +13,9 @@
 #include <asm/irq_cpu.h>
 
 extern asmlinkage void bcm47xx_irq_handler(void);
+#ifdef CONFIG_NO_IDLE_HZ
+extern void bcm47xx_start_hz_timer(void);
+#endif
 
 void bcm47xx_irq_dispatch(struct pt_regs *regs)
 {
@@ -26,6 +29,11 @@ void bcm47xx_irq_dispatch(struct pt_regs *regs)
 	clear_c0_status(cause);
 #endif
 
+#ifdef CONFIG_NO_IDLE_HZ
+	/* The tick may be stopped in idle, see bcm47xx_idle() */
+	bcm47xx_start_hz_timer();
+#endif
+
 	if (cause & CAUSEF_IP7)
 		do_IRQ(7, regs);
 	if (cause & CAUSEF_IP2)
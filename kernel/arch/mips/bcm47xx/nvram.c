@@ -0,0 +1,775 @@
+/*
+ * NVRAM variable access for BCM47xx boards
+ *
+ * The CFE keeps the board settings as a list of name=value strings in
+ * the last NVRAM_SPACE bytes of the "nvram" flash partition. The image
+ * is copied to RAM before the backplane is attached so that the SB
+ * utilities can query it, indexed in a hash table once the allocator
+ * is up and only written back to flash on nvram_commit().
+ */
+
+#include <linux/config.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/miscdevice.h>
+#include <linux/wait.h>
+#include <linux/sched.h>
+#include <linux/mtd/mtd.h>
+#include <asm/addrspace.h>
+#include <asm/io.h>
+#include <asm/uaccess.h>
+#include <asm/cacheflush.h>
+#include <asm/semaphore.h>
+
+#include <typedefs.h>
+#include <bcmendian.h>
+#include <bcmnvram.h>
+#include <bcmutils.h>
+
+/* Flash window, see drivers/mtd/maps/bcm47xx-flash.c */
+#define NVRAM_FLASH_BASE	0x1c000000
+#define NVRAM_FLASH_MIN		(128 * 1024)
+#define NVRAM_FLASH_MAX		(8 * 1024 * 1024)
+
+/* CRC covers everything after the crc byte of the header */
+#define NVRAM_CRC_START		9
+
+#define NVRAM_HASH_SIZE		257
+
+/*
+ * Header and strings as found in flash. nvram_set() overwrites a value
+ * in place when the new one fits and appends it after the strings
+ * otherwise, compacting the buffer first when it is full. The buffer is
+ * mapped read-only into userspace, which learns value offsets from
+ * read() on /dev/nvram.
+ */
+static char nvram_buf[PAGE_ALIGN(NVRAM_SPACE)] __attribute__((aligned(PAGE_SIZE)));
+static unsigned int nvram_offset;
+
+/* Scratch image for compacting nvram_buf, guarded by nvram_lock */
+static char nvram_compact_buf[NVRAM_SPACE];
+
+static struct nvram_tuple *nvram_hash[NVRAM_HASH_SIZE];
+static int nvram_hashed;
+static int nvram_dirty;
+
+/* nvram_lock guards the buffer and hash, nvram_sem serializes commits */
+static spinlock_t nvram_lock = SPIN_LOCK_UNLOCKED;
+static DECLARE_MUTEX(nvram_sem);
+
+static unsigned int nvram_rebuild(char *image);
+
+static unsigned int
+nvram_hash_name(const char *name)
+{
+	unsigned int hash = 0;
+
+	while (*name)
+		hash = 31 * hash + *name++;
+
+	return hash % NVRAM_HASH_SIZE;
+}
+
+static uint8
+nvram_calc_crc(struct nvram_header *header)
+{
+	struct nvram_header tmp;
+	uint8 crc;
+
+	/* Little-endian CRC8 over the last 11 bytes of the header */
+	tmp.crc_ver_init = htol32(ltoh32(header->crc_ver_init) & ~0xff);
+	tmp.config_refresh = htol32(ltoh32(header->config_refresh));
+	tmp.config_ncdl = htol32(ltoh32(header->config_ncdl));
+	crc = crc8((uint8 *) &tmp + NVRAM_CRC_START,
+		   NVRAM_HEADER_SIZE - NVRAM_CRC_START, CRC8_INIT_VALUE);
+
+	/* Continue CRC8 over data bytes */
+	return crc8((uint8 *) &header[1],
+		    ltoh32(header->len) - NVRAM_HEADER_SIZE, crc);
+}
+
+static int
+nvram_valid(struct nvram_header *header)
+{
+	uint32 len = ltoh32(header->len);
+
+	if (ltoh32(header->magic) != NVRAM_MAGIC)
+		return 0;
+	if (len < NVRAM_HEADER_SIZE || len > NVRAM_SPACE)
+		return 0;
+
+	return nvram_calc_crc(header) == (uint8) ltoh32(header->crc_ver_init);
+}
+
+/*
+ * Copy the image out of flash. Runs from the early initcall, before the
+ * allocator and MTD are available, so the flash is read through KSEG1.
+ */
+void __init
+early_nvram_init(void)
+{
+	struct nvram_header *header;
+	unsigned long off;
+
+	for (off = NVRAM_FLASH_MIN; off <= NVRAM_FLASH_MAX; off <<= 1) {
+		header = (struct nvram_header *)
+			KSEG1ADDR(NVRAM_FLASH_BASE + off - NVRAM_SPACE);
+		if (ltoh32(header->magic) == NVRAM_MAGIC)
+			break;
+	}
+
+	if (off > NVRAM_FLASH_MAX || !nvram_valid(header)) {
+		printk(KERN_ERR "nvram: no valid image found in flash\n");
+		return;
+	}
+
+	nvram_offset = ltoh32(header->len);
+	memcpy(nvram_buf, header, nvram_offset);
+}
+
+/* Linear search of the raw image, used until the hash is built */
+static char *
+early_nvram_get(const char *name)
+{
+	char *var, *end;
+	int len;
+
+	if (!nvram_offset)
+		return NULL;
+
+	len = strlen(name);
+	end = &nvram_buf[nvram_offset];
+	for (var = &nvram_buf[NVRAM_HEADER_SIZE]; var < end && *var; var += strlen(var) + 1) {
+		if (!strncmp(var, name, len) && var[len] == '=')
+			return &var[len + 1];
+	}
+
+	return NULL;
+}
+
+static struct nvram_tuple *
+nvram_find(const char *name, struct nvram_tuple ***prev)
+{
+	struct nvram_tuple **p, *t;
+
+	for (p = &nvram_hash[nvram_hash_name(name)]; (t = *p); p = &t->next) {
+		if (!strcmp(t->name, name))
+			break;
+	}
+
+	if (prev)
+		*prev = p;
+
+	return t;
+}
+
+/* Split the name=value string at *var in place and step past it */
+static char *
+nvram_split(char **var, char **value)
+{
+	char *name = *var, *eq;
+
+	if (!(eq = strchr(name, '=')))
+		return NULL;
+	*eq++ = '\0';
+	*value = eq;
+	*var = eq + strlen(eq) + 1;
+
+	return name;
+}
+
+/*
+ * Index the name=value strings between var and end. Tuples for new
+ * names are taken from pool; after a commit the strings are laid out
+ * in nvram_hash order and the existing tuples are simply repointed.
+ */
+static void
+nvram_index(char *var, char *end, struct nvram_tuple **pool)
+{
+	struct nvram_tuple *t, **p;
+	char *name, *value;
+	int i;
+
+	if (nvram_hashed) {
+		for (i = 0; i < NVRAM_HASH_SIZE; i++) {
+			for (t = nvram_hash[i]; t; t = t->next)
+				t->name = nvram_split(&var, &t->value);
+		}
+		return;
+	}
+
+	while (var < end && *var && (name = nvram_split(&var, &value))) {
+		/* First definition wins, as with early_nvram_get() */
+		if (nvram_find(name, &p) || !*pool)
+			continue;
+		t = *pool;
+		*pool = t->next;
+		t->name = name;
+		t->value = value;
+		t->next = NULL;
+		*p = t;
+	}
+}
+
+char *
+nvram_get(const char *name)
+{
+	struct nvram_tuple *t;
+	unsigned long flags;
+	char *value;
+
+	if (!name)
+		return NULL;
+
+	spin_lock_irqsave(&nvram_lock, flags);
+	if (nvram_hashed)
+		value = (t = nvram_find(name, NULL)) ? t->value : NULL;
+	else
+		value = early_nvram_get(name);
+	spin_unlock_irqrestore(&nvram_lock, flags);
+
+	return value;
+}
+
+int
+nvram_set(const char *name, const char *value)
+{
+	struct nvram_tuple *t, **p, *new = NULL;
+	unsigned long flags;
+	int nlen, vlen, olen;
+	char *var;
+
+	nlen = strlen(name);
+	vlen = strlen(value);
+	if (!nlen || strchr(name, '='))
+		return -EINVAL;
+
+	/* Allocate outside the lock in case the name is new */
+	if (!(new = kmalloc(sizeof(struct nvram_tuple), GFP_ATOMIC)))
+		return -ENOMEM;
+
+	spin_lock_irqsave(&nvram_lock, flags);
+
+	if (!nvram_hashed) {
+		spin_unlock_irqrestore(&nvram_lock, flags);
+		kfree(new);
+		return -EBUSY;
+	}
+
+	t = nvram_find(name, &p);
+	if (t && !strcmp(t->value, value)) {
+		spin_unlock_irqrestore(&nvram_lock, flags);
+		kfree(new);
+		return 0;
+	}
+
+	/* A value that fits in the old one's place is overwritten there */
+	if (t && (olen = strlen(t->value)) >= vlen) {
+		memcpy(t->value, value, vlen + 1);
+		memset(t->value + vlen, 0, olen - vlen);
+		goto done;
+	}
+
+	/*
+	 * Otherwise name and value are appended. When the buffer is full,
+	 * the RAM copy is compacted first, without the old value. Flash is
+	 * only written by nvram_commit().
+	 */
+	if (nvram_offset + nlen + vlen + 2 > NVRAM_SPACE) {
+		if (t)
+			*p = t->next;
+		nvram_rebuild(nvram_compact_buf);
+		if (t) {
+			t->next = *p;
+			*p = t;
+		}
+	}
+	if (nvram_offset + nlen + vlen + 2 > NVRAM_SPACE) {
+		spin_unlock_irqrestore(&nvram_lock, flags);
+		flush_cache_all();
+		kfree(new);
+		return -ENOMEM;
+	}
+	var = &nvram_buf[nvram_offset];
+	memcpy(var, name, nlen + 1);
+	memcpy(var + nlen + 1, value, vlen + 1);
+	nvram_offset += nlen + vlen + 2;
+
+	if (!t) {
+		t = new;
+		new = NULL;
+		t->next = NULL;
+		*p = t;
+	}
+	t->name = var;
+	t->value = var + nlen + 1;
+done:
+	nvram_dirty = 1;
+
+	spin_unlock_irqrestore(&nvram_lock, flags);
+
+	/* Userspace maps the buffer at a different virtual address */
+	flush_cache_all();
+
+	if (new)
+		kfree(new);
+	return 0;
+}
+
+int
+nvram_unset(const char *name)
+{
+	struct nvram_tuple *t, **p;
+	unsigned long flags;
+
+	spin_lock_irqsave(&nvram_lock, flags);
+	if ((t = nvram_find(name, &p))) {
+		*p = t->next;
+		nvram_dirty = 1;
+	}
+	spin_unlock_irqrestore(&nvram_lock, flags);
+
+	if (t)
+		kfree(t);
+	return 0;
+}
+
+int
+nvram_getall(char *buf, int count)
+{
+	struct nvram_tuple *t;
+	unsigned long flags;
+	int i, len = 0, nlen, vlen;
+	int ret = 0;
+
+	spin_lock_irqsave(&nvram_lock, flags);
+	for (i = 0; i < NVRAM_HASH_SIZE; i++) {
+		for (t = nvram_hash[i]; t; t = t->next) {
+			nlen = strlen(t->name);
+			vlen = strlen(t->value);
+			if (len + nlen + vlen + 3 > count) {
+				ret = -ENOMEM;
+				goto out;
+			}
+			memcpy(&buf[len], t->name, nlen);
+			buf[len + nlen] = '=';
+			memcpy(&buf[len + nlen + 1], t->value, vlen + 1);
+			len += nlen + vlen + 2;
+		}
+	}
+	buf[len] = '\0';
+out:
+	spin_unlock_irqrestore(&nvram_lock, flags);
+	return ret;
+}
+
+/*
+ * Lay the variables out in hash order behind a fresh header. Returns
+ * the image length, or 0 if it does not fit in NVRAM_SPACE.
+ */
+static unsigned int
+nvram_build(char *image)
+{
+	struct nvram_header *header = (struct nvram_header *) image;
+	struct nvram_header *old = (struct nvram_header *) nvram_buf;
+	struct nvram_tuple *t;
+	unsigned int len = NVRAM_HEADER_SIZE;
+	int i, nlen, vlen;
+
+	for (i = 0; i < NVRAM_HASH_SIZE; i++) {
+		for (t = nvram_hash[i]; t; t = t->next) {
+			nlen = strlen(t->name);
+			vlen = strlen(t->value);
+			if (len + nlen + vlen + 3 > NVRAM_SPACE)
+				return 0;
+			memcpy(&image[len], t->name, nlen);
+			image[len + nlen] = '=';
+			memcpy(&image[len + nlen + 1], t->value, vlen + 1);
+			len += nlen + vlen + 2;
+		}
+	}
+	image[len++] = '\0';
+	while (len & 3)
+		image[len++] = '\0';
+
+	/* Keep the memory controller settings the CFE put there */
+	header->magic = htol32(NVRAM_MAGIC);
+	header->len = htol32(len);
+	header->crc_ver_init = htol32((ltoh32(old->crc_ver_init) & ~0xffff) |
+				      (NVRAM_VERSION << 8));
+	header->config_refresh = old->config_refresh;
+	header->config_ncdl = old->config_ncdl;
+	header->crc_ver_init = htol32(ltoh32(header->crc_ver_init) |
+				      nvram_calc_crc(header));
+
+	return len;
+}
+
+/*
+ * Replace nvram_buf with the compacted image built in the scratch
+ * buffer and repoint the tuples into it. Called with nvram_lock held;
+ * returns the new length, or 0 if the variables do not fit.
+ */
+static unsigned int
+nvram_rebuild(char *image)
+{
+	unsigned int len;
+
+	if (!(len = nvram_build(image)))
+		return 0;
+	memcpy(nvram_buf, image, len);
+	memset(&nvram_buf[len], 0, NVRAM_SPACE - len);
+	nvram_offset = len;
+	nvram_index(&nvram_buf[NVRAM_HEADER_SIZE], &nvram_buf[len], NULL);
+
+	return len;
+}
+
+static struct mtd_info *
+nvram_mtd(void)
+{
+	struct mtd_info *mtd;
+	int i;
+
+	for (i = 0; i < MAX_MTD_DEVICES; i++) {
+		if (!(mtd = get_mtd_device(NULL, i)))
+			continue;
+		if (!strcmp(mtd->name, "nvram"))
+			return mtd;
+		put_mtd_device(mtd);
+	}
+
+	return NULL;
+}
+
+static void
+nvram_erase_callback(struct erase_info *done)
+{
+	wake_up((wait_queue_head_t *) done->priv);
+}
+
+/* Replace the tail of the partition's last erase block with image */
+static int
+nvram_write_flash(struct mtd_info *mtd, char *image, unsigned int len)
+{
+	DECLARE_WAITQUEUE(wait, current);
+	wait_queue_head_t wait_q;
+	struct erase_info erase;
+	unsigned int block, off;
+	size_t done;
+	u_char *buf;
+	int ret;
+
+	block = (mtd->size - NVRAM_SPACE) & ~(mtd->erasesize - 1);
+	off = mtd->size - NVRAM_SPACE - block;
+
+	if (!(buf = vmalloc(mtd->erasesize)))
+		return -ENOMEM;
+
+	/* Preserve whatever shares the erase block with the variables */
+	ret = MTD_READ(mtd, block, mtd->erasesize, &done, buf);
+	if (ret || done != mtd->erasesize) {
+		ret = ret ? : -EIO;
+		goto out;
+	}
+	memcpy(&buf[off], image, len);
+	memset(&buf[off + len], 0xff, NVRAM_SPACE - len);
+
+	init_waitqueue_head(&wait_q);
+	memset(&erase, 0, sizeof(erase));
+	erase.mtd = mtd;
+	erase.addr = block;
+	erase.len = mtd->erasesize;
+	erase.callback = nvram_erase_callback;
+	erase.priv = (u_long) &wait_q;
+
+	set_current_state(TASK_INTERRUPTIBLE);
+	add_wait_queue(&wait_q, &wait);
+	if ((ret = MTD_ERASE(mtd, &erase))) {
+		set_current_state(TASK_RUNNING);
+		remove_wait_queue(&wait_q, &wait);
+		goto out;
+	}
+	/* Erase is complete once state says so; the callback only wakes us */
+	while (erase.state != MTD_ERASE_DONE && erase.state != MTD_ERASE_FAILED) {
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	set_current_state(TASK_RUNNING);
+	remove_wait_queue(&wait_q, &wait);
+	if (erase.state == MTD_ERASE_FAILED) {
+		ret = -EIO;
+		goto out;
+	}
+
+	ret = MTD_WRITE(mtd, block, mtd->erasesize, &done, buf);
+	if (!ret && done != mtd->erasesize)
+		ret = -EIO;
+
+out:
+	vfree(buf);
+	return ret;
+}
+
+/*
+ * Write all pending changes with a single erase and program of the
+ * nvram sector. The RAM copy is compacted as a side effect.
+ */
+int
+nvram_commit(void)
+{
+	struct mtd_info *mtd;
+	unsigned long flags;
+	unsigned int len;
+	char *image;
+	int ret;
+
+	if (!(image = kmalloc(NVRAM_SPACE, GFP_KERNEL)))
+		return -ENOMEM;
+
+	down(&nvram_sem);
+
+	spin_lock_irqsave(&nvram_lock, flags);
+	if (!nvram_dirty) {
+		spin_unlock_irqrestore(&nvram_lock, flags);
+		ret = 0;
+		goto out;
+	}
+	if (!(len = nvram_rebuild(image))) {
+		spin_unlock_irqrestore(&nvram_lock, flags);
+		ret = -ENOSPC;
+		goto out;
+	}
+	nvram_dirty = 0;
+	spin_unlock_irqrestore(&nvram_lock, flags);
+
+	flush_cache_all();
+
+	if (!(mtd = nvram_mtd())) {
+		ret = -ENODEV;
+	} else {
+		ret = nvram_write_flash(mtd, image, len);
+		put_mtd_device(mtd);
+	}
+
+	if (ret) {
+		printk(KERN_ERR "nvram: commit failed (%d)\n", ret);
+		spin_lock_irqsave(&nvram_lock, flags);
+		nvram_dirty = 1;
+		spin_unlock_irqrestore(&nvram_lock, flags);
+	}
+
+out:
+	up(&nvram_sem);
+	kfree(image);
+	return ret;
+}
+
+int
+nvram_init(void *sbh)
+{
+	struct nvram_tuple *pool = NULL, *t;
+	unsigned long flags;
+	char *var;
+	int ret = 0;
+
+	/*
+	 * nvram_set() refuses to run until the hash exists, so the image
+	 * can be walked unlocked to preallocate one tuple per variable.
+	 */
+	for (var = &nvram_buf[NVRAM_HEADER_SIZE];
+	     var < &nvram_buf[nvram_offset] && *var; var += strlen(var) + 1) {
+		if (!(t = kmalloc(sizeof(struct nvram_tuple), GFP_KERNEL))) {
+			ret = -ENOMEM;
+			break;
+		}
+		t->next = pool;
+		pool = t;
+	}
+
+	/* Names are split from values in place, so nothing is copied */
+	spin_lock_irqsave(&nvram_lock, flags);
+	if (!nvram_hashed && !ret && nvram_offset)
+		nvram_index(&nvram_buf[NVRAM_HEADER_SIZE],
+			    &nvram_buf[nvram_offset], &pool);
+	nvram_hashed = 1;
+	spin_unlock_irqrestore(&nvram_lock, flags);
+
+	/* Left over from duplicate names or a failed allocation */
+	while ((t = pool)) {
+		pool = t->next;
+		kfree(t);
+	}
+
+	return ret;
+}
+
+void
+nvram_exit(void)
+{
+	struct nvram_tuple *t, *next;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&nvram_lock, flags);
+	for (i = 0; i < NVRAM_HASH_SIZE; i++) {
+		for (t = nvram_hash[i]; t; t = next) {
+			next = t->next;
+			kfree(t);
+		}
+		nvram_hash[i] = NULL;
+	}
+	nvram_hashed = 0;
+	spin_unlock_irqrestore(&nvram_lock, flags);
+}
+
+/*
+ * /dev/nvram: read() with a name in the buffer returns the offset of
+ * its value in the mmap()ed image (or all variables for an empty name),
+ * write() takes "name=value" or "name" to unset, and the NVRAM_MAGIC
+ * ioctl commits.
+ */
+static ssize_t
+dev_nvram_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+	char tmp[100], *name = tmp, *value;
+	unsigned long off;
+	ssize_t ret;
+
+	if (!count)
+		return 0;
+	if (count > sizeof(tmp) && !(name = kmalloc(count, GFP_KERNEL)))
+		return -ENOMEM;
+
+	if (copy_from_user(name, buf, count)) {
+		ret = -EFAULT;
+		goto done;
+	}
+	name[count - 1] = '\0';
+
+	if (*name == '\0') {
+		if ((ret = nvram_getall(name, count)) == 0)
+			ret = copy_to_user(buf, name, count) ? -EFAULT : count;
+	} else if ((value = nvram_get(name))) {
+		off = (unsigned long) value - (unsigned long) nvram_buf;
+		ret = put_user(off, (unsigned long __user *) buf) ? -EFAULT :
+			sizeof(unsigned long);
+	} else
+		ret = 0;
+
+done:
+	if (name != tmp)
+		kfree(name);
+	return ret;
+}
+
+static ssize_t
+dev_nvram_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+	char tmp[100], *name = tmp, *value;
+	ssize_t ret;
+
+	if (!count)
+		return 0;
+	if (count >= sizeof(tmp) && !(name = kmalloc(count + 1, GFP_KERNEL)))
+		return -ENOMEM;
+
+	if (copy_from_user(name, buf, count)) {
+		ret = -EFAULT;
+		goto done;
+	}
+	name[count] = '\0';
+
+	value = name;
+	strsep(&value, "=");
+	if (value)
+		ret = nvram_set(name, value);
+	else
+		ret = nvram_unset(name);
+	if (!ret)
+		ret = count;
+
+done:
+	if (name != tmp)
+		kfree(name);
+	return ret;
+}
+
+static int
+dev_nvram_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
+{
+	if (cmd != NVRAM_MAGIC)
+		return -EINVAL;
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	return nvram_commit();
+}
+
+static int
+dev_nvram_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	/*
+	 * The image is only ever changed through write(). Dropping
+	 * VM_MAYWRITE keeps mprotect() from making the mapping writable
+	 * later on.
+	 */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	if (vma->vm_pgoff || size > sizeof(nvram_buf))
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_RESERVED;
+	if (remap_page_range(vma, vma->vm_start, virt_to_phys(nvram_buf),
+			     size, vma->vm_page_prot))
+		return -EAGAIN;
+
+	return 0;
+}
+
+static struct file_operations dev_nvram_fops = {
+	.owner		= THIS_MODULE,
+	.read		= dev_nvram_read,
+	.write		= dev_nvram_write,
+	.ioctl		= dev_nvram_ioctl,
+	.mmap		= dev_nvram_mmap,
+};
+
+static struct miscdevice dev_nvram = {
+	.minor		= NVRAM_MINOR,
+	.name		= "nvram",
+	.fops		= &dev_nvram_fops,
+};
+
+static int __init
+dev_nvram_init(void)
+{
+	int ret;
+
+	if ((ret = nvram_init(NULL))) {
+		printk(KERN_ERR "nvram: out of memory building hash\n");
+		return ret;
+	}
+
+	if ((ret = misc_register(&dev_nvram)))
+		printk(KERN_ERR "nvram: can't register minor %d\n", NVRAM_MINOR);
+
+	return ret;
+}
+
+__initcall(dev_nvram_init);
+
+EXPORT_SYMBOL(nvram_get);
+EXPORT_SYMBOL(nvram_set);
+EXPORT_SYMBOL(nvram_unset);
+EXPORT_SYMBOL(nvram_getall);
+EXPORT_SYMBOL(nvram_commit);
@@ -61,11 +61,7 @@ serial_add(void *regs, uint irq, uint baud_base, uint reg_shift)
 
 extern void bcm47xx_time_init(void);
 extern void bcm47xx_timer_setup(struct irqaction *irq);
-
-void *nvram_get(char *foo)
-{
-	return NULL;
-}
+extern void early_nvram_init(void);
 
 void *sbh;
 
@@ -87,6 +83,9 @@ static void bcm47xx_machine_halt(void)
 
 static int __init bcm47xx_init(void)
 {
+	/* The SB utilities query board settings while attaching */
+	early_nvram_init();
+
 	sbh = sb_kattach();
 	sb_mips_init(sbh);
 	sbpci_init(sbh);
@@ -4,28 +4,169 @@
 #include <linux/sched.h>
 #include <linux/serial_reg.h>
 #include <linux/interrupt.h>
+#include <linux/timer.h>
+#include <linux/rcupdate.h>
 #include <asm/addrspace.h>
 #include <asm/io.h>
+#include <asm/processor.h>
 #include <asm/time.h>
 
-//#include <typedefs.h>
-//#include <bcmnvram.h>
+#include <typedefs.h>
+#include <bcmnvram.h>
 //#include <sbconfig.h>
 //#include <sbextif.h>
-//#include <sbutils.h>
+#include <sbutils.h>
+#include <sbmips.h>
 
-/* Global SB handle */
-//extern void *bcm947xx_sbh;
+/* Global SB handle, see setup.c */
+extern void *sbh;
 //extern spinlock_t bcm947xx_sbh_lock;
 
 /* Convenience */
-//#define sbh bcm947xx_sbh
 //#define sbh_lock bcm947xx_sbh_lock
 
-//extern int panic_timeout;
-//static int watchdog = 0;
+extern int panic_timeout;
+static int watchdog = 0;
 //static u8 *mcr = NULL;
 
+/* Counter cycles per jiffy and the count at which the next jiffy starts */
+static unsigned int cycles_per_jiffy;
+static unsigned int next_tick;
+
+#ifdef CONFIG_NO_IDLE_HZ
+#ifdef CONFIG_NO_IDLE_HZ_INIT
+int sysctl_hz_timer = 0;
+#else
+int sysctl_hz_timer = 1;
+#endif
+
+/* Longest stop that keeps c0_compare within half a counter wrap */
+static unsigned long max_idle_ticks;
+
+static void (*bcm47xx_cpu_wait)(void);
+#endif
+
+static unsigned int
+bcm47xx_hpt_read(void)
+{
+	return read_c0_count();
+}
+
+static void
+bcm47xx_hpt_init(unsigned int count)
+{
+	/* Restart the counter and interrupt on the next jiffy boundary */
+	count = read_c0_count() - count;
+	next_tick = (count / cycles_per_jiffy + 1) * cycles_per_jiffy;
+	write_c0_compare(next_tick);
+	write_c0_count(count);
+}
+
+static void
+bcm47xx_timer_ack(void)
+{
+	next_tick += cycles_per_jiffy;
+	write_c0_compare(next_tick);
+}
+
+/*
+ * Account every jiffy boundary the counter has passed. That is more
+ * than one after a late interrupt or when the tick was stopped in idle;
+ * the generic c0 timer ack would drop those jiffies instead.
+ */
+static irqreturn_t
+bcm47xx_timer_interrupt(int irq, void *dev_id, struct pt_regs *regs)
+{
+	do
+		timer_interrupt(irq, dev_id, regs);
+	while ((int) (read_c0_count() - next_tick) >= 0);
+
+	return IRQ_HANDLED;
+}
+
+#ifdef CONFIG_NO_IDLE_HZ
+/*
+ * Restart the tick after it was stopped in idle. Runs with interrupts
+ * disabled on every interrupt, so whatever the interrupt queues is seen
+ * by the next tick. If jiffies were skipped, fire the timer interrupt
+ * right away to account them.
+ */
+void
+bcm47xx_start_hz_timer(void)
+{
+	unsigned int count;
+	int cpu = smp_processor_id();
+
+	if (!cpu_isset(cpu, nohz_cpu_mask))
+		return;
+
+	cpu_clear(cpu, nohz_cpu_mask);
+	if ((int) (read_c0_count() - next_tick) < 0)
+		write_c0_compare(next_tick);
+	else {
+		do {
+			count = read_c0_count() + 64;
+			write_c0_compare(count);
+		} while ((int) (read_c0_count() - count) >= 0);
+	}
+}
+
+/*
+ * Called from cpu_idle() in place of the CPU's wait routine. Unless a
+ * timer, softirq or RCU callback needs the next tick, c0_compare is
+ * pushed out to the jiffy of the next pending timer before waiting.
+ * An interrupt between here and the wait restarts the tick, so at worst
+ * the wait lasts until the next jiffy, as it does with the tick running.
+ */
+static void
+bcm47xx_idle(void)
+{
+	unsigned long ticks;
+	int cpu = smp_processor_id();
+
+	local_irq_disable();
+	if (!sysctl_hz_timer && !need_resched() &&
+	    !rcu_pending(cpu) && !local_softirq_pending() &&
+	    (int) (read_c0_count() - next_tick) < 0) {
+		ticks = next_timer_interrupt() - jiffies;
+		if (ticks > max_idle_ticks)
+			ticks = max_idle_ticks;
+		if (ticks > 1) {
+			cpu_set(cpu, nohz_cpu_mask);
+			write_c0_compare(next_tick + (ticks - 1) * cycles_per_jiffy);
+		}
+	}
+	local_irq_enable();
+
+	if (!need_resched())
+		bcm47xx_cpu_wait();
+
+	local_irq_disable();
+	bcm47xx_start_hz_timer();
+	local_irq_enable();
+}
+
+/*
+ * cpu_wait is only known after check_bugs(), which runs long after the
+ * timer is set up. Without a wait instruction the tick is left alone.
+ */
+static int __init
+bcm47xx_idle_init(void)
+{
+	if (!cpu_wait) {
+		printk(KERN_INFO "No wait instruction, HZ timer stays on in idle\n");
+		return 0;
+	}
+
+	bcm47xx_cpu_wait = cpu_wait;
+	cpu_wait = bcm47xx_idle;
+
+	return 0;
+}
+
+late_initcall(bcm47xx_idle_init);
+#endif
+
 void __init
 bcm47xx_time_init(void)
 {
@@ -39,17 +180,30 @@ bcm47xx_time_init(void)
 	write_c0_count(0);
 	write_c0_compare(0xffff);
 
-//	if (!(hz = sb_mips_clock(sbh)))
-//		hz = 100000000;
-	hz = 200 * 1000 * 1000;
+	/*
+	 * Prefer the PLL settings; CFE's "clkfreq" (MHz, optionally
+	 * followed by ",<sb MHz>") only covers cores sb_mips_clock()
+	 * does not know about.
+	 */
+	if (!(hz = sb_mips_clock(sbh)) &&
+	    !(hz = simple_strtoul(nvram_safe_get("clkfreq"), NULL, 0) * 1000 * 1000))
+		hz = 200 * 1000 * 1000;
 
-//	printk("CPU: BCM%04x rev %d at %d MHz\n", sb_chip(sbh), sb_chiprev(sbh),
-//	       (hz + 500000) / 1000000);
+	printk("CPU: BCM%04x rev %d at %d MHz\n", sb_chip(sbh), sb_chiprev(sbh),
+	       (hz + 500000) / 1000000);
 
 	/* Set MIPS counter frequency for fixed_rate_gettimeoffset() */
 	mips_hpt_frequency = hz / 2;
 
-#if 0
+	/* Drive the tick from c0_compare ourselves, see bcm47xx_timer_ack() */
+	cycles_per_jiffy = (mips_hpt_frequency + HZ / 2) / HZ;
+	mips_hpt_read = bcm47xx_hpt_read;
+	mips_hpt_init = bcm47xx_hpt_init;
+	mips_timer_ack = bcm47xx_timer_ack;
+#ifdef CONFIG_NO_IDLE_HZ
+	max_idle_ticks = 0x7fffffff / cycles_per_jiffy - 1;
+#endif
+
 	/* Set watchdog interval in ms */
 	watchdog = simple_strtoul(nvram_safe_get("watchdog"), NULL, 0);
 
@@ -57,6 +211,7 @@ bcm47xx_time_init(void)
 	panic_timeout = watchdog / 1000;
 	panic_timeout *= 10;
 
+#if 0
 	/* Setup blink */
 	if ((eir = sb_setcore(sbh, SB_EXTIF, 0))) {
 		sbconfig_t *sb = (sbconfig_t *)((unsigned int) eir + SBCONFIGOFF);
@@ -69,6 +224,8 @@ bcm47xx_time_init(void)
 void __init
 bcm47xx_timer_setup(struct irqaction *irq)
 {
+	irq->handler = bcm47xx_timer_interrupt;
+
 	/* Enable the timer interrupt */
 	setup_irq(7, irq);
 }
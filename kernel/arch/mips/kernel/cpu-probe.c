@@ -105,6 +105,8 @@ static inline void check_wait(void)
 /*	case CPU_20KC:*/
 	case CPU_24K:
 	case CPU_25KF:
+	case CPU_BCM3302:
+	case CPU_BCM4710:
 		cpu_wait = r4k_wait;
 		printk(" available.\n");
 		break;
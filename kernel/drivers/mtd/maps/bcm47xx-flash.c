@@ -83,8 +83,7 @@ static struct mtd_partition bcm947xx_parts[] = {
          },
  	{ name: "nvram",
            offset: MTDPART_OFS_APPEND,
-           size: 128*1024,
-           mask_flags: MTD_WRITEABLE
+           size: 128*1024
          },
 };
 #endif
@@ -85,14 +85,46 @@ LINK32=xilink6.exe
 # PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
 # Begin Source File
 
+SOURCE=..\batch.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\cache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\cfg.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\codegen.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\common.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\dataflow.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\decompile.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\emitter.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\function.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\image.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\instruction.cpp
 # End Source File
 # Begin Source File
@@ -105,18 +137,50 @@ SOURCE=..\optimize.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\parameter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\profile.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\register.cpp
 # End Source File
 # Begin Source File
 
 SOURCE=..\symbols.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=..\thread.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\timer.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\mipsdecode\mipsdecode.cpp
+# End Source File
 # End Group
 # Begin Group "Header Files"
 
 # PROP Default_Filter "h;hpp;hxx;hm;inl"
 # Begin Source File
 
+SOURCE=..\batch.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\cache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\cfg.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\codegen.h
 # End Source File
 # Begin Source File
@@ -125,10 +189,26 @@ SOURCE=..\common.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\dataflow.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\decompile.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\emitter.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\function.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\image.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\instruction.h
 # End Source File
 # Begin Source File
@@ -141,12 +221,32 @@ SOURCE=..\optimize.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\parameter.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\profile.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\register.h
 # End Source File
 # Begin Source File
 
 SOURCE=..\symbols.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\thread.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\timer.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\mipsdecode\mipsdecode.h
+# End Source File
 # End Group
 # Begin Group "Resource Files"
 
@@ -0,0 +1,194 @@
+#include "batch.h"
+#include "decompile.h"
+#include "symbols.h"
+#include "thread.h"
+#include "profile.h"
+#include "timer.h"
+#include "common.h"
+#include <stdio.h>
+#include <ctype.h>
+
+typedef struct
+{
+	const tFuncNameList *pFuncNames;
+	const BinaryImage *pImage;
+	const DecompileCache *pCache;
+	std::string strOutDir;
+	Mutex aMutex;
+	unsigned uNextFuncIdx;
+	unsigned uNumDecompiled;
+	unsigned uNumFailed;
+	Profile aProfile;
+} tBatchState;
+
+static bool isFunctionSymbol(const tSymbolEntry *pSymEntry)
+{
+	return (pSymEntry->cType == 't') || (pSymEntry->cType == 'T');
+}
+
+void getAllFunctionNames(const BinaryImage &aImage, tFuncNameList &collFuncNames)
+{
+	size_t uNumSymbols = Symbols::getCount();
+
+	/* The last symbol takes its size from the end of its segment */
+	for(unsigned uSymIdx = 0; uSymIdx < uNumSymbols; uSymIdx++)
+	{
+		const tSymbolEntry *pSymEntry = Symbols::get(uSymIdx);
+		unsigned uFirstIdx;
+		unsigned uEndAddress;
+
+		if(!isFunctionSymbol(pSymEntry))
+		{
+			continue;
+		}
+
+		/* Aliases are decompiled once, under the first name in the map */
+		if((!Symbols::lookup(pSymEntry->uAddress, uFirstIdx)) || (uFirstIdx != uSymIdx))
+		{
+			continue;
+		}
+
+		if(Symbols::getNextAddress(pSymEntry->uAddress, uEndAddress))
+		{
+			collFuncNames.push_back(pSymEntry->strName);
+		}
+		else if((aImage.getSegmentEnd(pSymEntry->uAddress, uEndAddress)) && ((uEndAddress - pSymEntry->uAddress) >= 4))
+		{
+			collFuncNames.push_back(pSymEntry->strName);
+		}
+	}
+}
+
+bool readFunctionNameList(const std::string &strListFile, tFuncNameList &collFuncNames)
+{
+	FILE *pListFile = fopen(strListFile.c_str(), "r");
+
+	if(!pListFile)
+	{
+		printf("Can't open function list file: %s\n", strListFile.c_str());
+		return false;
+	}
+
+	char pBuf[1024];
+
+	while(fgets(pBuf, sizeof(pBuf), pListFile))
+	{
+		std::string strFuncName = pBuf;
+
+		while((strFuncName.length() > 0) && (isspace((unsigned char)strFuncName[strFuncName.length() - 1])))
+		{
+			strFuncName.erase(strFuncName.length() - 1, 1);
+		}
+
+		if(strFuncName.length() > 0)
+		{
+			collFuncNames.push_back(strFuncName);
+		}
+	}
+
+	fclose(pListFile);
+
+	return true;
+}
+
+static void batchWorker(void *pArg)
+{
+	tBatchState *pState = (tBatchState *)pArg;
+	Profile aProfile;
+
+	while(true)
+	{
+		pState->aMutex.lock();
+		unsigned uFuncIdx = pState->uNextFuncIdx++;
+		pState->aMutex.unlock();
+
+		if(uFuncIdx >= pState->pFuncNames->size())
+		{
+			break;
+		}
+
+		const std::string &strFuncName = (*pState->pFuncNames)[uFuncIdx];
+		std::string strCodeFile = pState->strOutDir + "/" + strFuncName + ".c";
+
+		bool bResult = decompileFunction(strFuncName, *pState->pImage, strCodeFile, &aProfile, pState->pCache);
+
+		pState->aMutex.lock();
+
+		if(bResult)
+		{
+			pState->uNumDecompiled++;
+		}
+		else
+		{
+			printf("Failed to decompile function %s\n", strFuncName.c_str());
+			pState->uNumFailed++;
+		}
+
+		pState->aMutex.unlock();
+	}
+
+	pState->aMutex.lock();
+	pState->aProfile.add(aProfile);
+	pState->aMutex.unlock();
+}
+
+bool decompileBatch(const tFuncNameList &collFuncNames, const BinaryImage &aImage, const std::string &strOutDir, unsigned uNumThreads, Profile &aProfile,
+	const DecompileCache *pCache)
+{
+	tBatchState aState;
+
+	aState.pFuncNames = &collFuncNames;
+	aState.pImage = &aImage;
+	aState.pCache = pCache;
+	aState.strOutDir = strOutDir;
+	aState.uNextFuncIdx = 0;
+	aState.uNumDecompiled = 0;
+	aState.uNumFailed = 0;
+
+	createDirectory(strOutDir);
+
+	if(uNumThreads == 0)
+	{
+		uNumThreads = 1;
+	}
+
+	if(uNumThreads > collFuncNames.size())
+	{
+		uNumThreads = (collFuncNames.size() > 0) ? (unsigned)collFuncNames.size() : 1;
+	}
+
+	double dStartTime = getTimeSeconds();
+
+	std::vector<Thread *> collThreads;
+
+	/* The calling thread is worker number one */
+	for(unsigned uThreadIdx = 1; uThreadIdx < uNumThreads; uThreadIdx++)
+	{
+		Thread *pThread = new Thread;
+
+		if(!pThread->start(batchWorker, &aState))
+		{
+			printf("Unable to start worker thread %d\n", uThreadIdx);
+			delete pThread;
+			break;
+		}
+
+		collThreads.push_back(pThread);
+	}
+
+	batchWorker(&aState);
+
+	for(unsigned uThreadIdx = 0; uThreadIdx < collThreads.size(); uThreadIdx++)
+	{
+		collThreads[uThreadIdx]->join();
+		delete collThreads[uThreadIdx];
+	}
+
+	aProfile.add(aState.aProfile);
+	aProfile.dWallTime += getTimeSeconds() - dStartTime;
+
+	printf("Decompiled %d of %d functions using %d threads\n", aState.uNumDecompiled, (unsigned)collFuncNames.size(),
+		(unsigned)collThreads.size() + 1);
+
+	return aState.uNumFailed == 0;
+}
@@ -0,0 +1,18 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <vector>
+#include <string>
+#include "image.h"
+
+class Profile;
+class DecompileCache;
+
+typedef std::vector<std::string> tFuncNameList;
+
+void getAllFunctionNames(const BinaryImage &aImage, tFuncNameList &collFuncNames);
+bool readFunctionNameList(const std::string &strListFile, tFuncNameList &collFuncNames);
+bool decompileBatch(const tFuncNameList &collFuncNames, const BinaryImage &aImage, const std::string &strOutDir, unsigned uNumThreads, Profile &aProfile,
+	const DecompileCache *pCache = NULL);
+
+#endif
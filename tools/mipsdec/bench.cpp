@@ -0,0 +1,723 @@
+#include "symbols.h"
+#include "function.h"
+#include "optimize.h"
+#include "dataflow.h"
+#include "batch.h"
+#include "profile.h"
+#include "image.h"
+#include "timer.h"
+#include "common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#define BENCH_DEFAULT_SYMBOLS 30000
+#define BENCH_DEFAULT_LOOKUPS 200000
+#define BENCH_DEFAULT_SWITCHES 40
+#define BENCH_DEFAULT_CASES 50
+#define BENCH_SWITCH_ADDRESS 0x80010000
+#define BENCH_DEFAULT_INSTRUCTIONS 5000
+#define BENCH_MEMORY_CASES 20
+#define BENCH_CORPUS_FUNCTIONS 300
+#define BENCH_CORPUS_NAME "bench_corpus"
+
+/* Every heap allocation of the benchmark goes through these counters */
+static size_t s_uNumAllocations = 0;
+static size_t s_uLiveBytes = 0;
+static size_t s_uPeakBytes = 0;
+
+/* Keeps the size in front of the block, large enough for any alignment */
+#define BENCH_ALLOC_HEADER 16
+
+static void *countedAlloc(size_t uSize)
+{
+	unsigned char *pBlock = (unsigned char *)malloc(uSize + BENCH_ALLOC_HEADER);
+
+	if(!pBlock)
+	{
+		throw std::bad_alloc();
+	}
+
+	*(size_t *)pBlock = uSize;
+	s_uNumAllocations++;
+	s_uLiveBytes += uSize;
+
+	if(s_uLiveBytes > s_uPeakBytes)
+	{
+		s_uPeakBytes = s_uLiveBytes;
+	}
+
+	return pBlock + BENCH_ALLOC_HEADER;
+}
+
+static void countedFree(void *pData)
+{
+	if(pData)
+	{
+		unsigned char *pBlock = (unsigned char *)pData - BENCH_ALLOC_HEADER;
+
+		s_uLiveBytes -= *(size_t *)pBlock;
+		free(pBlock);
+	}
+}
+
+void *operator new(size_t uSize)
+{
+	return countedAlloc(uSize);
+}
+
+void *operator new[](size_t uSize)
+{
+	return countedAlloc(uSize);
+}
+
+void operator delete(void *pData) throw()
+{
+	countedFree(pData);
+}
+
+void operator delete[](void *pData) throw()
+{
+	countedFree(pData);
+}
+
+/* Small deterministic generator so runs are comparable */
+static unsigned s_uRandomState = 0x12345678;
+
+static unsigned getRandom(void)
+{
+	s_uRandomState = (s_uRandomState * 1103515245) + 12345;
+	return s_uRandomState >> 8;
+}
+
+/* Writes a System.map look-alike with uNumSymbols text symbols */
+static bool writeSyntheticMap(const std::string &strMapFile, unsigned uNumSymbols)
+{
+	FILE *pMapFile = fopen(strMapFile.c_str(), "w");
+
+	if(!pMapFile)
+	{
+		printf("Can't create map file: %s\n", strMapFile.c_str());
+		return false;
+	}
+
+	unsigned uAddress = 0x80001000;
+
+	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	{
+		fprintf(pMapFile, "%08x %c bench_sym_%05d\n", uAddress, (uIdx & 7) ? 't' : 'T', uIdx);
+		uAddress += 4 * (4 + (getRandom() % 256));
+	}
+
+	fclose(pMapFile);
+
+	return true;
+}
+
+/* The original linear scans, kept as the reference */
+static bool lookupLinear(const std::string &strSymName, unsigned &uSymIdx)
+{
+	size_t uNumSymbols = Symbols::getCount();
+
+	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	{
+		if(Symbols::get(uIdx)->strName == strSymName)
+		{
+			uSymIdx = uIdx;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool lookupLinear(unsigned uAddress, unsigned &uSymIdx)
+{
+	size_t uNumSymbols = Symbols::getCount();
+
+	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	{
+		if(Symbols::get(uIdx)->uAddress == uAddress)
+		{
+			uSymIdx = uIdx;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void printResult(const char *pName, unsigned uNumLookups, double dTime)
+{
+	printf("%-28s %9d lookups %9.3f ms %12.1f lookups/s\n", pName, uNumLookups, dTime * 1000.0, (dTime > 0.0) ? (uNumLookups / dTime) : 0.0);
+}
+
+static int benchSymbols(int argc, char **argv)
+{
+	std::string strMapFile = (argc > 2) ? argv[2] : "bench_symbols.map";
+	unsigned uNumLookups = (argc > 3) ? strtoul(argv[3], NULL, 0) : BENCH_DEFAULT_LOOKUPS;
+
+	if((argc <= 2) && (!writeSyntheticMap(strMapFile, BENCH_DEFAULT_SYMBOLS)))
+	{
+		return 1;
+	}
+
+	double dStartTime = getTimeSeconds();
+
+	if(!Symbols::parseSymFile(strMapFile))
+	{
+		return 1;
+	}
+
+	size_t uNumSymbols = Symbols::getCount();
+
+	if(!uNumSymbols)
+	{
+		printf("No symbols in %s\n", strMapFile.c_str());
+		return 1;
+	}
+
+	printf("Loaded %d symbols from %s in %.3f ms (including index)\n", (unsigned)uNumSymbols, strMapFile.c_str(), (getTimeSeconds() - dStartTime) * 1000.0);
+
+	/* The linear scans are slow, only time a fraction of the lookups */
+	unsigned uNumLinearLookups = uNumLookups / 100;
+	std::vector<unsigned> collQueries(uNumLookups);
+
+	for(unsigned uIdx = 0; uIdx < uNumLookups; uIdx++)
+	{
+		collQueries[uIdx] = getRandom() % uNumSymbols;
+	}
+
+	unsigned uSymIdx = 0;
+	unsigned uNumMismatches = 0;
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLinearLookups; uIdx++)
+	{
+		lookupLinear(Symbols::get(collQueries[uIdx])->strName, uSymIdx);
+	}
+	printResult("name, linear", uNumLinearLookups, getTimeSeconds() - dStartTime);
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLookups; uIdx++)
+	{
+		Symbols::lookup(Symbols::get(collQueries[uIdx])->strName, uSymIdx);
+	}
+	printResult("name, hashed", uNumLookups, getTimeSeconds() - dStartTime);
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLinearLookups; uIdx++)
+	{
+		lookupLinear(Symbols::get(collQueries[uIdx])->uAddress, uSymIdx);
+	}
+	printResult("address, linear", uNumLinearLookups, getTimeSeconds() - dStartTime);
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLookups; uIdx++)
+	{
+		Symbols::lookup(Symbols::get(collQueries[uIdx])->uAddress, uSymIdx);
+	}
+	printResult("address, indexed", uNumLookups, getTimeSeconds() - dStartTime);
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLookups; uIdx++)
+	{
+		Symbols::lookupContaining(Symbols::get(collQueries[uIdx])->uAddress + 4, uSymIdx);
+	}
+	printResult("address range, indexed", uNumLookups, getTimeSeconds() - dStartTime);
+
+	/* Cross check the index against the reference implementation */
+	for(unsigned uIdx = 0; uIdx < uNumLinearLookups; uIdx++)
+	{
+		const tSymbolEntry *pSymEntry = Symbols::get(collQueries[uIdx]);
+		unsigned uRefIdx = 0;
+
+		if((!lookupLinear(pSymEntry->strName, uRefIdx)) || (!Symbols::lookup(pSymEntry->strName, uSymIdx)) || (uSymIdx != uRefIdx))
+		{
+			uNumMismatches++;
+		}
+
+		if((!lookupLinear(pSymEntry->uAddress, uRefIdx)) || (!Symbols::lookup(pSymEntry->uAddress, uSymIdx)) || (uSymIdx != uRefIdx))
+		{
+			uNumMismatches++;
+		}
+	}
+
+	printf("%d mismatches against the linear lookup\n", uNumMismatches);
+
+	return uNumMismatches ? 1 : 0;
+}
+
+#define MIPS_ADDIU(rt, rs, imm) ((9 << 26) | ((rs) << 21) | ((rt) << 16) | ((imm) & 0xFFFF))
+#define MIPS_BEQ(rs, rt, off) ((4 << 26) | ((rs) << 21) | ((rt) << 16) | ((off) & 0xFFFF))
+#define MIPS_BNE(rs, rt, off) ((5 << 26) | ((rs) << 21) | ((rt) << 16) | ((off) & 0xFFFF))
+#define MIPS_J(target) ((2 << 26) | (((target) >> 2) & 0x3FFFFFF))
+#define MIPS_LUI(rt, imm) ((15 << 26) | ((rt) << 16) | ((imm) & 0xFFFF))
+#define MIPS_JALR(rs) (((rs) << 21) | (31 << 11) | 9)
+#define MIPS_JR(rs) (((rs) << 21) | 8)
+#define MIPS_NOP 0
+
+/* Register numbers as encoded in the instruction word */
+#define MIPS_ZERO 0
+#define MIPS_V0 2
+#define MIPS_A0 4
+#define MIPS_T0 8
+#define MIPS_S0 16
+#define MIPS_T9 25
+#define MIPS_RA 31
+
+/* Emits uNumSwitches compare chains as generated for sparse switch    */
+/* statements. Every case ends with a jump to the common end label, so */
+/* there are lots of jump targets and targets with lots of sources     */
+static void writeSwitchFunction(std::vector<unsigned> &collCode, unsigned uNumSwitches, unsigned uNumCases, unsigned uAddress = BENCH_SWITCH_ADDRESS)
+{
+	collCode.clear();
+
+	for(unsigned uSwitch = 0; uSwitch < uNumSwitches; uSwitch++)
+	{
+		unsigned uBase = collCode.size();
+		unsigned uFirstCase = uBase + (3 * uNumCases) + 2;
+		unsigned uDefault = uFirstCase + (3 * uNumCases);
+		unsigned uEnd = uDefault + 1;
+
+		for(unsigned uCase = 0; uCase < uNumCases; uCase++)
+		{
+			unsigned uBranch = collCode.size() + 1;
+
+			collCode.push_back(MIPS_ADDIU(MIPS_T0, MIPS_ZERO, uCase * 3));
+			collCode.push_back(MIPS_BEQ(MIPS_A0, MIPS_T0, (uFirstCase + (3 * uCase)) - (uBranch + 1)));
+			collCode.push_back(MIPS_NOP);
+		}
+
+		collCode.push_back(MIPS_J(uAddress + (4 * uDefault)));
+		collCode.push_back(MIPS_NOP);
+
+		for(unsigned uCase = 0; uCase < uNumCases; uCase++)
+		{
+			collCode.push_back(MIPS_ADDIU(MIPS_V0, MIPS_V0, uCase + 1));
+			collCode.push_back(MIPS_J(uAddress + (4 * uEnd)));
+			collCode.push_back(MIPS_NOP);
+		}
+
+		collCode.push_back(MIPS_ADDIU(MIPS_V0, MIPS_ZERO, -1));
+	}
+
+	collCode.push_back(MIPS_JR(MIPS_RA));
+	collCode.push_back(MIPS_NOP);
+}
+
+/* The original way of counting jump sources: walk the whole function */
+static unsigned countJumpSourcesLinear(const ControlFlowGraph &aGraph, const tRegionRef &aRegion, unsigned uAddress)
+{
+	unsigned uNumSources = 0;
+
+	for(tInstPos aPos = aGraph.getBegin(aRegion); !ControlFlowGraph::isEnd(aPos); aGraph.next(aPos))
+	{
+		const Instruction &aInstruction = aGraph.get(aPos);
+
+		if((aInstruction.uJumpAddress == uAddress) && (!aInstruction.bIgnoreJump))
+		{
+			uNumSources++;
+		}
+
+		if(aGraph.ownsBranches(aPos))
+		{
+			uNumSources += countJumpSourcesLinear(aGraph, aGraph.getIfBranch(aPos), uAddress);
+			uNumSources += countJumpSourcesLinear(aGraph, aGraph.getElseBranch(aPos), uAddress);
+		}
+	}
+
+	return uNumSources;
+}
+
+static bool parseSwitchFunction(const std::vector<unsigned> &collCode, tInstVector &collInstructions)
+{
+	collInstructions.clear();
+
+	for(unsigned uIdx = 0; uIdx < collCode.size(); uIdx++)
+	{
+		Instruction aInstruction;
+
+		aInstruction.eFormat = IF_UNKNOWN;
+
+		if(!aInstruction.parse(collCode[uIdx], BENCH_SWITCH_ADDRESS + (4 * uIdx)))
+		{
+			printf("Can't decode generated instruction %08x\n", collCode[uIdx]);
+			return false;
+		}
+
+		collInstructions.push_back(aInstruction);
+	}
+
+	return true;
+}
+
+static int benchSwitch(int argc, char **argv)
+{
+	unsigned uNumSwitches = (argc > 2) ? strtoul(argv[2], NULL, 0) : BENCH_DEFAULT_SWITCHES;
+	unsigned uNumCases = (argc > 3) ? strtoul(argv[3], NULL, 0) : BENCH_DEFAULT_CASES;
+	std::vector<unsigned> collCode;
+	tInstVector collInstructions;
+
+	writeSwitchFunction(collCode, uNumSwitches, uNumCases);
+
+	if(!parseSwitchFunction(collCode, collInstructions))
+	{
+		return 1;
+	}
+
+	printf("%d switches with %d cases, %d instructions\n", uNumSwitches, uNumCases, (unsigned)collInstructions.size());
+
+	Function aFunction;
+	ControlFlowGraph &aGraph = aFunction.m_aGraph;
+
+	aGraph.build(collInstructions);
+	resolveDelaySlots(aGraph);
+	aFunction.detectStackOffset();
+
+	double dStartTime = getTimeSeconds();
+	aGraph.updateJumpTargets();
+	printf("%-28s %9.3f ms\n", "update jump targets", (getTimeSeconds() - dStartTime) * 1000.0);
+
+	/* The linear count is slow, only time a fraction of the queries */
+	unsigned uNumLinearLookups = collInstructions.size() / 10;
+	unsigned uNumMismatches = 0;
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < uNumLinearLookups; uIdx++)
+	{
+		countJumpSourcesLinear(aGraph, ControlFlowGraph::getBody(), collInstructions[uIdx * 10].uAddress);
+	}
+	printResult("jump sources, linear", uNumLinearLookups, getTimeSeconds() - dStartTime);
+
+	dStartTime = getTimeSeconds();
+	for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+	{
+		aGraph.getNumJumpSources(collInstructions[uIdx].uAddress);
+	}
+	printResult("jump sources, indexed", collInstructions.size(), getTimeSeconds() - dStartTime);
+
+	for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx += 10)
+	{
+		unsigned uAddress = collInstructions[uIdx].uAddress;
+
+		if(aGraph.getNumJumpSources(uAddress) != countJumpSourcesLinear(aGraph, ControlFlowGraph::getBody(), uAddress))
+		{
+			uNumMismatches++;
+		}
+	}
+
+	printf("%d mismatches against the linear count\n", uNumMismatches);
+
+	/* The index is kept up to date while the optimizer rewrites the code */
+	OptimizerStats aStats;
+
+	dStartTime = getTimeSeconds();
+	optimizeInstructions(aFunction, aStats);
+	printf("%-28s %9.3f ms, %d passes\n", "optimize", (getTimeSeconds() - dStartTime) * 1000.0, aFunction.uOptimizationPasses);
+	aStats.print();
+
+	return uNumMismatches ? 1 : 0;
+}
+
+static void printMemory(const char *pName, size_t uNumAllocations, double dTime)
+{
+	printf("%-28s %9d allocations %9d KiB peak %9.3f ms\n", pName, (unsigned)(s_uNumAllocations - uNumAllocations),
+		(unsigned)(s_uPeakBytes / 1024), dTime * 1000.0);
+}
+
+/* Heap usage of every step of the pipeline, either for a generated */
+/* function or for a function of a binary                           */
+static int benchMemory(int argc, char **argv)
+{
+	Function aFunction;
+	ControlFlowGraph &aGraph = aFunction.m_aGraph;
+	size_t uNumAllocations = s_uNumAllocations;
+	double dStartTime = getTimeSeconds();
+
+	if(argc > 4)
+	{
+		BinaryImage aImage;
+
+		if((!Symbols::parseSymFile(argv[4])) || (!aImage.load(argv[3])))
+		{
+			return 1;
+		}
+
+		uNumAllocations = s_uNumAllocations;
+		s_uPeakBytes = s_uLiveBytes;
+		dStartTime = getTimeSeconds();
+
+		if(!aFunction.parseFromImage(argv[2], aImage))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		unsigned uNumInstructions = (argc > 2) ? strtoul(argv[2], NULL, 0) : BENCH_DEFAULT_INSTRUCTIONS;
+		unsigned uNumSwitches = (uNumInstructions + (6 * BENCH_MEMORY_CASES) + 2) / ((6 * BENCH_MEMORY_CASES) + 3);
+		std::vector<unsigned> collCode;
+		tInstVector collInstructions;
+
+		writeSwitchFunction(collCode, uNumSwitches ? uNumSwitches : 1, BENCH_MEMORY_CASES);
+
+		if(!parseSwitchFunction(collCode, collInstructions))
+		{
+			return 1;
+		}
+
+		aGraph.build(collInstructions);
+	}
+
+	unsigned uNumInstructions = 0;
+
+	for(tInstPos aPos = aGraph.getBegin(ControlFlowGraph::getBody()); !ControlFlowGraph::isEnd(aPos); aGraph.next(aPos))
+	{
+		uNumInstructions++;
+	}
+
+	printf("%d instructions\n", uNumInstructions);
+	printMemory("parse", uNumAllocations, getTimeSeconds() - dStartTime);
+
+	uNumAllocations = s_uNumAllocations;
+	dStartTime = getTimeSeconds();
+	resolveDelaySlots(aGraph);
+	aFunction.detectStackOffset();
+	printMemory("resolve delay slots", uNumAllocations, getTimeSeconds() - dStartTime);
+
+	uNumAllocations = s_uNumAllocations;
+	dStartTime = getTimeSeconds();
+	aGraph.updateJumpTargets();
+	printMemory("update jump targets", uNumAllocations, getTimeSeconds() - dStartTime);
+
+	OptimizerStats aStats;
+
+	uNumAllocations = s_uNumAllocations;
+	dStartTime = getTimeSeconds();
+	optimizeInstructions(aFunction, aStats);
+	printMemory("optimize", uNumAllocations, getTimeSeconds() - dStartTime);
+
+	RegisterValues aValues;
+
+	uNumAllocations = s_uNumAllocations;
+	dStartTime = getTimeSeconds();
+	aValues.analyze(aGraph);
+	printMemory("register values", uNumAllocations, getTimeSeconds() - dStartTime);
+
+	printf("%d blocks, %d optimization passes\n", aGraph.getNumBlocks(), aFunction.uOptimizationPasses);
+
+	return 0;
+}
+
+/* uNumIfs if/else branches one after the other, some of them nested */
+static void writeBranchFunction(std::vector<unsigned> &collCode, unsigned uNumIfs, unsigned uAddress)
+{
+	collCode.clear();
+
+	for(unsigned uIf = 0; uIf < uNumIfs; uIf++)
+	{
+		bool bNested = (uIf & 1) != 0;
+		unsigned uElse = collCode.size() + (bNested ? 9 : 5);
+		unsigned uEnd = uElse + 1;
+
+		collCode.push_back(MIPS_BEQ(MIPS_A0, MIPS_ZERO, uElse - (collCode.size() + 1)));
+		collCode.push_back(MIPS_NOP);
+
+		if(bNested)
+		{
+			collCode.push_back(MIPS_BNE(MIPS_V0, MIPS_ZERO, 2));
+			collCode.push_back(MIPS_NOP);
+			collCode.push_back(MIPS_ADDIU(MIPS_V0, MIPS_V0, uIf));
+			collCode.push_back(MIPS_ADDIU(MIPS_A0, MIPS_A0, -1));
+		}
+
+		collCode.push_back(MIPS_ADDIU(MIPS_V0, MIPS_V0, 1));
+		collCode.push_back(MIPS_J(uAddress + (4 * uEnd)));
+		collCode.push_back(MIPS_NOP);
+		collCode.push_back(MIPS_ADDIU(MIPS_V0, MIPS_V0, 2));
+	}
+
+	collCode.push_back(MIPS_JR(MIPS_RA));
+	collCode.push_back(MIPS_NOP);
+}
+
+/* uNumLoops counted loops, each calling uCallee through a register */
+/* once per iteration                                               */
+static void writeLoopFunction(std::vector<unsigned> &collCode, unsigned uNumLoops, unsigned uCallee)
+{
+	collCode.clear();
+
+	for(unsigned uLoop = 0; uLoop < uNumLoops; uLoop++)
+	{
+		collCode.push_back(MIPS_ADDIU(MIPS_S0, MIPS_ZERO, 4 + uLoop));
+
+		unsigned uLoopStart = collCode.size();
+
+		collCode.push_back(MIPS_LUI(MIPS_T9, (uCallee + 0x8000) >> 16));
+		collCode.push_back(MIPS_ADDIU(MIPS_T9, MIPS_T9, uCallee));
+		collCode.push_back(MIPS_JALR(MIPS_T9));
+		collCode.push_back(MIPS_ADDIU(MIPS_A0, MIPS_S0, 0));
+		collCode.push_back(MIPS_ADDIU(MIPS_S0, MIPS_S0, -1));
+		collCode.push_back(MIPS_BNE(MIPS_S0, MIPS_ZERO, uLoopStart - (collCode.size() + 1)));
+		collCode.push_back(MIPS_NOP);
+	}
+
+	collCode.push_back(MIPS_JR(MIPS_RA));
+	collCode.push_back(MIPS_NOP);
+}
+
+/* Writes the fixed benchmark corpus as raw little endian binary at the */
+/* default load address, together with its map file. The generator is  */
+/* reseeded, so every run decompiles exactly the same functions         */
+static bool writeCorpus(const std::string &strBinFile, const std::string &strMapFile)
+{
+	FILE *pBinFile = fopen(strBinFile.c_str(), "wb");
+	FILE *pMapFile = fopen(strMapFile.c_str(), "w");
+
+	if((!pBinFile) || (!pMapFile))
+	{
+		printf("Can't create benchmark corpus: %s\n", strBinFile.c_str());
+
+		if(pBinFile)
+		{
+			fclose(pBinFile);
+		}
+
+		if(pMapFile)
+		{
+			fclose(pMapFile);
+		}
+
+		return false;
+	}
+
+	unsigned uAddress = IMAGE_DEFAULT_LOAD_ADDRESS;
+	unsigned uPrevAddress = uAddress;
+	std::vector<unsigned> collCode;
+
+	s_uRandomState = 0x12345678;
+
+	for(unsigned uFunction = 0; uFunction < BENCH_CORPUS_FUNCTIONS; uFunction++)
+	{
+		switch(uFunction % 3)
+		{
+			case 0:
+				writeSwitchFunction(collCode, 1 + (getRandom() % 4), 2 + (getRandom() % 30), uAddress);
+				break;
+			case 1:
+				writeBranchFunction(collCode, 1 + (getRandom() % 40), uAddress);
+				break;
+			default:
+				writeLoopFunction(collCode, 1 + (getRandom() % 8), uPrevAddress);
+				break;
+		}
+
+		fprintf(pMapFile, "%08x T bench_func_%03d\n", uAddress, uFunction);
+
+		for(unsigned uIdx = 0; uIdx < collCode.size(); uIdx++)
+		{
+			unsigned char pWord[4];
+
+			pWord[0] = collCode[uIdx] & 0xFF;
+			pWord[1] = (collCode[uIdx] >> 8) & 0xFF;
+			pWord[2] = (collCode[uIdx] >> 16) & 0xFF;
+			pWord[3] = collCode[uIdx] >> 24;
+			fwrite(pWord, 1, sizeof(pWord), pBinFile);
+		}
+
+		uPrevAddress = uAddress;
+		uAddress += 4 * collCode.size();
+	}
+
+	fclose(pBinFile);
+	fclose(pMapFile);
+
+	return true;
+}
+
+/* Decompiles a whole corpus, by default the generated one, and reports */
+/* the throughput together with the profile of every phase and rule    */
+static int benchCorpus(int argc, char **argv)
+{
+	std::string strBinFile = BENCH_CORPUS_NAME ".bin";
+	std::string strMapFile = BENCH_CORPUS_NAME ".map";
+	unsigned uNumThreads = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+	tProfileFormat eFormat = PF_TABLE;
+	int iArgIdx = 3;
+
+	if((iArgIdx < argc) && (std::string(argv[iArgIdx]) == "json"))
+	{
+		eFormat = PF_JSON;
+		iArgIdx++;
+	}
+
+	if((iArgIdx + 1) < argc)
+	{
+		strBinFile = argv[iArgIdx];
+		strMapFile = argv[iArgIdx + 1];
+	}
+	else if(!writeCorpus(strBinFile, strMapFile))
+	{
+		return 1;
+	}
+
+	BinaryImage aImage;
+	tFuncNameList collFuncNames;
+
+	if((!Symbols::parseSymFile(strMapFile)) || (!aImage.load(strBinFile)))
+	{
+		return 1;
+	}
+
+	Symbols::setImage(&aImage);
+
+	if((iArgIdx + 2) < argc)
+	{
+		if(!readFunctionNameList(argv[iArgIdx + 2], collFuncNames))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		getAllFunctionNames(aImage, collFuncNames);
+	}
+
+	Profile aProfile;
+	bool bResult = decompileBatch(collFuncNames, aImage, BENCH_CORPUS_NAME, uNumThreads, aProfile);
+
+	aProfile.print(stdout, eFormat);
+
+	return bResult ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	if((argc >= 2) && (std::string(argv[1]) == "symbols"))
+	{
+		return benchSymbols(argc, argv);
+	}
+
+	if((argc >= 2) && (std::string(argv[1]) == "switch"))
+	{
+		return benchSwitch(argc, argv);
+	}
+
+	if((argc >= 2) && (std::string(argv[1]) == "memory"))
+	{
+		return benchMemory(argc, argv);
+	}
+
+	if((argc >= 2) && (std::string(argv[1]) == "corpus"))
+	{
+		return benchCorpus(argc, argv);
+	}
+
+	printf("Syntax: %s symbols [<map> [<lookups>]]\n", argv[0]);
+	printf("        %s switch [<switches> [<cases>]]\n", argv[0]);
+	printf("        %s memory [<instructions> | <function> <binary> <map>]\n", argv[0]);
+	printf("        %s corpus [<threads> [json] [<binary> <map> [<listfile>]]]\n", argv[0]);
+
+	return 1;
+}
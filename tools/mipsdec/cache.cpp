@@ -0,0 +1,263 @@
+#include "cache.h"
+#include "parameter.h"
+#include "symbols.h"
+#include "common.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#define CACHE_MAGIC "MDCC"
+
+/**********************************************************************/
+/* Layout of an entry, all numbers are host order unsigned ints:      */
+/*                                                                    */
+/*   magic, version, number of symbol references, size of the code   */
+/*   per reference: address, length of the name, name (length 0 if   */
+/*                  no symbol contains the address)                   */
+/*   code                                                             */
+/**********************************************************************/
+
+DecompileCache::DecompileCache(const std::string &strDirectory) :
+		m_strDirectory(strDirectory)
+{
+}
+
+/* The version file is informational, writing it makes sure the */
+/* directory is usable before any function gets decompiled       */
+bool DecompileCache::init(void) const
+{
+	createDirectory(m_strDirectory);
+
+	FILE *pTestFile = fopen((m_strDirectory + "/version").c_str(), "w");
+
+	if(!pTestFile)
+	{
+		printf("Can't use cache directory: %s\n", m_strDirectory.c_str());
+		return false;
+	}
+
+	fprintf(pTestFile, "%d\n", DECOMPILE_CACHE_VERSION);
+	fclose(pTestFile);
+
+	return true;
+}
+
+/* FNV-1a, 64 bit */
+static void hashData(tCacheKey &uHash, const void *pData, size_t uSize)
+{
+	const unsigned char *pBytes = (const unsigned char *)pData;
+
+	while(uSize--)
+	{
+		uHash ^= *pBytes++;
+		uHash *= (((tCacheKey)0x00000100) << 32) | 0x000001B3;
+	}
+}
+
+static void hashString(tCacheKey &uHash, const char *pString)
+{
+	hashData(uHash, pString, strlen(pString) + 1);
+}
+
+static void hashNumber(tCacheKey &uHash, unsigned uNumber)
+{
+	unsigned char pBytes[4];
+
+	pBytes[0] = (unsigned char)uNumber;
+	pBytes[1] = (unsigned char)(uNumber >> 8);
+	pBytes[2] = (unsigned char)(uNumber >> 16);
+	pBytes[3] = (unsigned char)(uNumber >> 24);
+
+	hashData(uHash, pBytes, sizeof(pBytes));
+}
+
+/* Everything the code depends on except for the symbols of called */
+/* functions, those are checked when loading. Labels carry absolute */
+/* addresses, so a moved function gets a new key.                   */
+tCacheKey DecompileCache::getKey(const std::string &strFuncName, unsigned uAddress, const std::vector<unsigned> &collWords)
+{
+	tCacheKey uHash = (((tCacheKey)0xCBF29CE4) << 32) | 0x84222325;
+
+	hashNumber(uHash, DECOMPILE_CACHE_VERSION);
+	hashString(uHash, strFuncName.c_str());
+	hashNumber(uHash, uAddress);
+	hashNumber(uHash, (unsigned)collWords.size());
+
+	for(unsigned uIdx = 0; uIdx < collWords.size(); uIdx++)
+	{
+		hashNumber(uHash, collWords[uIdx]);
+	}
+
+	const tParameter *pParams = FunctionSignatures::lookup(strFuncName);
+
+	if(pParams)
+	{
+		for(unsigned uIdx = 0; pParams[uIdx].pName; uIdx++)
+		{
+			hashString(uHash, pParams[uIdx].pName);
+			hashNumber(uHash, pParams[uIdx].uFlags);
+			hashString(uHash, pParams[uIdx].pInfo ? pParams[uIdx].pInfo->pName : "");
+		}
+	}
+
+	return uHash;
+}
+
+std::string DecompileCache::getFileName(tCacheKey uKey) const
+{
+	char pName[32];
+
+	sprintf(pName, "/%08X%08X.mdc", (unsigned)(uKey >> 32), (unsigned)uKey);
+
+	return m_strDirectory + pName;
+}
+
+static bool readNumber(const std::vector<char> &collData, size_t &uPos, unsigned &uNumber)
+{
+	if((collData.size() - uPos) < sizeof(uNumber))
+	{
+		return false;
+	}
+
+	memcpy(&uNumber, &collData[uPos], sizeof(uNumber));
+	uPos += sizeof(uNumber);
+
+	return true;
+}
+
+/* Misses for missing, broken and outdated entries alike */
+bool DecompileCache::load(tCacheKey uKey, CodeEmitter &aEmitter) const
+{
+	FILE *pFile = fopen(getFileName(uKey).c_str(), "rb");
+
+	if(!pFile)
+	{
+		return false;
+	}
+
+	std::vector<char> collData;
+	char pBuf[4096];
+	size_t uRead;
+
+	while((uRead = fread(pBuf, 1, sizeof(pBuf), pFile)) > 0)
+	{
+		collData.insert(collData.end(), pBuf, pBuf + uRead);
+	}
+
+	fclose(pFile);
+
+	size_t uPos = strlen(CACHE_MAGIC);
+	unsigned uVersion;
+	unsigned uNumRefs;
+	unsigned uCodeSize;
+
+	if((collData.size() < uPos) || memcmp(&collData[0], CACHE_MAGIC, uPos) ||
+		(!readNumber(collData, uPos, uVersion)) || (uVersion != DECOMPILE_CACHE_VERSION) ||
+		(!readNumber(collData, uPos, uNumRefs)) || (!readNumber(collData, uPos, uCodeSize)))
+	{
+		return false;
+	}
+
+	for(unsigned uRefIdx = 0; uRefIdx < uNumRefs; uRefIdx++)
+	{
+		unsigned uAddress;
+		unsigned uNameLength;
+		std::string strName;
+
+		if((!readNumber(collData, uPos, uAddress)) || (!readNumber(collData, uPos, uNameLength)) ||
+			((collData.size() - uPos) < uNameLength))
+		{
+			return false;
+		}
+
+		if(!Symbols::getTargetName(uAddress, strName))
+		{
+			if(uNameLength)
+			{
+				return false;
+			}
+		}
+		else if((strName.length() != uNameLength) || (strName.compare(0, uNameLength, &collData[uPos], uNameLength)))
+		{
+			return false;
+		}
+
+		uPos += uNameLength;
+	}
+
+	if((collData.size() - uPos) != uCodeSize)
+	{
+		return false;
+	}
+
+	if(uCodeSize)
+	{
+		aEmitter.write(&collData[uPos], uCodeSize);
+	}
+
+	return true;
+}
+
+static bool writeNumber(FILE *pFile, unsigned uNumber)
+{
+	return fwrite(&uNumber, sizeof(uNumber), 1, pFile) == 1;
+}
+
+/* Written to a temporary file first, so other runs never see half an */
+/* entry. Functions have unique names, so no two workers of one run  */
+/* write the same entry.                                              */
+bool DecompileCache::store(tCacheKey uKey, const CodeEmitter &aEmitter) const
+{
+	std::vector<unsigned> collRefs = aEmitter.getSymbolReferences();
+
+	std::sort(collRefs.begin(), collRefs.end());
+	collRefs.erase(std::unique(collRefs.begin(), collRefs.end()), collRefs.end());
+
+	std::string strFileName = getFileName(uKey);
+	std::string strTempFileName = strFileName + ".tmp";
+	FILE *pFile = fopen(strTempFileName.c_str(), "wb");
+
+	if(!pFile)
+	{
+		return false;
+	}
+
+	bool bResult = (fwrite(CACHE_MAGIC, strlen(CACHE_MAGIC), 1, pFile) == 1) && writeNumber(pFile, DECOMPILE_CACHE_VERSION) &&
+		writeNumber(pFile, (unsigned)collRefs.size()) && writeNumber(pFile, (unsigned)aEmitter.getSize());
+
+	for(unsigned uRefIdx = 0; bResult && (uRefIdx < collRefs.size()); uRefIdx++)
+	{
+		std::string strName;
+
+		Symbols::getTargetName(collRefs[uRefIdx], strName);
+
+		bResult = writeNumber(pFile, collRefs[uRefIdx]) && writeNumber(pFile, (unsigned)strName.length()) &&
+			(strName.empty() || (fwrite(strName.data(), strName.length(), 1, pFile) == 1));
+	}
+
+	if(bResult && aEmitter.getSize())
+	{
+		bResult = fwrite(aEmitter.getData(), aEmitter.getSize(), 1, pFile) == 1;
+	}
+
+	if(fclose(pFile) != 0)
+	{
+		bResult = false;
+	}
+
+#ifdef _WIN32
+	/* rename() doesn't replace existing files here */
+	if(bResult)
+	{
+		remove(strFileName.c_str());
+	}
+#endif
+
+	if((!bResult) || (rename(strTempFileName.c_str(), strFileName.c_str()) != 0))
+	{
+		remove(strTempFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,38 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <string>
+#include <vector>
+#include "emitter.h"
+
+/* Increase whenever the generated code changes, old entries are */
+/* never hit again afterwards                                    */
+#define DECOMPILE_CACHE_VERSION 2
+
+#ifdef _WIN32
+typedef unsigned __int64 tCacheKey;
+#else
+typedef unsigned long long tCacheKey;
+#endif
+
+/* Generated code of single functions kept on disk between runs, one */
+/* file per function named after its key. Entries are only read and  */
+/* written whole, so workers can share the cache.                    */
+class DecompileCache
+{
+public:
+	DecompileCache(const std::string &strDirectory);
+
+	bool init(void) const;
+
+	static tCacheKey getKey(const std::string &strFuncName, unsigned uAddress, const std::vector<unsigned> &collWords);
+	bool load(tCacheKey uKey, CodeEmitter &aEmitter) const;
+	bool store(tCacheKey uKey, const CodeEmitter &aEmitter) const;
+
+private:
+	std::string getFileName(tCacheKey uKey) const;
+
+	std::string m_strDirectory;
+};
+
+#endif
@@ -0,0 +1,1719 @@
+#include "cfg.h"
+#include "common.h"
+#include <stdio.h>
+#include <algorithm>
+
+/* Positions are spread over [1, ORDER_KEY_END), 0 stays free as the */
+/* position in front of the first block                              */
+#define ORDER_KEY_BITS 62
+#define ORDER_KEY_END ((tOrderKey)1 << ORDER_KEY_BITS)
+
+BasicBlock::BasicBlock(void) :
+		uPrev(BLOCK_NONE),
+		uNext(BLOCK_NONE),
+		bFree(false),
+		uPrevSource(BLOCK_NONE),
+		uNextSource(BLOCK_NONE),
+		bRegistered(false),
+		uRegisteredAddress(0),
+		uPrevAtAddress(BLOCK_NONE),
+		uNextAtAddress(BLOCK_NONE),
+		uOrderPrev(BLOCK_NONE),
+		uOrderNext(BLOCK_NONE),
+		uOrderKey(ORDER_NONE)
+{
+	aRegion.uOwner = BLOCK_NONE;
+	aRegion.bElse = false;
+	aIfBranch.uFirst = BLOCK_NONE;
+	aIfBranch.uLast = BLOCK_NONE;
+	aElseBranch.uFirst = BLOCK_NONE;
+	aElseBranch.uLast = BLOCK_NONE;
+}
+
+ControlFlowGraph::ControlFlowGraph(void) :
+		m_bTrackChanges(false)
+{
+	m_aBody.uFirst = BLOCK_NONE;
+	m_aBody.uLast = BLOCK_NONE;
+}
+
+/* Branches and jumps end a block, calls don't */
+bool isControlTransfer(const Instruction &aInstruction)
+{
+	switch(aInstruction.eType)
+	{
+		case IT_BEQ:
+		case IT_BEQL:
+		case IT_BGEZ:
+		case IT_BGTZ:
+		case IT_BLEZ:
+		case IT_BLTZ:
+		case IT_BNE:
+		case IT_BNEL:
+		case IT_J:
+		case IT_JR:
+		case IT_JR_HB:
+			return true;
+		default:
+			return false;
+	}
+}
+
+AddressIndex::AddressIndex(void) :
+		m_uBegin(0),
+		m_uFreeHolder(HOLDER_NONE)
+{
+}
+
+void AddressIndex::initInfo(tAddressInfo &aInfo)
+{
+	aInfo.uFirstSource = BLOCK_NONE;
+	aInfo.uNumSources = 0;
+	aInfo.uFirstBlock = BLOCK_NONE;
+	aInfo.uFirstHolder = HOLDER_NONE;
+}
+
+/* Sets up the table for the instructions in [uBegin, uEnd) */
+void AddressIndex::reset(unsigned uBegin, unsigned uEnd)
+{
+	m_uBegin = uBegin;
+	m_collTable.resize((uEnd > uBegin) ? ((uEnd - uBegin) >> 2) : 0);
+	clear();
+}
+
+void AddressIndex::clear(void)
+{
+	for(unsigned uIdx = 0; uIdx < m_collTable.size(); uIdx++)
+	{
+		initInfo(m_collTable[uIdx]);
+	}
+
+	m_collOutside.clear();
+	m_collHolders.clear();
+	m_uFreeHolder = HOLDER_NONE;
+}
+
+bool AddressIndex::isInside(unsigned uAddress) const
+{
+	return (uAddress >= m_uBegin) && (((uAddress - m_uBegin) >> 2) < m_collTable.size()) && (!(uAddress & 3));
+}
+
+const tAddressInfo *AddressIndex::find(unsigned uAddress) const
+{
+	if(isInside(uAddress))
+	{
+		return &m_collTable[(uAddress - m_uBegin) >> 2];
+	}
+
+	tAddressInfoMap::const_iterator itInfo = m_collOutside.find(uAddress);
+
+	return (itInfo != m_collOutside.end()) ? &itInfo->second : NULL;
+}
+
+tAddressInfo &AddressIndex::get(unsigned uAddress)
+{
+	if(isInside(uAddress))
+	{
+		return m_collTable[(uAddress - m_uBegin) >> 2];
+	}
+
+	tAddressInfoMap::iterator itInfo = m_collOutside.find(uAddress);
+
+	if(itInfo == m_collOutside.end())
+	{
+		tAddressInfo aInfo;
+
+		initInfo(aInfo);
+		itInfo = m_collOutside.insert(std::make_pair(uAddress, aInfo)).first;
+	}
+
+	return itInfo->second;
+}
+
+/* Drops the entry of uAddress once nothing refers to it anymore */
+void AddressIndex::release(unsigned uAddress)
+{
+	if(!isInside(uAddress))
+	{
+		tAddressInfoMap::iterator itInfo = m_collOutside.find(uAddress);
+
+		if((itInfo != m_collOutside.end()) && (itInfo->second.uNumSources == 0) && (itInfo->second.uFirstBlock == BLOCK_NONE))
+		{
+			m_collOutside.erase(itInfo);
+		}
+	}
+}
+
+/* Only instructions within the function are held by blocks */
+void AddressIndex::addHolder(unsigned uAddress, tBlockIdx uBlock)
+{
+	if(!isInside(uAddress))
+	{
+		return;
+	}
+
+	tAddressInfo &aInfo = m_collTable[(uAddress - m_uBegin) >> 2];
+	unsigned uHolder = m_uFreeHolder;
+
+	if(uHolder != HOLDER_NONE)
+	{
+		m_uFreeHolder = m_collHolders[uHolder].uNext;
+	}
+	else
+	{
+		uHolder = m_collHolders.size();
+		m_collHolders.push_back(tAddressHolder());
+	}
+
+	m_collHolders[uHolder].uBlock = uBlock;
+	m_collHolders[uHolder].uNext = aInfo.uFirstHolder;
+	aInfo.uFirstHolder = uHolder;
+}
+
+void AddressIndex::removeHolder(unsigned uAddress, tBlockIdx uBlock)
+{
+	if(!isInside(uAddress))
+	{
+		return;
+	}
+
+	unsigned *pHolder = &m_collTable[(uAddress - m_uBegin) >> 2].uFirstHolder;
+
+	while((*pHolder != HOLDER_NONE) && (m_collHolders[*pHolder].uBlock != uBlock))
+	{
+		pHolder = &m_collHolders[*pHolder].uNext;
+	}
+
+	M_ASSERT(*pHolder != HOLDER_NONE);
+
+	if(*pHolder != HOLDER_NONE)
+	{
+		unsigned uHolder = *pHolder;
+
+		*pHolder = m_collHolders[uHolder].uNext;
+		m_collHolders[uHolder].uNext = m_uFreeHolder;
+		m_uFreeHolder = uHolder;
+	}
+}
+
+/* The instruction of uAddress has been moved from block uFrom to uTo */
+void AddressIndex::moveHolder(unsigned uAddress, tBlockIdx uFrom, tBlockIdx uTo)
+{
+	if(!isInside(uAddress))
+	{
+		return;
+	}
+
+	unsigned uHolder = m_collTable[(uAddress - m_uBegin) >> 2].uFirstHolder;
+
+	while((uHolder != HOLDER_NONE) && (m_collHolders[uHolder].uBlock != uFrom))
+	{
+		uHolder = m_collHolders[uHolder].uNext;
+	}
+
+	M_ASSERT(uHolder != HOLDER_NONE);
+
+	if(uHolder != HOLDER_NONE)
+	{
+		m_collHolders[uHolder].uBlock = uTo;
+	}
+}
+
+/* Blocks holding an instruction of uAddress, a block holding more */
+/* than one is listed more than once                               */
+void AddressIndex::getHolders(unsigned uAddress, std::vector<tBlockIdx> &collBlocks) const
+{
+	collBlocks.clear();
+
+	if(!isInside(uAddress))
+	{
+		return;
+	}
+
+	for(unsigned uHolder = m_collTable[(uAddress - m_uBegin) >> 2].uFirstHolder; uHolder != HOLDER_NONE; uHolder = m_collHolders[uHolder].uNext)
+	{
+		collBlocks.push_back(m_collHolders[uHolder].uBlock);
+	}
+}
+
+static bool hasBranches(const BasicBlock &aBlock)
+{
+	return (aBlock.aIfBranch.uFirst != BLOCK_NONE) || (aBlock.aElseBranch.uFirst != BLOCK_NONE);
+}
+
+void ControlFlowGraph::build(const tInstVector &collInstructions)
+{
+	tInstVector collCopy(collInstructions);
+
+	adopt(collCopy);
+}
+
+/* Like build(), but takes the instructions over instead of copying */
+/* them, collInstructions is empty afterwards                       */
+void ControlFlowGraph::adopt(tInstVector &collInstructions)
+{
+	m_collBlocks.clear();
+	m_collFreeBlocks.clear();
+	m_aAddressIndex.reset(0, 0);
+	m_aBody.uFirst = BLOCK_NONE;
+	m_aBody.uLast = BLOCK_NONE;
+	m_bTrackChanges = false;
+	m_collTouchedBlocks.clear();
+	m_collReorderedBlocks.clear();
+	m_collChangedTargets.clear();
+
+	if(collInstructions.size() > 0)
+	{
+		tBlockIdx uBlock = allocBlock();
+		tBlockChain aChain = { uBlock, uBlock };
+
+		m_collBlocks[uBlock].collInstructions.swap(collInstructions);
+		linkAfter(getBody(), BLOCK_NONE, aChain);
+	}
+}
+
+/* Hands out the instructions of the function body, the graph is empty */
+/* afterwards. Only valid as long as no branches have been created     */
+void ControlFlowGraph::release(tInstVector &collInstructions)
+{
+	collInstructions.clear();
+
+	for(tBlockIdx uBlock = m_aBody.uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		BasicBlock &aBlock = m_collBlocks[uBlock];
+
+		M_ASSERT(!hasBranches(aBlock));
+
+		/* A freshly built body is a single block, take it over as it is */
+		if(collInstructions.empty())
+		{
+			collInstructions.swap(aBlock.collInstructions);
+		}
+		else
+		{
+			collInstructions.insert(collInstructions.end(), aBlock.collInstructions.begin(), aBlock.collInstructions.end());
+		}
+	}
+
+	tInstVector collNone;
+	adopt(collNone);
+}
+
+tRegionRef ControlFlowGraph::getBody(void)
+{
+	tRegionRef aRegion = { BLOCK_NONE, false };
+
+	return aRegion;
+}
+
+tBlockChain &ControlFlowGraph::getChain(const tRegionRef &aRegion)
+{
+	if(aRegion.uOwner == BLOCK_NONE)
+	{
+		return m_aBody;
+	}
+
+	BasicBlock &aOwner = m_collBlocks[aRegion.uOwner];
+
+	return aRegion.bElse ? aOwner.aElseBranch : aOwner.aIfBranch;
+}
+
+const tBlockChain &ControlFlowGraph::getChain(const tRegionRef &aRegion) const
+{
+	if(aRegion.uOwner == BLOCK_NONE)
+	{
+		return m_aBody;
+	}
+
+	const BasicBlock &aOwner = m_collBlocks[aRegion.uOwner];
+
+	return aRegion.bElse ? aOwner.aElseBranch : aOwner.aIfBranch;
+}
+
+tInstPos ControlFlowGraph::getBegin(const tRegionRef &aRegion) const
+{
+	tInstPos aPos = { getChain(aRegion).uFirst, 0 };
+
+	return aPos;
+}
+
+tInstPos ControlFlowGraph::getLast(const tRegionRef &aRegion) const
+{
+	tInstPos aPos = { getChain(aRegion).uLast, 0 };
+
+	if(aPos.uBlock != BLOCK_NONE)
+	{
+		aPos.uIdx = m_collBlocks[aPos.uBlock].collInstructions.size() - 1;
+	}
+
+	return aPos;
+}
+
+bool ControlFlowGraph::isEmpty(const tRegionRef &aRegion) const
+{
+	return getChain(aRegion).uFirst == BLOCK_NONE;
+}
+
+bool ControlFlowGraph::isEnd(const tInstPos &aPos)
+{
+	return aPos.uBlock == BLOCK_NONE;
+}
+
+bool ControlFlowGraph::isSamePos(const tInstPos &aPos, const tInstPos &aOtherPos)
+{
+	return (aPos.uBlock == aOtherPos.uBlock) && (aPos.uIdx == aOtherPos.uIdx);
+}
+
+void ControlFlowGraph::next(tInstPos &aPos) const
+{
+	const BasicBlock &aBlock = m_collBlocks[aPos.uBlock];
+
+	if((aPos.uIdx + 1) < aBlock.collInstructions.size())
+	{
+		aPos.uIdx++;
+	}
+	else
+	{
+		aPos.uBlock = aBlock.uNext;
+		aPos.uIdx = 0;
+	}
+}
+
+void ControlFlowGraph::prev(tInstPos &aPos) const
+{
+	if(aPos.uIdx > 0)
+	{
+		aPos.uIdx--;
+		return;
+	}
+
+	aPos.uBlock = m_collBlocks[aPos.uBlock].uPrev;
+
+	if(aPos.uBlock != BLOCK_NONE)
+	{
+		aPos.uIdx = m_collBlocks[aPos.uBlock].collInstructions.size() - 1;
+	}
+}
+
+Instruction &ControlFlowGraph::get(const tInstPos &aPos)
+{
+	return m_collBlocks[aPos.uBlock].collInstructions[aPos.uIdx];
+}
+
+const Instruction &ControlFlowGraph::get(const tInstPos &aPos) const
+{
+	return m_collBlocks[aPos.uBlock].collInstructions[aPos.uIdx];
+}
+
+/* Only the last instruction of a block can have branches */
+bool ControlFlowGraph::ownsBranches(const tInstPos &aPos) const
+{
+	return (aPos.uIdx + 1) == m_collBlocks[aPos.uBlock].collInstructions.size();
+}
+
+tRegionRef ControlFlowGraph::getIfBranch(const tInstPos &aPos) const
+{
+	M_ASSERT(ownsBranches(aPos));
+
+	tRegionRef aRegion = { aPos.uBlock, false };
+
+	return aRegion;
+}
+
+tRegionRef ControlFlowGraph::getElseBranch(const tInstPos &aPos) const
+{
+	M_ASSERT(ownsBranches(aPos));
+
+	tRegionRef aRegion = { aPos.uBlock, true };
+
+	return aRegion;
+}
+
+bool ControlFlowGraph::hasIfBranch(const tInstPos &aPos) const
+{
+	return ownsBranches(aPos) && (m_collBlocks[aPos.uBlock].aIfBranch.uFirst != BLOCK_NONE);
+}
+
+bool ControlFlowGraph::hasElseBranch(const tInstPos &aPos) const
+{
+	return ownsBranches(aPos) && (m_collBlocks[aPos.uBlock].aElseBranch.uFirst != BLOCK_NONE);
+}
+
+unsigned ControlFlowGraph::getNumJumpSources(unsigned uAddress, tInstPos *pLastSource) const
+{
+	M_ASSERT(uAddress != 0);
+	M_ASSERT(uAddress != 0xFFFFFFFF);
+
+	const tAddressInfo *pInfo = m_aAddressIndex.find(uAddress);
+
+	if((!pInfo) || (pInfo->uNumSources == 0))
+	{
+		return 0;
+	}
+
+	if(pLastSource)
+	{
+		tBlockIdx uLastSource = pInfo->uFirstSource;
+
+		/* Last one in code order */
+		for(tBlockIdx uSource = uLastSource; uSource != BLOCK_NONE; uSource = m_collBlocks[uSource].uNextSource)
+		{
+			if(m_collBlocks[uSource].uOrderKey > m_collBlocks[uLastSource].uOrderKey)
+			{
+				uLastSource = uSource;
+			}
+		}
+
+		*pLastSource = getBlockLast(uLastSource);
+	}
+
+	return pInfo->uNumSources;
+}
+
+/* Blocks starting with the jump target uAddress. The address index may */
+/* hold outdated entries, they are skipped here                         */
+void ControlFlowGraph::lookupBlocks(unsigned uAddress, std::vector<tBlockIdx> &collBlocks) const
+{
+	const tAddressInfo *pInfo = m_aAddressIndex.find(uAddress);
+
+	collBlocks.clear();
+
+	if(!pInfo)
+	{
+		return;
+	}
+
+	for(tBlockIdx uBlock = pInfo->uFirstBlock; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNextAtAddress)
+	{
+		const BasicBlock &aBlock = m_collBlocks[uBlock];
+
+		if((!aBlock.bFree) && (aBlock.collInstructions.front().uAddress == uAddress) && (aBlock.collInstructions.front().bIsJumpTarget))
+		{
+			collBlocks.push_back(uBlock);
+		}
+	}
+}
+
+bool ControlFlowGraph::containsBlock(const tRegionRef &aRegion, tBlockIdx uBlock) const
+{
+	for(tBlockIdx uCurr = getChain(aRegion).uFirst; uCurr != BLOCK_NONE; uCurr = m_collBlocks[uCurr].uNext)
+	{
+		tRegionRef aIfRegion = { uCurr, false };
+		tRegionRef aElseRegion = { uCurr, true };
+
+		if((uCurr == uBlock) || (containsBlock(aIfRegion, uBlock)) || (containsBlock(aElseRegion, uBlock)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Is aPos part of the range [aFirst, aLast] or nested within it? */
+bool ControlFlowGraph::contains(const tInstPos &aFirst, const tInstPos &aLast, const tInstPos &aPos) const
+{
+	tInstPos aCurr = aFirst;
+
+	while(!isEnd(aCurr))
+	{
+		if(isSamePos(aCurr, aPos))
+		{
+			return true;
+		}
+
+		if((ownsBranches(aCurr)) && ((containsBlock(getIfBranch(aCurr), aPos.uBlock)) || (containsBlock(getElseBranch(aCurr), aPos.uBlock))))
+		{
+			return true;
+		}
+
+		if(isSamePos(aCurr, aLast))
+		{
+			break;
+		}
+
+		next(aCurr);
+	}
+
+	return false;
+}
+
+unsigned ControlFlowGraph::getNumBlocks(void) const
+{
+	return m_collBlocks.size() - m_collFreeBlocks.size();
+}
+
+bool ControlFlowGraph::isUsed(tBlockIdx uBlock) const
+{
+	return (uBlock < m_collBlocks.size()) && (!m_collBlocks[uBlock].bFree);
+}
+
+tInstPos ControlFlowGraph::getBlockBegin(tBlockIdx uBlock) const
+{
+	tInstPos aPos = { uBlock, 0 };
+
+	return aPos;
+}
+
+tInstPos ControlFlowGraph::getBlockLast(tBlockIdx uBlock) const
+{
+	tInstPos aPos = { uBlock, (unsigned)m_collBlocks[uBlock].collInstructions.size() - 1 };
+
+	return aPos;
+}
+
+tBlockIdx ControlFlowGraph::getPrevBlock(tBlockIdx uBlock) const
+{
+	return m_collBlocks[uBlock].uPrev;
+}
+
+tBlockIdx ControlFlowGraph::getNextBlock(tBlockIdx uBlock) const
+{
+	return m_collBlocks[uBlock].uNext;
+}
+
+/* Block whose branch holds uBlock, BLOCK_NONE for the function body */
+tBlockIdx ControlFlowGraph::getOwner(tBlockIdx uBlock) const
+{
+	return m_collBlocks[uBlock].aRegion.uOwner;
+}
+
+/* Position of the block in code order, ORDER_NONE if it is not part */
+/* of the function body. Positions change whenever blocks are linked  */
+/* in, commitChanges() reports the blocks concerned                   */
+tOrderKey ControlFlowGraph::getOrderKey(tBlockIdx uBlock) const
+{
+	return m_collBlocks[uBlock].uOrderKey;
+}
+
+/* All blocks of a region including the nested ones in code order */
+void ControlFlowGraph::getBlocks(const tRegionRef &aRegion, std::vector<tBlockIdx> &collBlocks) const
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		collBlocks.push_back(uBlock);
+		getBlocks(aIfRegion, collBlocks);
+		getBlocks(aElseRegion, collBlocks);
+	}
+}
+
+tBlockIdx ControlFlowGraph::allocBlock(void)
+{
+	if(m_collFreeBlocks.size() > 0)
+	{
+		tBlockIdx uBlock = m_collFreeBlocks.back();
+		tInstVector collStorage;
+
+		/* Keep the instruction storage of the block for reuse */
+		m_collFreeBlocks.pop_back();
+		collStorage.swap(m_collBlocks[uBlock].collInstructions);
+		m_collBlocks[uBlock] = BasicBlock();
+		m_collBlocks[uBlock].collInstructions.swap(collStorage);
+
+		return uBlock;
+	}
+
+	m_collBlocks.push_back(BasicBlock());
+
+	return m_collBlocks.size() - 1;
+}
+
+void ControlFlowGraph::freeBlock(tBlockIdx uBlock)
+{
+	BasicBlock &aBlock = m_collBlocks[uBlock];
+
+	M_ASSERT(!hasBranches(aBlock));
+
+	unregisterBlockAddress(uBlock);
+	aBlock.collInstructions.clear();
+	aBlock.bFree = true;
+	m_collFreeBlocks.push_back(uBlock);
+}
+
+static void setChainRegion(std::deque<BasicBlock> &collBlocks, const tBlockChain &aChain, const tRegionRef &aRegion)
+{
+	for(tBlockIdx uBlock = aChain.uFirst; uBlock != BLOCK_NONE; uBlock = collBlocks[uBlock].uNext)
+	{
+		collBlocks[uBlock].aRegion = aRegion;
+
+		if(uBlock == aChain.uLast)
+		{
+			break;
+		}
+	}
+}
+
+/* Last block in code order of uBlock and its branches */
+tBlockIdx ControlFlowGraph::getLastNested(tBlockIdx uBlock) const
+{
+	while(true)
+	{
+		const BasicBlock &aBlock = m_collBlocks[uBlock];
+
+		if(aBlock.aElseBranch.uLast != BLOCK_NONE)
+		{
+			uBlock = aBlock.aElseBranch.uLast;
+		}
+		else if(aBlock.aIfBranch.uLast != BLOCK_NONE)
+		{
+			uBlock = aBlock.aIfBranch.uLast;
+		}
+		else
+		{
+			return uBlock;
+		}
+	}
+}
+
+/* Block in code order in front of a chain linked into aRegion after */
+/* uAfter, BLOCK_NONE at the front of the function body              */
+tBlockIdx ControlFlowGraph::getOrderPred(const tRegionRef &aRegion, tBlockIdx uAfter) const
+{
+	if(uAfter != BLOCK_NONE)
+	{
+		return getLastNested(uAfter);
+	}
+
+	if(aRegion.uOwner == BLOCK_NONE)
+	{
+		return BLOCK_NONE;
+	}
+
+	const BasicBlock &aOwner = m_collBlocks[aRegion.uOwner];
+
+	if((aRegion.bElse) && (aOwner.aIfBranch.uLast != BLOCK_NONE))
+	{
+		return getLastNested(aOwner.aIfBranch.uLast);
+	}
+
+	return aRegion.uOwner;
+}
+
+void ControlFlowGraph::setOrderKey(tBlockIdx uBlock, tOrderKey uKey)
+{
+	m_collBlocks[uBlock].uOrderKey = uKey;
+
+	if(m_bTrackChanges)
+	{
+		m_collReorderedBlocks.push_back(uBlock);
+	}
+}
+
+/* Numbers uCount blocks starting at uFirst evenly between the */
+/* positions uLow and uHigh (both excluded)                    */
+void ControlFlowGraph::spreadKeys(tBlockIdx uFirst, unsigned uCount, tOrderKey uLow, tOrderKey uHigh)
+{
+	tOrderKey uStep = (uHigh - uLow) / (uCount + 1);
+	tOrderKey uKey = uLow;
+
+	M_ASSERT(uStep > 0);
+
+	for(tBlockIdx uBlock = uFirst; uCount > 0; uBlock = m_collBlocks[uBlock].uOrderNext, uCount--)
+	{
+		uKey += uStep;
+		setOrderKey(uBlock, uKey);
+	}
+}
+
+/* Gives the blocks [uFirst, uLast] of the code order list positions */
+/* between their neighbours. If these are too close, the smallest    */
+/* aligned range of positions around them which is sparse enough is  */
+/* spread out evenly. Ranges twice as large may be a third fuller,   */
+/* so every block is only renumbered a logarithmic number of times   */
+/* on average                                                        */
+void ControlFlowGraph::numberBlocks(tBlockIdx uFirst, tBlockIdx uLast)
+{
+	tBlockIdx uPrev = m_collBlocks[uFirst].uOrderPrev;
+	tBlockIdx uNext = m_collBlocks[uLast].uOrderNext;
+	tOrderKey uLow = (uPrev == BLOCK_NONE) ? 0 : m_collBlocks[uPrev].uOrderKey;
+	tOrderKey uHigh = (uNext == BLOCK_NONE) ? ORDER_KEY_END : m_collBlocks[uNext].uOrderKey;
+	unsigned uCount = 1;
+
+	for(tBlockIdx uBlock = uFirst; uBlock != uLast; uBlock = m_collBlocks[uBlock].uOrderNext)
+	{
+		uCount++;
+	}
+
+	if((uHigh - uLow - 1) >= uCount)
+	{
+		spreadKeys(uFirst, uCount, uLow, uHigh);
+		return;
+	}
+
+	double dCapacity = 1.0;
+
+	for(unsigned uLevel = 1; uLevel <= ORDER_KEY_BITS; uLevel++)
+	{
+		tOrderKey uSize = (tOrderKey)1 << uLevel;
+		tOrderKey uBase = uLow & ~(uSize - 1);
+		tOrderKey uRangeLow = (uBase > 0) ? (uBase - 1) : 0;
+
+		dCapacity *= 4.0 / 3.0;
+
+		while((uPrev != BLOCK_NONE) && (m_collBlocks[uPrev].uOrderKey >= uBase))
+		{
+			uFirst = uPrev;
+			uPrev = m_collBlocks[uPrev].uOrderPrev;
+			uCount++;
+		}
+
+		while((uNext != BLOCK_NONE) && (m_collBlocks[uNext].uOrderKey < (uBase + uSize)))
+		{
+			uNext = m_collBlocks[uNext].uOrderNext;
+			uCount++;
+		}
+
+		if(((uLevel == ORDER_KEY_BITS) || (uCount <= dCapacity)) && ((uBase + uSize - uRangeLow - 1) >= uCount))
+		{
+			spreadKeys(uFirst, uCount, uRangeLow, uBase + uSize);
+			return;
+		}
+	}
+
+	M_ASSERT(false);
+}
+
+/* Inserts the blocks [uFirst, uLast] into the code order list after */
+/* uPred (BLOCK_NONE = front of the function body)                   */
+void ControlFlowGraph::linkOrder(tBlockIdx uPred, tBlockIdx uFirst, tBlockIdx uLast)
+{
+	tBlockIdx uNext = (uPred == BLOCK_NONE) ? m_aBody.uFirst : m_collBlocks[uPred].uOrderNext;
+
+	m_collBlocks[uFirst].uOrderPrev = uPred;
+	m_collBlocks[uLast].uOrderNext = uNext;
+
+	if(uPred != BLOCK_NONE)
+	{
+		m_collBlocks[uPred].uOrderNext = uFirst;
+	}
+
+	if(uNext != BLOCK_NONE)
+	{
+		m_collBlocks[uNext].uOrderPrev = uLast;
+	}
+
+	/* Chains linked into a detached chain get positions once that */
+	/* one is linked into the function body                        */
+	if((uPred == BLOCK_NONE) || (m_collBlocks[uPred].uOrderKey != ORDER_NONE))
+	{
+		numberBlocks(uFirst, uLast);
+	}
+}
+
+/* Cuts the blocks [uFirst, uLast] out of the code order list, they */
+/* stay linked among each other                                     */
+void ControlFlowGraph::unlinkOrder(tBlockIdx uFirst, tBlockIdx uLast)
+{
+	tBlockIdx uPrev = m_collBlocks[uFirst].uOrderPrev;
+	tBlockIdx uNext = m_collBlocks[uLast].uOrderNext;
+
+	if(uPrev != BLOCK_NONE)
+	{
+		m_collBlocks[uPrev].uOrderNext = uNext;
+	}
+
+	if(uNext != BLOCK_NONE)
+	{
+		m_collBlocks[uNext].uOrderPrev = uPrev;
+	}
+
+	m_collBlocks[uFirst].uOrderPrev = BLOCK_NONE;
+	m_collBlocks[uLast].uOrderNext = BLOCK_NONE;
+
+	for(tBlockIdx uBlock = uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uOrderNext)
+	{
+		if(m_collBlocks[uBlock].uOrderKey != ORDER_NONE)
+		{
+			setOrderKey(uBlock, ORDER_NONE);
+		}
+	}
+}
+
+/* Links the blocks of a freshly cloned chain into a code order list */
+/* of their own, uPred is the last block of that list                */
+void ControlFlowGraph::orderClone(const tBlockChain &aChain, tBlockIdx &uPred)
+{
+	for(tBlockIdx uBlock = aChain.uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		BasicBlock &aBlock = m_collBlocks[uBlock];
+
+		aBlock.uOrderPrev = uPred;
+		aBlock.uOrderNext = BLOCK_NONE;
+
+		if(uPred != BLOCK_NONE)
+		{
+			m_collBlocks[uPred].uOrderNext = uBlock;
+		}
+
+		uPred = uBlock;
+		orderClone(aBlock.aIfBranch, uPred);
+		orderClone(aBlock.aElseBranch, uPred);
+
+		if(uBlock == aChain.uLast)
+		{
+			break;
+		}
+	}
+}
+
+/* Links a detached chain into a region after uAfter (BLOCK_NONE = front) */
+void ControlFlowGraph::linkAfter(const tRegionRef &aRegion, tBlockIdx uAfter, const tBlockChain &aChain)
+{
+	tBlockChain &aRegionChain = getChain(aRegion);
+	tBlockIdx uBefore = (uAfter == BLOCK_NONE) ? aRegionChain.uFirst : m_collBlocks[uAfter].uNext;
+
+	linkOrder(getOrderPred(aRegion, uAfter), aChain.uFirst, getLastNested(aChain.uLast));
+	setChainRegion(m_collBlocks, aChain, aRegion);
+
+	m_collBlocks[aChain.uFirst].uPrev = uAfter;
+	m_collBlocks[aChain.uLast].uNext = uBefore;
+
+	if(uAfter == BLOCK_NONE)
+	{
+		aRegionChain.uFirst = aChain.uFirst;
+	}
+	else
+	{
+		m_collBlocks[uAfter].uNext = aChain.uFirst;
+	}
+
+	if(uBefore == BLOCK_NONE)
+	{
+		aRegionChain.uLast = aChain.uLast;
+	}
+	else
+	{
+		m_collBlocks[uBefore].uPrev = aChain.uLast;
+		touchBlock(uBefore);
+	}
+
+	if(uAfter != BLOCK_NONE)
+	{
+		touchBlock(uAfter);
+	}
+
+	/* Blocks within the chain keep their neighbours */
+	touchBlock(aChain.uFirst);
+	touchBlock(aChain.uLast);
+	touchBlock(aRegion.uOwner);
+}
+
+void ControlFlowGraph::unlink(tBlockIdx uFirst, tBlockIdx uLast)
+{
+	tBlockChain &aRegionChain = getChain(m_collBlocks[uFirst].aRegion);
+	tBlockIdx uPrev = m_collBlocks[uFirst].uPrev;
+	tBlockIdx uNext = m_collBlocks[uLast].uNext;
+
+	unlinkOrder(uFirst, getLastNested(uLast));
+	touchBlock(uPrev);
+	touchBlock(uNext);
+	touchBlock(m_collBlocks[uFirst].aRegion.uOwner);
+
+	if(uPrev == BLOCK_NONE)
+	{
+		aRegionChain.uFirst = uNext;
+	}
+	else
+	{
+		m_collBlocks[uPrev].uNext = uNext;
+	}
+
+	if(uNext == BLOCK_NONE)
+	{
+		aRegionChain.uLast = uPrev;
+	}
+	else
+	{
+		m_collBlocks[uNext].uPrev = uPrev;
+	}
+
+	m_collBlocks[uFirst].uPrev = BLOCK_NONE;
+	m_collBlocks[uLast].uNext = BLOCK_NONE;
+}
+
+void ControlFlowGraph::touchBlock(tBlockIdx uBlock)
+{
+	if((m_bTrackChanges) && (uBlock != BLOCK_NONE))
+	{
+		m_collTouchedBlocks.push_back(uBlock);
+	}
+}
+
+/* Has to be called after an instruction has been modified in place */
+void ControlFlowGraph::touch(const tInstPos &aPos)
+{
+	touchBlock(aPos.uBlock);
+}
+
+static bool isJumpSource(const Instruction &aInstruction)
+{
+	return (aInstruction.uJumpAddress != 0) && (!aInstruction.bIgnoreJump);
+}
+
+void ControlFlowGraph::addInstruction(tBlockIdx uBlock, const Instruction &aInstruction)
+{
+	if(!m_bTrackChanges)
+	{
+		return;
+	}
+
+	m_aAddressIndex.addHolder(aInstruction.uAddress, uBlock);
+
+	if(!isJumpSource(aInstruction))
+	{
+		return;
+	}
+
+	addChangedTarget(aInstruction.uJumpAddress);
+	addJumpSource(uBlock, aInstruction.uJumpAddress);
+}
+
+void ControlFlowGraph::removeInstruction(tBlockIdx uBlock, const Instruction &aInstruction)
+{
+	if(!m_bTrackChanges)
+	{
+		return;
+	}
+
+	m_aAddressIndex.removeHolder(aInstruction.uAddress, uBlock);
+
+	if(!isJumpSource(aInstruction))
+	{
+		return;
+	}
+
+	addChangedTarget(aInstruction.uJumpAddress);
+	removeJumpSource(uBlock, aInstruction.uJumpAddress);
+}
+
+/* The instructions collInstructions have been moved from block uFrom to uTo */
+void ControlFlowGraph::moveHolders(const tInstVector &collInstructions, tBlockIdx uFrom, tBlockIdx uTo)
+{
+	if(!m_bTrackChanges)
+	{
+		return;
+	}
+
+	for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+	{
+		m_aAddressIndex.moveHolder(collInstructions[uIdx].uAddress, uFrom, uTo);
+	}
+}
+
+void ControlFlowGraph::addChangedTarget(unsigned uAddress)
+{
+	tChangedTarget aTarget = { uAddress, (unsigned)m_collChangedTargets.size(), getNumJumpSources(uAddress) };
+
+	m_collChangedTargets.push_back(aTarget);
+}
+
+void ControlFlowGraph::addJumpSource(tBlockIdx uBlock, unsigned uAddress)
+{
+	tAddressInfo &aInfo = m_aAddressIndex.get(uAddress);
+	BasicBlock &aBlock = m_collBlocks[uBlock];
+
+	aBlock.uPrevSource = BLOCK_NONE;
+	aBlock.uNextSource = aInfo.uFirstSource;
+
+	if(aInfo.uFirstSource != BLOCK_NONE)
+	{
+		m_collBlocks[aInfo.uFirstSource].uPrevSource = uBlock;
+	}
+
+	aInfo.uFirstSource = uBlock;
+	aInfo.uNumSources++;
+}
+
+void ControlFlowGraph::removeJumpSource(tBlockIdx uBlock, unsigned uAddress)
+{
+	tAddressInfo &aInfo = m_aAddressIndex.get(uAddress);
+	BasicBlock &aBlock = m_collBlocks[uBlock];
+
+	M_ASSERT(aInfo.uNumSources > 0);
+
+	if(aBlock.uPrevSource != BLOCK_NONE)
+	{
+		m_collBlocks[aBlock.uPrevSource].uNextSource = aBlock.uNextSource;
+	}
+	else
+	{
+		M_ASSERT(aInfo.uFirstSource == uBlock);
+		aInfo.uFirstSource = aBlock.uNextSource;
+	}
+
+	if(aBlock.uNextSource != BLOCK_NONE)
+	{
+		m_collBlocks[aBlock.uNextSource].uPrevSource = aBlock.uPrevSource;
+	}
+
+	aBlock.uPrevSource = BLOCK_NONE;
+	aBlock.uNextSource = BLOCK_NONE;
+	aInfo.uNumSources--;
+	m_aAddressIndex.release(uAddress);
+}
+
+/* Moves the first uIdx instructions into a new block linked in front of */
+/* uBlock. uBlock keeps its index and its branches                       */
+tBlockIdx ControlFlowGraph::splitBefore(tBlockIdx uBlock, unsigned uIdx)
+{
+	M_ASSERT((uIdx > 0) && (uIdx < m_collBlocks[uBlock].collInstructions.size()));
+
+	tBlockIdx uHead = allocBlock();
+	tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+	tBlockChain aChain = { uHead, uHead };
+
+	m_collBlocks[uHead].collInstructions.assign(collInstructions.begin(), collInstructions.begin() + uIdx);
+	collInstructions.erase(collInstructions.begin(), collInstructions.begin() + uIdx);
+	moveHolders(m_collBlocks[uHead].collInstructions, uBlock, uHead);
+	linkAfter(m_collBlocks[uBlock].aRegion, m_collBlocks[uBlock].uPrev, aChain);
+
+	return uHead;
+}
+
+void ControlFlowGraph::append(const tRegionRef &aRegion, const Instruction &aInstruction)
+{
+	tBlockIdx uLast = getChain(aRegion).uLast;
+
+	if(uLast != BLOCK_NONE)
+	{
+		BasicBlock &aBlock = m_collBlocks[uLast];
+
+		if((!hasBranches(aBlock)) && (!isControlTransfer(aBlock.collInstructions.back())))
+		{
+			aBlock.collInstructions.push_back(aInstruction);
+			addInstruction(uLast, aInstruction);
+			touchBlock(uLast);
+			return;
+		}
+	}
+
+	tBlockIdx uBlock = allocBlock();
+	tBlockChain aChain = { uBlock, uBlock };
+
+	m_collBlocks[uBlock].collInstructions.push_back(aInstruction);
+	addInstruction(uBlock, aInstruction);
+	linkAfter(aRegion, uLast, aChain);
+}
+
+void ControlFlowGraph::insertAfter(const tInstPos &aPos, const Instruction &aInstruction)
+{
+	tBlockIdx uBlock = allocBlock();
+	tBlockChain aChain = { uBlock, uBlock };
+
+	m_collBlocks[uBlock].collInstructions.push_back(aInstruction);
+	addInstruction(uBlock, aInstruction);
+	insertAfter(aPos, aChain);
+}
+
+void ControlFlowGraph::insertAfter(const tInstPos &aPos, const tBlockChain &aChain)
+{
+	tBlockIdx uAfter = aPos.uBlock;
+
+	if(!ownsBranches(aPos))
+	{
+		uAfter = splitBefore(aPos.uBlock, aPos.uIdx + 1);
+	}
+
+	linkAfter(m_collBlocks[uAfter].aRegion, uAfter, aChain);
+}
+
+void ControlFlowGraph::insertFront(const tRegionRef &aRegion, const tBlockChain &aChain)
+{
+	linkAfter(aRegion, BLOCK_NONE, aChain);
+}
+
+/* Replaces a single instruction by a detached chain */
+void ControlFlowGraph::replace(const tInstPos &aPos, const tBlockChain &aChain)
+{
+	tInstPos aReplacePos = aPos;
+
+	if(!ownsBranches(aReplacePos))
+	{
+		aReplacePos.uBlock = splitBefore(aPos.uBlock, aPos.uIdx + 1);
+	}
+
+	linkAfter(m_collBlocks[aReplacePos.uBlock].aRegion, aReplacePos.uBlock, aChain);
+	erase(aReplacePos);
+}
+
+void ControlFlowGraph::erase(const tInstPos &aPos)
+{
+	BasicBlock &aBlock = m_collBlocks[aPos.uBlock];
+
+	if(ownsBranches(aPos))
+	{
+		/* The branches would end up at the previous instruction */
+		M_ASSERT(!hasBranches(aBlock));
+	}
+
+	removeInstruction(aPos.uBlock, aBlock.collInstructions[aPos.uIdx]);
+	aBlock.collInstructions.erase(aBlock.collInstructions.begin() + aPos.uIdx);
+	touchBlock(aPos.uBlock);
+
+	if(aBlock.collInstructions.size() == 0)
+	{
+		unlink(aPos.uBlock, aPos.uBlock);
+		freeBlock(aPos.uBlock);
+	}
+}
+
+/* Unlinks the instructions [aFirst, aLast] of one region, including */
+/* their branches, and returns them as detached chain                */
+tBlockChain ControlFlowGraph::extract(tInstPos aFirst, tInstPos aLast)
+{
+	if(!ownsBranches(aLast))
+	{
+		tBlockIdx uHead = splitBefore(aLast.uBlock, aLast.uIdx + 1);
+
+		if(aFirst.uBlock == aLast.uBlock)
+		{
+			aFirst.uBlock = uHead;
+		}
+
+		aLast.uBlock = uHead;
+	}
+
+	if(aFirst.uIdx > 0)
+	{
+		splitBefore(aFirst.uBlock, aFirst.uIdx);
+	}
+
+	tBlockChain aChain = { aFirst.uBlock, aLast.uBlock };
+
+	unlink(aChain.uFirst, aChain.uLast);
+
+	return aChain;
+}
+
+tBlockChain ControlFlowGraph::extractRegion(const tRegionRef &aRegion)
+{
+	tBlockChain aChain = getChain(aRegion);
+
+	if(aChain.uFirst != BLOCK_NONE)
+	{
+		unlink(aChain.uFirst, aChain.uLast);
+	}
+
+	return aChain;
+}
+
+/* Deep copy of the instructions [aFirst, aLast] of one region */
+tBlockChain ControlFlowGraph::clone(const tInstPos &aFirst, const tInstPos &aLast)
+{
+	tBlockChain aChain = cloneChain(aFirst, aLast);
+	tBlockIdx uPred = BLOCK_NONE;
+
+	orderClone(aChain, uPred);
+
+	return aChain;
+}
+
+tBlockChain ControlFlowGraph::cloneChain(const tInstPos &aFirst, const tInstPos &aLast)
+{
+	tBlockChain aChain = { BLOCK_NONE, BLOCK_NONE };
+	tBlockIdx uCurr = BLOCK_NONE;
+	tInstPos aPos = aFirst;
+
+	while(!isEnd(aPos))
+	{
+		if(uCurr == BLOCK_NONE)
+		{
+			uCurr = allocBlock();
+			m_collBlocks[uCurr].uPrev = aChain.uLast;
+			touchBlock(uCurr);
+
+			if(aChain.uLast == BLOCK_NONE)
+			{
+				aChain.uFirst = uCurr;
+			}
+			else
+			{
+				m_collBlocks[aChain.uLast].uNext = uCurr;
+			}
+
+			aChain.uLast = uCurr;
+		}
+
+		m_collBlocks[uCurr].collInstructions.push_back(get(aPos));
+		addInstruction(uCurr, get(aPos));
+
+		if(ownsBranches(aPos))
+		{
+			if(hasIfBranch(aPos))
+			{
+				tRegionRef aIfRegion = { uCurr, false };
+				tBlockChain aIfChain = cloneChain(getBegin(getIfBranch(aPos)), getLast(getIfBranch(aPos)));
+
+				m_collBlocks[uCurr].aIfBranch = aIfChain;
+				setChainRegion(m_collBlocks, aIfChain, aIfRegion);
+			}
+
+			if(hasElseBranch(aPos))
+			{
+				tRegionRef aElseRegion = { uCurr, true };
+				tBlockChain aElseChain = cloneChain(getBegin(getElseBranch(aPos)), getLast(getElseBranch(aPos)));
+
+				m_collBlocks[uCurr].aElseBranch = aElseChain;
+				setChainRegion(m_collBlocks, aElseChain, aElseRegion);
+			}
+
+			/* Keep the block boundaries of the original */
+			uCurr = BLOCK_NONE;
+		}
+
+		if(isSamePos(aPos, aLast))
+		{
+			break;
+		}
+
+		next(aPos);
+	}
+
+	return aChain;
+}
+
+void ControlFlowGraph::swapBranches(const tInstPos &aPos)
+{
+	M_ASSERT(ownsBranches(aPos));
+
+	BasicBlock &aBlock = m_collBlocks[aPos.uBlock];
+	tBlockChain aIfChain = aBlock.aElseBranch;
+
+	if(aBlock.aIfBranch.uFirst != BLOCK_NONE)
+	{
+		unlinkOrder(aBlock.aIfBranch.uFirst, getLastNested(aBlock.aIfBranch.uLast));
+	}
+
+	if(aBlock.aElseBranch.uFirst != BLOCK_NONE)
+	{
+		unlinkOrder(aBlock.aElseBranch.uFirst, getLastNested(aBlock.aElseBranch.uLast));
+	}
+
+	aBlock.aElseBranch = aBlock.aIfBranch;
+	aBlock.aIfBranch = aIfChain;
+
+	setChainRegion(m_collBlocks, aBlock.aIfBranch, getIfBranch(aPos));
+	setChainRegion(m_collBlocks, aBlock.aElseBranch, getElseBranch(aPos));
+
+	if(aBlock.aIfBranch.uFirst != BLOCK_NONE)
+	{
+		linkOrder(aPos.uBlock, aBlock.aIfBranch.uFirst, getLastNested(aBlock.aIfBranch.uLast));
+	}
+
+	if(aBlock.aElseBranch.uFirst != BLOCK_NONE)
+	{
+		linkOrder(getOrderPred(getElseBranch(aPos), BLOCK_NONE), aBlock.aElseBranch.uFirst, getLastNested(aBlock.aElseBranch.uLast));
+	}
+
+	touchBlock(aPos.uBlock);
+}
+
+/* Instructions created by the optimizer have no address of their own */
+void ControlFlowGraph::getAddressRange(const tRegionRef &aRegion, unsigned &uBegin, unsigned &uEnd) const
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		const tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+		{
+			unsigned uAddress = collInstructions[uIdx].uAddress;
+
+			if(uAddress != 0xFFFFFFFF)
+			{
+				uBegin = std::min(uBegin, uAddress);
+				uEnd = std::max(uEnd, uAddress + 4);
+			}
+		}
+
+		getAddressRange(aIfRegion, uBegin, uEnd);
+		getAddressRange(aElseRegion, uBegin, uEnd);
+	}
+}
+
+/* Only counts the sources, the blocks are not final yet */
+void ControlFlowGraph::collectJumpTargets(const tRegionRef &aRegion)
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		const tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+		{
+			if(isJumpSource(collInstructions[uIdx]))
+			{
+				m_aAddressIndex.get(collInstructions[uIdx].uJumpAddress).uNumSources++;
+			}
+		}
+
+		collectJumpTargets(aIfRegion);
+		collectJumpTargets(aElseRegion);
+	}
+}
+
+void ControlFlowGraph::markJumpTargets(const tRegionRef &aRegion)
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+		{
+			const tAddressInfo *pInfo = m_aAddressIndex.find(collInstructions[uIdx].uAddress);
+
+			collInstructions[uIdx].bIsJumpTarget = pInfo && (pInfo->uNumSources > 0);
+		}
+
+		markJumpTargets(aIfRegion);
+		markJumpTargets(aElseRegion);
+	}
+}
+
+bool ControlFlowGraph::canMerge(tBlockIdx uPrev, tBlockIdx uBlock) const
+{
+	const BasicBlock &aPrev = m_collBlocks[uPrev];
+
+	return (!hasBranches(aPrev)) && (!isControlTransfer(aPrev.collInstructions.back())) &&
+		(!m_collBlocks[uBlock].collInstructions.front().bIsJumpTarget);
+}
+
+/* The instructions of uPrev are moved to the front of uBlock, so the */
+/* block of the last instruction (and of a jump source) never changes */
+void ControlFlowGraph::mergeIntoNext(tBlockIdx uPrev, tBlockIdx uBlock)
+{
+	tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+	tInstVector &collPrevInstructions = m_collBlocks[uPrev].collInstructions;
+
+	collInstructions.insert(collInstructions.begin(), collPrevInstructions.begin(), collPrevInstructions.end());
+	moveHolders(collPrevInstructions, uPrev, uBlock);
+	unlink(uPrev, uPrev);
+	freeBlock(uPrev);
+	touchBlock(uBlock);
+}
+
+/* Merges the previous block into this one if nothing separates them */
+/* anymore and splits it before jump targets and after control       */
+/* transfers. uBlock keeps the last instruction and its branches     */
+void ControlFlowGraph::normalizeBlock(tBlockIdx uBlock)
+{
+	while((m_collBlocks[uBlock].uPrev != BLOCK_NONE) && (canMerge(m_collBlocks[uBlock].uPrev, uBlock)))
+	{
+		mergeIntoNext(m_collBlocks[uBlock].uPrev, uBlock);
+	}
+
+	tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+	unsigned uStart = 0;
+
+	for(unsigned uIdx = 1; uIdx < collInstructions.size(); uIdx++)
+	{
+		if((collInstructions[uIdx].bIsJumpTarget) || (isControlTransfer(collInstructions[uIdx - 1])))
+		{
+			tBlockIdx uHead = allocBlock();
+			tBlockChain aChain = { uHead, uHead };
+
+			m_collBlocks[uHead].collInstructions.assign(collInstructions.begin() + uStart, collInstructions.begin() + uIdx);
+			moveHolders(m_collBlocks[uHead].collInstructions, uBlock, uHead);
+			linkAfter(m_collBlocks[uBlock].aRegion, m_collBlocks[uBlock].uPrev, aChain);
+			uStart = uIdx;
+		}
+	}
+
+	if(uStart > 0)
+	{
+		collInstructions.erase(collInstructions.begin(), collInstructions.begin() + uStart);
+	}
+}
+
+void ControlFlowGraph::normalizeRegion(const tRegionRef &aRegion)
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		normalizeBlock(uBlock);
+		normalizeRegion(aIfRegion);
+		normalizeRegion(aElseRegion);
+	}
+}
+
+void ControlFlowGraph::collectJumpSources(const tRegionRef &aRegion)
+{
+	for(tBlockIdx uBlock = getChain(aRegion).uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uNext)
+	{
+		const tInstVector &collInstructions = m_collBlocks[uBlock].collInstructions;
+		tRegionRef aIfRegion = { uBlock, false };
+		tRegionRef aElseRegion = { uBlock, true };
+
+		registerBlockAddress(uBlock);
+
+		for(unsigned uIdx = 0; uIdx < collInstructions.size(); uIdx++)
+		{
+			m_aAddressIndex.addHolder(collInstructions[uIdx].uAddress, uBlock);
+
+			if(isJumpSource(collInstructions[uIdx]))
+			{
+				M_ASSERT((uIdx + 1) == collInstructions.size());
+				addJumpSource(uBlock, collInstructions[uIdx].uJumpAddress);
+			}
+		}
+
+		collectJumpSources(aIfRegion);
+		collectJumpSources(aElseRegion);
+	}
+}
+
+/* Recalculates the jump target flags, the block boundaries and the jump */
+/* edges of the whole function and starts tracking modifications         */
+void ControlFlowGraph::updateJumpTargets(void)
+{
+	unsigned uBegin = 0xFFFFFFFF;
+	unsigned uEnd = 0;
+
+	m_bTrackChanges = false;
+
+	getAddressRange(getBody(), uBegin, uEnd);
+	m_aAddressIndex.reset(uBegin, uEnd);
+	collectJumpTargets(getBody());
+	markJumpTargets(getBody());
+	normalizeRegion(getBody());
+
+	m_aAddressIndex.clear();
+
+	for(unsigned uBlock = 0; uBlock < m_collBlocks.size(); uBlock++)
+	{
+		m_collBlocks[uBlock].bRegistered = false;
+	}
+
+	collectJumpSources(getBody());
+
+	/* Spread the positions out evenly again */
+	unsigned uNumBlocks = 0;
+
+	for(tBlockIdx uBlock = m_aBody.uFirst; uBlock != BLOCK_NONE; uBlock = m_collBlocks[uBlock].uOrderNext)
+	{
+		uNumBlocks++;
+	}
+
+	if(uNumBlocks > 0)
+	{
+		spreadKeys(m_aBody.uFirst, uNumBlocks, 0, ORDER_KEY_END);
+	}
+
+	m_bTrackChanges = true;
+	m_collTouchedBlocks.clear();
+	m_collReorderedBlocks.clear();
+	m_collChangedTargets.clear();
+}
+
+/* Adds a block starting with a jump target to the list of its address */
+void ControlFlowGraph::registerBlockAddress(tBlockIdx uBlock)
+{
+	BasicBlock &aBlock = m_collBlocks[uBlock];
+
+	if((aBlock.bFree) || (!aBlock.collInstructions.front().bIsJumpTarget))
+	{
+		return;
+	}
+
+	unsigned uAddress = aBlock.collInstructions.front().uAddress;
+
+	if(aBlock.bRegistered)
+	{
+		if(aBlock.uRegisteredAddress == uAddress)
+		{
+			return;
+		}
+
+		unregisterBlockAddress(uBlock);
+	}
+
+	tAddressInfo &aInfo = m_aAddressIndex.get(uAddress);
+
+	aBlock.bRegistered = true;
+	aBlock.uRegisteredAddress = uAddress;
+	aBlock.uPrevAtAddress = BLOCK_NONE;
+	aBlock.uNextAtAddress = aInfo.uFirstBlock;
+
+	if(aInfo.uFirstBlock != BLOCK_NONE)
+	{
+		m_collBlocks[aInfo.uFirstBlock].uPrevAtAddress = uBlock;
+	}
+
+	aInfo.uFirstBlock = uBlock;
+}
+
+void ControlFlowGraph::unregisterBlockAddress(tBlockIdx uBlock)
+{
+	BasicBlock &aBlock = m_collBlocks[uBlock];
+
+	if(!aBlock.bRegistered)
+	{
+		return;
+	}
+
+	tAddressInfo &aInfo = m_aAddressIndex.get(aBlock.uRegisteredAddress);
+
+	if(aBlock.uPrevAtAddress != BLOCK_NONE)
+	{
+		m_collBlocks[aBlock.uPrevAtAddress].uNextAtAddress = aBlock.uNextAtAddress;
+	}
+	else
+	{
+		aInfo.uFirstBlock = aBlock.uNextAtAddress;
+	}
+
+	if(aBlock.uNextAtAddress != BLOCK_NONE)
+	{
+		m_collBlocks[aBlock.uNextAtAddress].uPrevAtAddress = aBlock.uPrevAtAddress;
+	}
+
+	aBlock.bRegistered = false;
+	m_aAddressIndex.release(aBlock.uRegisteredAddress);
+}
+
+static bool isChangedTargetBefore(const tChangedTarget &aTarget, const tChangedTarget &aOtherTarget)
+{
+	if(aTarget.uAddress != aOtherTarget.uAddress)
+	{
+		return aTarget.uAddress < aOtherTarget.uAddress;
+	}
+
+	return aTarget.uSequence < aOtherTarget.uSequence;
+}
+
+/* The number of jump sources of uAddress has changed. The blocks */
+/* starting there have to be looked at again, the jump target     */
+/* flags only change if the first source was added or the last    */
+/* one removed                                                    */
+void ControlFlowGraph::updateJumpTarget(unsigned uAddress, unsigned uOldNumSources)
+{
+	unsigned uNumSources = getNumJumpSources(uAddress);
+	std::vector<tBlockIdx> collBlocks;
+
+	lookupBlocks(uAddress, collBlocks);
+
+	for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+	{
+		touchBlock(collBlocks[uIdx]);
+
+		if(uNumSources == 0)
+		{
+			m_collBlocks[collBlocks[uIdx]].collInstructions.front().bIsJumpTarget = false;
+		}
+	}
+
+	/* New jump target, can be anywhere within the blocks holding it */
+	if((uOldNumSources == 0) && (uNumSources > 0))
+	{
+		m_aAddressIndex.getHolders(uAddress, collBlocks);
+
+		for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+		{
+			tInstVector &collInstructions = m_collBlocks[collBlocks[uIdx]].collInstructions;
+
+			for(unsigned uInstIdx = 0; uInstIdx < collInstructions.size(); uInstIdx++)
+			{
+				if(collInstructions[uInstIdx].uAddress == uAddress)
+				{
+					collInstructions[uInstIdx].bIsJumpTarget = true;
+					touchBlock(collBlocks[uIdx]);
+				}
+			}
+		}
+	}
+}
+
+/* Brings the jump target flags, the block boundaries and the jump edges */
+/* up to date after modifications. Only the touched blocks and the       */
+/* targets of added/removed jumps are looked at. Returns the blocks      */
+/* which have changed, including their new neighbours, and the blocks    */
+/* whose position in code order has changed (or which are gone)          */
+void ControlFlowGraph::commitChanges(std::vector<tBlockIdx> &collChanged, std::vector<tBlockIdx> &collReordered)
+{
+	/* Cloned blocks may start with a jump target as well */
+	for(unsigned uIdx = 0; uIdx < m_collTouchedBlocks.size(); uIdx++)
+	{
+		registerBlockAddress(m_collTouchedBlocks[uIdx]);
+	}
+
+	/* Each target once, with the number of sources before the first change */
+	std::sort(m_collChangedTargets.begin(), m_collChangedTargets.end(), isChangedTargetBefore);
+
+	for(unsigned uIdx = 0; uIdx < m_collChangedTargets.size(); uIdx++)
+	{
+		const tChangedTarget &aTarget = m_collChangedTargets[uIdx];
+
+		if((uIdx == 0) || (m_collChangedTargets[uIdx - 1].uAddress != aTarget.uAddress))
+		{
+			updateJumpTarget(aTarget.uAddress, aTarget.uOldNumSources);
+		}
+	}
+
+	m_collChangedTargets.clear();
+
+	/* Normalizing may touch further blocks */
+	for(unsigned uIdx = 0; uIdx < m_collTouchedBlocks.size(); uIdx++)
+	{
+		tBlockIdx uBlock = m_collTouchedBlocks[uIdx];
+
+		if(m_collBlocks[uBlock].bFree)
+		{
+			continue;
+		}
+
+		normalizeBlock(uBlock);
+
+		tBlockIdx uNext = m_collBlocks[uBlock].uNext;
+
+		if((uNext != BLOCK_NONE) && (canMerge(uBlock, uNext)))
+		{
+			touchBlock(uNext);
+		}
+	}
+
+	std::sort(m_collTouchedBlocks.begin(), m_collTouchedBlocks.end());
+	m_collTouchedBlocks.erase(std::unique(m_collTouchedBlocks.begin(), m_collTouchedBlocks.end()), m_collTouchedBlocks.end());
+
+	collChanged.clear();
+
+	for(unsigned uIdx = 0; uIdx < m_collTouchedBlocks.size(); uIdx++)
+	{
+		tBlockIdx uBlock = m_collTouchedBlocks[uIdx];
+		if(!m_collBlocks[uBlock].bFree)
+		{
+			registerBlockAddress(uBlock);
+			collChanged.push_back(uBlock);
+		}
+	}
+
+	m_collTouchedBlocks.clear();
+
+	std::sort(m_collReorderedBlocks.begin(), m_collReorderedBlocks.end());
+	m_collReorderedBlocks.erase(std::unique(m_collReorderedBlocks.begin(), m_collReorderedBlocks.end()), m_collReorderedBlocks.end());
+	collReordered.swap(m_collReorderedBlocks);
+	m_collReorderedBlocks.clear();
+}
+
+void dumpInstructions(const ControlFlowGraph &aGraph, const tRegionRef &aRegion)
+{
+	for(tInstPos aPos = aGraph.getBegin(aRegion); !ControlFlowGraph::isEnd(aPos); aGraph.next(aPos))
+	{
+		dumpInstruction(aGraph.get(aPos));
+
+		if(aGraph.ownsBranches(aPos))
+		{
+			dumpInstructions(aGraph, aGraph.getIfBranch(aPos));
+			dumpInstructions(aGraph, aGraph.getElseBranch(aPos));
+		}
+	}
+}
@@ -0,0 +1,275 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <vector>
+#include <deque>
+#include <map>
+#include "instruction.h"
+
+/* The function body is kept as a tree of basic blocks. Every block holds */
+/* a contiguous run of instructions and is linked into a region: either   */
+/* the function body or the if/else branch of the instruction ending      */
+/* another block. Blocks are addressed by index, so moving code between   */
+/* regions only relinks blocks instead of copying instructions.           */
+/*                                                                        */
+/* After updateJumpTargets() every jump target starts a block and every   */
+/* branch/jump ends one. Jump edges are kept by target address: the jump  */
+/* sources of an address and the blocks starting at an address can both   */
+/* be looked up without walking the function. The number of sources of   */
+/* an address is a constant time query.                                   */
+/*                                                                        */
+/* From then on all modifications are tracked. commitChanges() restores   */
+/* the block invariants and the jump edges for the touched blocks only    */
+/* and reports which blocks have changed, so the optimizer never has to   */
+/* look at the instructions of the whole function again.                  */
+/*                                                                        */
+/* The code order of all blocks is kept as a list with sparse positions:  */
+/* linking a chain only numbers the blocks of that chain, and if there is */
+/* no room left between its neighbours, a small range around it is        */
+/* spread out again.                                                      */
+
+typedef unsigned tBlockIdx;
+
+#define BLOCK_NONE (~0U)
+
+#ifdef _WIN32
+typedef unsigned __int64 tOrderKey;
+#else
+typedef unsigned long long tOrderKey;
+#endif
+
+/* Position of a block which is not part of the function body */
+#define ORDER_NONE (~(tOrderKey)0)
+
+typedef std::vector<Instruction> tInstVector;
+
+/* Instruction within a block, uBlock == BLOCK_NONE marks the end of a region */
+typedef struct
+{
+	tBlockIdx uBlock;
+	unsigned uIdx;
+} tInstPos;
+
+/* Function body (uOwner == BLOCK_NONE) or if/else branch of the last */
+/* instruction in block uOwner                                        */
+typedef struct
+{
+	tBlockIdx uOwner;
+	bool bElse;
+} tRegionRef;
+
+typedef struct
+{
+	tBlockIdx uFirst;
+	tBlockIdx uLast;
+} tBlockChain;
+
+class BasicBlock
+{
+public:
+	BasicBlock(void);
+
+	tInstVector collInstructions;
+
+	tBlockIdx uPrev;
+	tBlockIdx uNext;
+	tRegionRef aRegion;
+
+	/* Branches of the last instruction */
+	tBlockChain aIfBranch;
+	tBlockChain aElseBranch;
+
+	bool bFree;
+
+	/* Links in the list of jump sources of the same target, used if */
+	/* the last instruction is a jump                                */
+	tBlockIdx uPrevSource;
+	tBlockIdx uNextSource;
+
+	/* Links in the list of blocks starting at the same jump target */
+	bool bRegistered;
+	unsigned uRegisteredAddress;
+	tBlockIdx uPrevAtAddress;
+	tBlockIdx uNextAtAddress;
+
+	/* Links in the code order list, the block is followed by the */
+	/* blocks of its if branch and then by those of its else branch */
+	tBlockIdx uOrderPrev;
+	tBlockIdx uOrderNext;
+	tOrderKey uOrderKey;
+};
+
+#define HOLDER_NONE (~0U)
+
+/* Jumps are always the last instruction of their block, so a jump */
+/* source is identified by its block. Both lists are linked through */
+/* the blocks, so keeping them up to date never allocates memory    */
+typedef struct
+{
+	tBlockIdx uFirstSource;
+	unsigned uNumSources;
+	tBlockIdx uFirstBlock;
+	unsigned uFirstHolder;
+} tAddressInfo;
+
+/* Block holding the instruction of an address. Cloned instructions */
+/* keep their address, so an address can have several holders      */
+typedef struct
+{
+	tBlockIdx uBlock;
+	unsigned uNext;
+} tAddressHolder;
+
+typedef std::map<unsigned, tAddressInfo> tAddressInfoMap;
+
+/* Jump target whose number of sources has changed, uSequence keeps */
+/* the order of the changes to the same target                      */
+typedef struct
+{
+	unsigned uAddress;
+	unsigned uSequence;
+	unsigned uOldNumSources;
+} tChangedTarget;
+
+/* Jump sources and blocks by address. Addresses within the function */
+/* are kept in a table with one entry per instruction, so a lookup   */
+/* is a single array access. The few jumps leaving the function end  */
+/* up in a map. For the addresses within the function the index also */
+/* knows the blocks holding the instruction                          */
+class AddressIndex
+{
+public:
+	AddressIndex(void);
+
+	void reset(unsigned uBegin, unsigned uEnd);
+	void clear(void);
+	bool isInside(unsigned uAddress) const;
+	const tAddressInfo *find(unsigned uAddress) const;
+	tAddressInfo &get(unsigned uAddress);
+	void release(unsigned uAddress);
+
+	void addHolder(unsigned uAddress, tBlockIdx uBlock);
+	void removeHolder(unsigned uAddress, tBlockIdx uBlock);
+	void moveHolder(unsigned uAddress, tBlockIdx uFrom, tBlockIdx uTo);
+	void getHolders(unsigned uAddress, std::vector<tBlockIdx> &collBlocks) const;
+
+private:
+	static void initInfo(tAddressInfo &aInfo);
+
+	unsigned m_uBegin;
+	std::vector<tAddressInfo> m_collTable;
+	tAddressInfoMap m_collOutside;
+
+	/* Holder lists of all addresses, unused entries are chained up */
+	std::vector<tAddressHolder> m_collHolders;
+	unsigned m_uFreeHolder;
+};
+
+class ControlFlowGraph
+{
+public:
+	ControlFlowGraph(void);
+
+	void build(const tInstVector &collInstructions);
+	void adopt(tInstVector &collInstructions);
+	void release(tInstVector &collInstructions);
+	void updateJumpTargets(void);
+
+	static tRegionRef getBody(void);
+	tInstPos getBegin(const tRegionRef &aRegion) const;
+	tInstPos getLast(const tRegionRef &aRegion) const;
+	bool isEmpty(const tRegionRef &aRegion) const;
+	static bool isEnd(const tInstPos &aPos);
+	static bool isSamePos(const tInstPos &aPos, const tInstPos &aOtherPos);
+	void next(tInstPos &aPos) const;
+	void prev(tInstPos &aPos) const;
+	Instruction &get(const tInstPos &aPos);
+	const Instruction &get(const tInstPos &aPos) const;
+
+	bool ownsBranches(const tInstPos &aPos) const;
+	tRegionRef getIfBranch(const tInstPos &aPos) const;
+	tRegionRef getElseBranch(const tInstPos &aPos) const;
+	bool hasIfBranch(const tInstPos &aPos) const;
+	bool hasElseBranch(const tInstPos &aPos) const;
+
+	unsigned getNumJumpSources(unsigned uAddress, tInstPos *pLastSource = NULL) const;
+	void lookupBlocks(unsigned uAddress, std::vector<tBlockIdx> &collBlocks) const;
+	bool contains(const tInstPos &aFirst, const tInstPos &aLast, const tInstPos &aPos) const;
+	unsigned getNumBlocks(void) const;
+
+	bool isUsed(tBlockIdx uBlock) const;
+	tInstPos getBlockBegin(tBlockIdx uBlock) const;
+	tInstPos getBlockLast(tBlockIdx uBlock) const;
+	tBlockIdx getPrevBlock(tBlockIdx uBlock) const;
+	tBlockIdx getNextBlock(tBlockIdx uBlock) const;
+	tBlockIdx getOwner(tBlockIdx uBlock) const;
+	tOrderKey getOrderKey(tBlockIdx uBlock) const;
+	void getBlocks(const tRegionRef &aRegion, std::vector<tBlockIdx> &collBlocks) const;
+
+	void append(const tRegionRef &aRegion, const Instruction &aInstruction);
+	void insertAfter(const tInstPos &aPos, const Instruction &aInstruction);
+	void insertAfter(const tInstPos &aPos, const tBlockChain &aChain);
+	void insertFront(const tRegionRef &aRegion, const tBlockChain &aChain);
+	void replace(const tInstPos &aPos, const tBlockChain &aChain);
+	void erase(const tInstPos &aPos);
+	tBlockChain extract(tInstPos aFirst, tInstPos aLast);
+	tBlockChain extractRegion(const tRegionRef &aRegion);
+	tBlockChain clone(const tInstPos &aFirst, const tInstPos &aLast);
+	void swapBranches(const tInstPos &aPos);
+	void touch(const tInstPos &aPos);
+	void commitChanges(std::vector<tBlockIdx> &collChanged, std::vector<tBlockIdx> &collReordered);
+
+private:
+	tBlockChain &getChain(const tRegionRef &aRegion);
+	const tBlockChain &getChain(const tRegionRef &aRegion) const;
+	tBlockIdx allocBlock(void);
+	void freeBlock(tBlockIdx uBlock);
+	void linkAfter(const tRegionRef &aRegion, tBlockIdx uAfter, const tBlockChain &aChain);
+	void unlink(tBlockIdx uFirst, tBlockIdx uLast);
+	void touchBlock(tBlockIdx uBlock);
+	tBlockIdx splitBefore(tBlockIdx uBlock, unsigned uIdx);
+	bool canMerge(tBlockIdx uPrev, tBlockIdx uBlock) const;
+	void mergeIntoNext(tBlockIdx uPrev, tBlockIdx uBlock);
+	void normalizeRegion(const tRegionRef &aRegion);
+	void normalizeBlock(tBlockIdx uBlock);
+	void addInstruction(tBlockIdx uBlock, const Instruction &aInstruction);
+	void removeInstruction(tBlockIdx uBlock, const Instruction &aInstruction);
+	void moveHolders(const tInstVector &collInstructions, tBlockIdx uFrom, tBlockIdx uTo);
+	void addJumpSource(tBlockIdx uBlock, unsigned uAddress);
+	void removeJumpSource(tBlockIdx uBlock, unsigned uAddress);
+	void registerBlockAddress(tBlockIdx uBlock);
+	void unregisterBlockAddress(tBlockIdx uBlock);
+	void addChangedTarget(unsigned uAddress);
+	void updateJumpTarget(unsigned uAddress, unsigned uOldNumSources);
+	tBlockIdx getLastNested(tBlockIdx uBlock) const;
+	tBlockIdx getOrderPred(const tRegionRef &aRegion, tBlockIdx uAfter) const;
+	void linkOrder(tBlockIdx uPred, tBlockIdx uFirst, tBlockIdx uLast);
+	void unlinkOrder(tBlockIdx uFirst, tBlockIdx uLast);
+	void orderClone(const tBlockChain &aChain, tBlockIdx &uPred);
+	void numberBlocks(tBlockIdx uFirst, tBlockIdx uLast);
+	void spreadKeys(tBlockIdx uFirst, unsigned uCount, tOrderKey uLow, tOrderKey uHigh);
+	void setOrderKey(tBlockIdx uBlock, tOrderKey uKey);
+	tBlockChain cloneChain(const tInstPos &aFirst, const tInstPos &aLast);
+	void markJumpTargets(const tRegionRef &aRegion);
+	void getAddressRange(const tRegionRef &aRegion, unsigned &uBegin, unsigned &uEnd) const;
+	void collectJumpTargets(const tRegionRef &aRegion);
+	void collectJumpSources(const tRegionRef &aRegion);
+	bool containsBlock(const tRegionRef &aRegion, tBlockIdx uBlock) const;
+
+	std::deque<BasicBlock> m_collBlocks;
+	std::vector<tBlockIdx> m_collFreeBlocks;
+	tBlockChain m_aBody;
+
+	AddressIndex m_aAddressIndex;
+
+	/* Modifications since the last commitChanges() */
+	bool m_bTrackChanges;
+	std::vector<tBlockIdx> m_collTouchedBlocks;
+	std::vector<tBlockIdx> m_collReorderedBlocks;
+	std::vector<tChangedTarget> m_collChangedTargets;
+};
+
+bool isControlTransfer(const Instruction &aInstruction);
+void dumpInstructions(const ControlFlowGraph &aGraph, const tRegionRef &aRegion);
+
+#endif
@@ -1,386 +1,394 @@
 #include "instruction.h"
 #include "function.h"
 #include "parameter.h"
+#include "dataflow.h"
+#include "emitter.h"
 #include "common.h"
+#include <string.h>
 
-std::string getIndentStr(unsigned uDepth)
+static void generateInstructionCode(CodeEmitter &aEmitter, const ControlFlowGraph &aGraph, const RegisterValues &aValues, const tRegionRef &aRegion, unsigned uDepth)
 {
-	std::string strIndent;
+	tInstPos aPos = aGraph.getBegin(aRegion);
 
-	while(uDepth > 0)
-	{
-		strIndent += '\t';
-		uDepth--;
-	}
-
-	return strIndent;
-}
-
-std::string getRegVarName(tRegister eRegister)
-{
-	std::string strVarName = (eRegister == R_ZERO) ? "" : "REG_";
-	strVarName += getRegName(eRegister);
-	return strVarName;
-}
-
-void doIndent(FILE *pDestFile, unsigned uDepth)
-{
-	fprintf(pDestFile, "%s", getIndentStr(uDepth).c_str());
-}
-
-void generateInstructionCode(FILE *pDestFile, const tInstList &collInstList, unsigned uDepth)
-{
-	tInstList::const_iterator itCurr = collInstList.begin();
-	tInstList::const_iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
+	while(!ControlFlowGraph::isEnd(aPos))
 	{
 		bool bBranchAllowed = false;
-		const Instruction aInstruction = *itCurr;
+		const Instruction &aInstruction = aGraph.get(aPos);
 
-		//fprintf(pDestFile, "%08X:\n", aInstruction.uAddress);
+		//aEmitter.print("%08X:\n", aInstruction.uAddress);
 
 		if(aInstruction.bIsJumpTarget)
 		{
-			fprintf(pDestFile, "LABEL_%08X:\n", aInstruction.uAddress);
+			aEmitter.print("LABEL_%08X:\n", aInstruction.uAddress);
 		}
 
 		switch(aInstruction.eType)
 		{
 			case IT_ADDIU:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
 				if(aInstruction.eRS == R_ZERO)
 				{
-					fprintf(pDestFile, "%s = %d;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.iSI);
+					aEmitter.print("%s = %d;\n", getRegVarName(aInstruction.eRT), aInstruction.iSI);
 				}
 				else if(aInstruction.eRT == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s %c= %d;\n", getRegVarName(aInstruction.eRT).c_str(), cSign, abs(aInstruction.iSI));
+					aEmitter.print("%s %c= %d;\n", getRegVarName(aInstruction.eRT), cSign, abs(aInstruction.iSI));
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s %c %d;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+					aEmitter.print("%s = %s %c %d;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				}
 				break;
 			}
 			case IT_ADDU:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if((aInstruction.eRS == R_ZERO) && (aInstruction.eRT == R_ZERO))
 				{
-					fprintf(pDestFile, "%s = 0;\n", getRegVarName(aInstruction.eRD).c_str());
+					aEmitter.print("%s = 0;\n", getRegVarName(aInstruction.eRD));
 				}
 				else if(aInstruction.eRT == R_ZERO)
 				{
-					fprintf(pDestFile, "%s = %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRS).c_str());
+					aEmitter.print("%s = %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRS));
 				}
 				else if(aInstruction.eRD == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s += %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s += %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT));
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s + %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s = %s + %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				}
 				break;
 			}
 			case IT_AND:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRD == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s &= %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s &= %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT));
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s & %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s = %s & %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				}
 				break;
 			}
 			case IT_ANDI:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRT == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s &= 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.uUI);
+					aEmitter.print("%s &= 0x%X;\n", getRegVarName(aInstruction.eRT), aInstruction.uUI);
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s & 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), aInstruction.uUI);
+					aEmitter.print("%s = %s & 0x%X;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), aInstruction.uUI);
 				}
 				break;
 			}
 			case IT_BEQ:
 			case IT_BEQL:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(%s == %s)\n", getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(%s == %s)\n", getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_BGEZ:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(((signed int)%s) >= 0)\n", getRegVarName(aInstruction.eRS).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(((signed int)%s) >= 0)\n", getRegVarName(aInstruction.eRS));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_BGTZ:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(((signed int)%s) > 0)\n", getRegVarName(aInstruction.eRS).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(((signed int)%s) > 0)\n", getRegVarName(aInstruction.eRS));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_BLEZ:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(((signed int)%s) <= 0)\n", getRegVarName(aInstruction.eRS).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(((signed int)%s) <= 0)\n", getRegVarName(aInstruction.eRS));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_BLTZ:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(((signed int)%s) < 0)\n", getRegVarName(aInstruction.eRS).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(((signed int)%s) < 0)\n", getRegVarName(aInstruction.eRS));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_BNE:
 			case IT_BNEL:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "if(%s != %s)\n", getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
+				aEmitter.print("if(%s != %s)\n", getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				bBranchAllowed = true;
 				break;
 			}
 			case IT_J:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "goto LABEL_%08X;\n", aInstruction.uJumpAddress);
+				aEmitter.indent(uDepth);
+				aEmitter.print("goto LABEL_%08X;\n", aInstruction.uJumpAddress);
 				break;
 			}
 			case IT_JALR:
 			{
-				fprintf(pDestFile, "\n");
-				doIndent(pDestFile, uDepth);
+				aEmitter.print("\n");
+				aEmitter.indent(uDepth);
 				M_ASSERT(aInstruction.eRD == R_RA);
 
 				unsigned uValue = 0;
-				unsigned uSymIdx;
-				if((resolveRegisterValue(collInstList, itCurr, aInstruction.eRS, uValue)) && (Symbols::lookup(uValue, uSymIdx)))
+				std::string strTarget;
+				bool bKnownValue = aValues.getValue(aPos, aInstruction.eRS, uValue);
+
+				if(bKnownValue)
+				{
+					aEmitter.referenceSymbol(uValue);
+				}
+
+				if(bKnownValue && Symbols::getTargetName(uValue, strTarget))
 				{
-					fprintf(pDestFile, "%s = %s();\n\n", getRegVarName(R_V0).c_str(), Symbols::get(uSymIdx)->strName.c_str());									
+					if(strTarget.find('+') == std::string::npos)
+					{
+						aEmitter.print("%s = %s();\n\n", getRegVarName(R_V0), strTarget.c_str());
+					}
+					else
+					{
+						/* Calls into the middle of a function can't be expressed in C */
+						aEmitter.print("/* FIXME: call %s in %s (0x%08X); */\n\n", strTarget.c_str(), getRegVarName(aInstruction.eRS), uValue);
+					}
 				}
 				else
 				{
-					fprintf(pDestFile, "/* FIXME: call UNKNOWN FUNCTION in %s (0x%08X); */\n\n", getRegVarName(aInstruction.eRS).c_str(), uValue);
+					aEmitter.print("/* FIXME: call UNKNOWN FUNCTION in %s (0x%08X); */\n\n", getRegVarName(aInstruction.eRS), uValue);
 				}
 				break;
 			}
 			case IT_JR:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRS == R_RA)
 				{
-					fprintf(pDestFile, "return %s;\n", getRegVarName(R_V0).c_str());
+					aEmitter.print("return %s;\n", getRegVarName(R_V0));
 				}
 				else
 				{
-					fprintf(pDestFile, "/* FIXME: RET-CALL %s; */\n", getRegVarName(aInstruction.eRS).c_str());
+					unsigned uValue;
+					std::string strTarget;
+
+					if(aValues.getValue(aPos, aInstruction.eRS, uValue) && Symbols::getTargetName(uValue, strTarget))
+					{
+						aEmitter.referenceSymbol(uValue);
+						aEmitter.print("/* FIXME: RET-CALL %s (%s); */\n", getRegVarName(aInstruction.eRS), strTarget.c_str());
+					}
+					else
+					{
+						aEmitter.print("/* FIXME: RET-CALL %s; */\n", getRegVarName(aInstruction.eRS));
+					}
 				}
 				break;
 			}
 			case IT_LB:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "%s = *((signed char *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+				aEmitter.print("%s = *((signed char *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				break;
 			}
 			case IT_LBU:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "%s = *((unsigned char *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+				aEmitter.print("%s = *((unsigned char *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				break;
 			}
 			case IT_LH:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "%s = *((signed short *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+				aEmitter.print("%s = *((signed short *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				break;
 			}
 			case IT_LHU:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "%s = *((unsigned short *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+				aEmitter.print("%s = *((unsigned short *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				break;
 			}
 			case IT_LUI:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = 0x%X0000;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.uUI);
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = 0x%X0000;\n", getRegVarName(aInstruction.eRT), aInstruction.uUI);
 				break;
 			}
 			case IT_LW:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "%s = *((unsigned int *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI));
+				aEmitter.print("%s = *((unsigned int *)(((unsigned int)(%s)) %c %d));\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI));
 				break;
 			}
 			case IT_MFC0:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = read_c0_status();\n", getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = read_c0_status();\n", getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_MTC0:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "write_c0_status(%s);\n", getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.indent(uDepth);
+				aEmitter.print("write_c0_status(%s);\n", getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_NOP:
 				/* Ignore */
 				break;
 			case IT_OR:
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRD == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s |= %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s |= %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT));
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s | %s;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+					aEmitter.print("%s = %s | %s;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				}
 				break;
 			case IT_ORI:
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRS == R_ZERO)
 				{
-					fprintf(pDestFile, "%s = 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.uUI);
+					aEmitter.print("%s = 0x%X;\n", getRegVarName(aInstruction.eRT), aInstruction.uUI);
 				}
 				else if(aInstruction.eRT == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s |= 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.uUI);
+					aEmitter.print("%s |= 0x%X;\n", getRegVarName(aInstruction.eRT), aInstruction.uUI);
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s | 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), aInstruction.uUI);
+					aEmitter.print("%s = %s | 0x%X;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), aInstruction.uUI);
 				}
 				break;
 			case IT_SB:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "*((unsigned char *)(((unsigned int)(%s)) %c %d)) = %s & 0xFF;\n", getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.print("*((unsigned char *)(((unsigned int)(%s)) %c %d)) = %s & 0xFF;\n", getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_SH:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "*((unsigned short *)(((unsigned int)(%s)) %c %d)) = %s & 0xFF;\n", getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.print("*((unsigned short *)(((unsigned int)(%s)) %c %d)) = %s & 0xFF;\n", getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_SLL:
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRD == aInstruction.eRT)
 				{
-					fprintf(pDestFile, "%s <<= %d;\n", getRegVarName(aInstruction.eRD).c_str(), aInstruction.uSA);
+					aEmitter.print("%s <<= %d;\n", getRegVarName(aInstruction.eRD), aInstruction.uSA);
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s << %d;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str(), aInstruction.uSA);
+					aEmitter.print("%s = %s << %d;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT), aInstruction.uSA);
 				}
 				break;
 			case IT_SLTI:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = (((signed int)%s) < %d) ? 1 : 0;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), aInstruction.iSI);
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = (((signed int)%s) < %d) ? 1 : 0;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), aInstruction.iSI);
 				break;
 			}
 			case IT_SLTIU:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = (((unsigned int)%s) < %d) ? 1 : 0;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), aInstruction.iSI);
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = (((unsigned int)%s) < %d) ? 1 : 0;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), aInstruction.iSI);
 				break;
 			}
 			case IT_SLTU:
 			{
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = (((unsigned int)%s) < %s) ? 1 : 0;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRS).c_str(), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = (((unsigned int)%s) < %s) ? 1 : 0;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRS), getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_SRA:
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = ((signed int)%s) >> %d;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str(), aInstruction.uSA);
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = ((signed int)%s) >> %d;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT), aInstruction.uSA);
 				break;
 			case IT_SRL:
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "%s = ((unsigned int)%s) >> %d;\n", getRegVarName(aInstruction.eRD).c_str(), getRegVarName(aInstruction.eRT).c_str(), aInstruction.uSA);
+				aEmitter.indent(uDepth);
+				aEmitter.print("%s = ((unsigned int)%s) >> %d;\n", getRegVarName(aInstruction.eRD), getRegVarName(aInstruction.eRT), aInstruction.uSA);
 				break;
 			case IT_SSNOP:
 				/* Ignore */
 				break;
 			case IT_SW:
 			{
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				char cSign = aInstruction.iSI < 0 ? '-' : '+';
-				fprintf(pDestFile, "*((unsigned int *)(((unsigned int)(%s)) %c %d)) = %s;\n", getRegVarName(aInstruction.eRS).c_str(), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT).c_str());
+				aEmitter.print("*((unsigned int *)(((unsigned int)(%s)) %c %d)) = %s;\n", getRegVarName(aInstruction.eRS), cSign, abs(aInstruction.iSI), getRegVarName(aInstruction.eRT));
 				break;
 			}
 			case IT_XORI:
-				doIndent(pDestFile, uDepth);
+				aEmitter.indent(uDepth);
 				if(aInstruction.eRT == aInstruction.eRS)
 				{
-					fprintf(pDestFile, "%s ^= 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), aInstruction.uUI);
+					aEmitter.print("%s ^= 0x%X;\n", getRegVarName(aInstruction.eRT), aInstruction.uUI);
 				}
 				else
 				{
-					fprintf(pDestFile, "%s = %s ^ 0x%X;\n", getRegVarName(aInstruction.eRT).c_str(), getRegVarName(aInstruction.eRS).c_str(), aInstruction.uUI);
+					aEmitter.print("%s = %s ^ 0x%X;\n", getRegVarName(aInstruction.eRT), getRegVarName(aInstruction.eRS), aInstruction.uUI);
 				}
 				break;
 			default:
-				doIndent(pDestFile, uDepth);
-				fprintf(pDestFile, "/* TODO: %s */\n", getInstrName(aInstruction));
+				aEmitter.indent(uDepth);
+				aEmitter.print("/* TODO: %s */\n", getInstrName(aInstruction));
 				break;
 		}
 
 		if(!bBranchAllowed)
 		{
-			M_ASSERT(aInstruction.collIfBranch.size() == 0);
-			M_ASSERT(aInstruction.collElseBranch.size() == 0);
+			M_ASSERT(!aGraph.hasIfBranch(aPos));
+			M_ASSERT(!aGraph.hasElseBranch(aPos));
 		}
 		else
 		{
-			if(aInstruction.collIfBranch.size() > 0)
+			if(aGraph.hasIfBranch(aPos))
 			{
-				fprintf(pDestFile, "%s{\n", getIndentStr(uDepth).c_str());
-				generateInstructionCode(pDestFile, aInstruction.collIfBranch, uDepth + 1);
-				fprintf(pDestFile, "%s}\n", getIndentStr(uDepth).c_str());
+				aEmitter.indent(uDepth);
+				aEmitter.print("{\n");
+				generateInstructionCode(aEmitter, aGraph, aValues, aGraph.getIfBranch(aPos), uDepth + 1);
+				aEmitter.indent(uDepth);
+				aEmitter.print("}\n");
 
-				if(aInstruction.collElseBranch.size() > 0)
+				if(aGraph.hasElseBranch(aPos))
 				{
-					fprintf(pDestFile, "%selse\n", getIndentStr(uDepth).c_str());
-					fprintf(pDestFile, "%s{\n", getIndentStr(uDepth).c_str());
-					generateInstructionCode(pDestFile, aInstruction.collElseBranch, uDepth + 1);
-					fprintf(pDestFile, "%s}\n", getIndentStr(uDepth).c_str());
+					aEmitter.indent(uDepth);
+					aEmitter.print("else\n");
+					aEmitter.indent(uDepth);
+					aEmitter.print("{\n");
+					generateInstructionCode(aEmitter, aGraph, aValues, aGraph.getElseBranch(aPos), uDepth + 1);
+					aEmitter.indent(uDepth);
+					aEmitter.print("}\n");
 				}
 
-				fprintf(pDestFile, "\n");
+				aEmitter.print("\n");
 			}
 			else
 			{
@@ -388,40 +396,61 @@ void generateInstructionCode(FILE *pDestFile, const tInstList &collInstList, uns
 			}
 		}
 
-		itCurr++;
+		aGraph.next(aPos);
 	}
 }
 
-void generateCode(FILE *pDestFile, const Function &aFunction)
+/* Variable arguments come without type info, types of pointers to */
+/* pointers already end with a '*'                                   */
+static void printDeclaration(CodeEmitter &aEmitter, const tParameter &aParameter, const char *pName)
 {
-	fprintf(pDestFile, "#include \"../mipsdec_helper.h\"\n\n");
-	fprintf(pDestFile, "/* Optimization passes: %4d */\n", aFunction.uOptimizationPasses);
-	fprintf(pDestFile, "/* Stack offset.......: %4d */\n", aFunction.uStackOffset);
+	if(!aParameter.pInfo)
+	{
+		aEmitter.print("%s", pName);
+		return;
+	}
+
+	const char *pTypeName = aParameter.pInfo->pName;
+	size_t uLength = strlen(pTypeName);
+
+	aEmitter.print("%s%s%s%s%s",
+		(aParameter.uFlags & TF_CONST) ? "const " : "",
+		pTypeName,
+		(uLength && (pTypeName[uLength - 1] == '*')) ? "" : " ",
+		(aParameter.uFlags & TF_BY_REFERENCE) ? "*" : "",
+		pName);
+}
+
+void generateCode(CodeEmitter &aEmitter, const Function &aFunction)
+{
+	RegisterValues aValues;
+	aValues.analyze(aFunction.m_aGraph);
+
+	aEmitter.print("#include \"../mipsdec_helper.h\"\n\n");
+	aEmitter.print("/* Optimization passes: %4d */\n", aFunction.uOptimizationPasses);
+	aEmitter.print("/* Stack offset.......: %4d */\n", aFunction.uStackOffset);
 
-	tParameter *pParams = getFunctionParameters(aFunction.strName);
+	const tParameter *pParams = FunctionSignatures::lookup(aFunction.strName);
 
 	if(!pParams)
 	{
-		fprintf(pDestFile, "void %s(void)\n", aFunction.strName.c_str());
+		aEmitter.print("void %s(void)\n", aFunction.strName.c_str());
 	}
 	else
 	{
-		fprintf(pDestFile, "%s %s(", pParams[0].pInfo->pName, aFunction.strName.c_str());
+		printDeclaration(aEmitter, pParams[0], aFunction.strName.c_str());
+		aEmitter.print("(");
 		unsigned uIdx = 1;
 		while(pParams[uIdx].pName)
 		{
-			fprintf(pDestFile, "%s%s%s %s%s", 
-				(uIdx > 1) ? ", " : "",
-				(pParams[uIdx].uFlags & TF_CONST) ? "const " : "",
-				pParams[uIdx].pInfo->pName,
-				(pParams[uIdx].uFlags & TF_BY_REFERENCE) ? "*" : "",
-				pParams[uIdx].pName);
+			aEmitter.print((uIdx > 1) ? ", " : "");
+			printDeclaration(aEmitter, pParams[uIdx], pParams[uIdx].pName);
 			uIdx++;
 		}
-		fprintf(pDestFile, ")\n");
+		aEmitter.print("%s)\n", (uIdx > 1) ? "" : "void");
 	}
 
-	fprintf(pDestFile, "{\n");
-	generateInstructionCode(pDestFile, aFunction.m_collInstList, 1);
-	fprintf(pDestFile, "}\n");
+	aEmitter.print("{\n");
+	generateInstructionCode(aEmitter, aFunction.m_aGraph, aValues, ControlFlowGraph::getBody(), 1);
+	aEmitter.print("}\n");
 }
@@ -2,7 +2,8 @@
 #define CODEGEN_H
 
 #include "function.h"
+#include "emitter.h"
 
-void generateCode(FILE *pDestFile, const Function &aFunction);
+void generateCode(CodeEmitter &aEmitter, const Function &aFunction);
 
 #endif
@@ -0,0 +1,25 @@
+#include "common.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#ifndef _WIN32
+void __doFail(const char *pCondition, const char *pFile, const char *pFunction, unsigned int uLine)
+{
+	printf("Assertion (%s) failed in file: %s, function: %s, line %d\n", pCondition, pFile, pFunction, uLine);
+}
+#endif
+
+void createDirectory(const std::string &strDir)
+{
+#ifdef _WIN32
+	_mkdir(strDir.c_str());
+#else
+	mkdir(strDir.c_str(), 0755);
+#endif
+}
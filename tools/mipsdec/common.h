@@ -1,6 +1,8 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <string>
+
 #ifdef _WIN32
 #include <assert.h>
 #define M_ASSERT(x) assert(x)
@@ -10,4 +12,7 @@ void __doFail(const char *pCondition, const char *pFile, const char *pFunction,
 #define M_ASSERT(x) if(!(x)) __doFail(#x, __FILE__, __FUNCTION__, __LINE__)
 #endif
 
+/* Existing directories are left alone */
+void createDirectory(const std::string &strDir);
+
 #endif
@@ -0,0 +1,360 @@
+#include "dataflow.h"
+#include "common.h"
+#include <deque>
+#include <algorithm>
+
+/* Registers a called function may change */
+static const tRegister s_aCallerSaved[] =
+{
+	R_AT, R_V0, R_V1, R_A0, R_A1, R_A2, R_A3,
+	R_T0, R_T1, R_T2, R_T3, R_T4, R_T5, R_T6, R_T7, R_T8, R_T9,
+	R_RA
+};
+
+void RegisterValues::initState(tRegisterState &aState, tRegisterValueKind eKind)
+{
+	for(unsigned uIdx = 0; uIdx < R_UNKNOWN; uIdx++)
+	{
+		aState.aRegisters[uIdx].eKind = eKind;
+		aState.aRegisters[uIdx].uValue = 0;
+	}
+}
+
+/* Returns true if aDest has changed */
+bool RegisterValues::mergeState(tRegisterState &aDest, const tRegisterState &aSource)
+{
+	bool bChanged = false;
+
+	for(unsigned uIdx = 0; uIdx < R_UNKNOWN; uIdx++)
+	{
+		tRegisterValue &aDestValue = aDest.aRegisters[uIdx];
+		const tRegisterValue &aSourceValue = aSource.aRegisters[uIdx];
+
+		if((aSourceValue.eKind == RV_UNDEFINED) || (aDestValue.eKind == RV_UNKNOWN))
+		{
+			continue;
+		}
+
+		if(aDestValue.eKind == RV_UNDEFINED)
+		{
+			aDestValue = aSourceValue;
+			bChanged = true;
+		}
+		else if((aSourceValue.eKind == RV_UNKNOWN) || (aSourceValue.uValue != aDestValue.uValue))
+		{
+			aDestValue.eKind = RV_UNKNOWN;
+			bChanged = true;
+		}
+	}
+
+	return bChanged;
+}
+
+void RegisterValues::setConstant(tRegisterState &aState, tRegister eRegister, unsigned uValue)
+{
+	if(eRegister != R_ZERO)
+	{
+		aState.aRegisters[eRegister].eKind = RV_CONSTANT;
+		aState.aRegisters[eRegister].uValue = uValue;
+	}
+}
+
+void RegisterValues::setUnknown(tRegisterState &aState, tRegister eRegister)
+{
+	if(eRegister != R_ZERO)
+	{
+		aState.aRegisters[eRegister].eKind = RV_UNKNOWN;
+	}
+}
+
+void RegisterValues::transfer(tRegisterState &aState, const Instruction &aInstruction)
+{
+	const tRegisterValue *pRS = (aInstruction.eRS < R_UNKNOWN) ? &aState.aRegisters[aInstruction.eRS] : NULL;
+	const tRegisterValue *pRT = (aInstruction.eRT < R_UNKNOWN) ? &aState.aRegisters[aInstruction.eRT] : NULL;
+	bool bConstRS = pRS && (pRS->eKind == RV_CONSTANT);
+	bool bConstRT = pRT && (pRT->eKind == RV_CONSTANT);
+
+	switch(aInstruction.eType)
+	{
+		case IT_LUI:
+			setConstant(aState, aInstruction.eRT, aInstruction.uUI << 16);
+			return;
+		case IT_ADDIU:
+			if(bConstRS)
+			{
+				setConstant(aState, aInstruction.eRT, pRS->uValue + aInstruction.iSI);
+				return;
+			}
+			break;
+		case IT_ORI:
+			if(bConstRS)
+			{
+				setConstant(aState, aInstruction.eRT, pRS->uValue | aInstruction.uUI);
+				return;
+			}
+			break;
+		case IT_ADDU:
+			if(bConstRS && bConstRT)
+			{
+				setConstant(aState, aInstruction.eRD, pRS->uValue + pRT->uValue);
+				return;
+			}
+			break;
+		case IT_SUBU:
+			if(bConstRS && bConstRT)
+			{
+				setConstant(aState, aInstruction.eRD, pRS->uValue - pRT->uValue);
+				return;
+			}
+			break;
+		case IT_OR:
+			if(bConstRS && bConstRT)
+			{
+				setConstant(aState, aInstruction.eRD, pRS->uValue | pRT->uValue);
+				return;
+			}
+			break;
+		case IT_JALR:
+		case IT_JALR_HB:
+			for(unsigned uIdx = 0; uIdx < (sizeof(s_aCallerSaved) / sizeof(s_aCallerSaved[0])); uIdx++)
+			{
+				setUnknown(aState, s_aCallerSaved[uIdx]);
+			}
+			break;
+		default:
+			break;
+	}
+
+	for(unsigned uIdx = R_ZERO + 1; uIdx < R_UNKNOWN; uIdx++)
+	{
+		if(aInstruction.modifiesRegister((tRegister)uIdx))
+		{
+			setUnknown(aState, (tRegister)uIdx);
+		}
+	}
+}
+
+/* Block reached after leaving the instruction at aPos without a jump, */
+/* BLOCK_NONE if the function returns there                           */
+tBlockIdx RegisterValues::getContinuation(const ControlFlowGraph &aGraph, tInstPos aPos) const
+{
+	for(;;)
+	{
+		tBlockIdx uBlock = aPos.uBlock;
+		aGraph.next(aPos);
+
+		if(!ControlFlowGraph::isEnd(aPos))
+		{
+			return aPos.uBlock;
+		}
+
+		/* End of an if/else branch, go on behind the owner */
+		tBlockIdx uOwner = aGraph.getOwner(uBlock);
+
+		if(uOwner == BLOCK_NONE)
+		{
+			return BLOCK_NONE;
+		}
+
+		aPos = aGraph.getBlockLast(uOwner);
+	}
+}
+
+void RegisterValues::getSuccessors(const ControlFlowGraph &aGraph, tBlockIdx uBlock, std::vector<tBlockIdx> &collSuccessors) const
+{
+	tInstPos aLast = aGraph.getBlockLast(uBlock);
+	const Instruction &aInstruction = aGraph.get(aLast);
+
+	collSuccessors.clear();
+
+	if((aInstruction.uJumpAddress != 0) && (!aInstruction.bIgnoreJump))
+	{
+		aGraph.lookupBlocks(aInstruction.uJumpAddress, collSuccessors);
+	}
+
+	switch(aInstruction.eType)
+	{
+		case IT_J:
+		case IT_JR:
+		case IT_JR_HB:
+			return;
+		default:
+			break;
+	}
+
+	if(aGraph.hasIfBranch(aLast) || aGraph.hasElseBranch(aLast))
+	{
+		tRegionRef aIfRegion = aGraph.getIfBranch(aLast);
+		tRegionRef aElseRegion = aGraph.getElseBranch(aLast);
+
+		collSuccessors.push_back(aGraph.isEmpty(aIfRegion) ? getContinuation(aGraph, aLast) : aGraph.getBegin(aIfRegion).uBlock);
+		collSuccessors.push_back(aGraph.isEmpty(aElseRegion) ? getContinuation(aGraph, aLast) : aGraph.getBegin(aElseRegion).uBlock);
+	}
+	else
+	{
+		collSuccessors.push_back(getContinuation(aGraph, aLast));
+	}
+}
+
+void RegisterValues::analyze(const ControlFlowGraph &aGraph)
+{
+	std::vector<tBlockIdx> collBlocks;
+	tBlockIdx uNumBlocks = 0;
+
+	m_collOperands.clear();
+	m_collBlockStart.clear();
+	aGraph.getBlocks(ControlFlowGraph::getBody(), collBlocks);
+
+	if(collBlocks.size() == 0)
+	{
+		return;
+	}
+
+	for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+	{
+		uNumBlocks = std::max(uNumBlocks, collBlocks[uIdx] + 1);
+	}
+
+	std::vector<tRegisterState> collEntryStates(uNumBlocks);
+	std::vector<bool> collReached(uNumBlocks, false);
+	std::vector<bool> collQueued(uNumBlocks, false);
+	std::vector<tBlockIdx> collSuccessors;
+	std::deque<tBlockIdx> collWorklist;
+	unsigned uNextSeed = 0;
+
+	for(;;)
+	{
+		/* Start at the function entry. Code only reached through computed */
+		/* jumps is started with nothing known afterwards                  */
+		while((uNextSeed < collBlocks.size()) && (collReached[collBlocks[uNextSeed]]))
+		{
+			uNextSeed++;
+		}
+
+		if(uNextSeed == collBlocks.size())
+		{
+			break;
+		}
+
+		tBlockIdx uSeed = collBlocks[uNextSeed];
+
+		initState(collEntryStates[uSeed], RV_UNKNOWN);
+		collEntryStates[uSeed].aRegisters[R_ZERO].eKind = RV_CONSTANT;
+		collReached[uSeed] = true;
+		collQueued[uSeed] = true;
+		collWorklist.push_back(uSeed);
+
+		while(collWorklist.size() > 0)
+		{
+			tBlockIdx uBlock = collWorklist.front();
+			tRegisterState aState = collEntryStates[uBlock];
+
+			collWorklist.pop_front();
+			collQueued[uBlock] = false;
+
+			for(tInstPos aPos = aGraph.getBlockBegin(uBlock); aPos.uBlock == uBlock; aGraph.next(aPos))
+			{
+				transfer(aState, aGraph.get(aPos));
+			}
+
+			getSuccessors(aGraph, uBlock, collSuccessors);
+
+			for(unsigned uIdx = 0; uIdx < collSuccessors.size(); uIdx++)
+			{
+				tBlockIdx uSuccessor = collSuccessors[uIdx];
+
+				if(uSuccessor == BLOCK_NONE)
+				{
+					continue;
+				}
+
+				if(!collReached[uSuccessor])
+				{
+					initState(collEntryStates[uSuccessor], RV_UNDEFINED);
+					collReached[uSuccessor] = true;
+				}
+
+				if((mergeState(collEntryStates[uSuccessor], aState)) && (!collQueued[uSuccessor]))
+				{
+					collQueued[uSuccessor] = true;
+					collWorklist.push_back(uSuccessor);
+				}
+			}
+		}
+	}
+
+	/* Record the operands on a last walk through the reached blocks */
+	unsigned uNumInstructions = 0;
+
+	for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+	{
+		uNumInstructions += aGraph.getBlockLast(collBlocks[uIdx]).uIdx + 1;
+	}
+
+	m_collOperands.reserve(uNumInstructions);
+	m_collBlockStart.assign(uNumBlocks, 0);
+
+	for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+	{
+		tBlockIdx uBlock = collBlocks[uIdx];
+
+		tRegisterState aState = collEntryStates[uBlock];
+
+		m_collBlockStart[uBlock] = m_collOperands.size();
+
+		for(tInstPos aPos = aGraph.getBlockBegin(uBlock); aPos.uBlock == uBlock; aGraph.next(aPos))
+		{
+			const Instruction &aInstruction = aGraph.get(aPos);
+			tOperandValues aOperands;
+
+			aOperands.eRS = aInstruction.eRS;
+			aOperands.eRT = aInstruction.eRT;
+			aOperands.aRS.eKind = RV_UNKNOWN;
+			aOperands.aRT.eKind = RV_UNKNOWN;
+
+			if(aInstruction.eRS < R_UNKNOWN)
+			{
+				aOperands.aRS = aState.aRegisters[aInstruction.eRS];
+			}
+
+			if(aInstruction.eRT < R_UNKNOWN)
+			{
+				aOperands.aRT = aState.aRegisters[aInstruction.eRT];
+			}
+
+			m_collOperands.push_back(aOperands);
+			transfer(aState, aInstruction);
+		}
+	}
+}
+
+/* Constant value of the source operand eRegister of the instruction */
+/* at aPos, only valid until the graph is modified                    */
+bool RegisterValues::getValue(const tInstPos &aPos, tRegister eRegister, unsigned &uValue) const
+{
+	if(aPos.uBlock >= m_collBlockStart.size())
+	{
+		return false;
+	}
+
+	const tOperandValues &aOperands = m_collOperands[m_collBlockStart[aPos.uBlock] + aPos.uIdx];
+	const tRegisterValue *pValue = NULL;
+
+	if(aOperands.eRS == eRegister)
+	{
+		pValue = &aOperands.aRS;
+	}
+	else if(aOperands.eRT == eRegister)
+	{
+		pValue = &aOperands.aRT;
+	}
+
+	if((!pValue) || (pValue->eKind != RV_CONSTANT))
+	{
+		return false;
+	}
+
+	uValue = pValue->uValue;
+
+	return true;
+}
@@ -0,0 +1,64 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <vector>
+#include "instruction.h"
+#include "cfg.h"
+
+/* Lattice value of a register: not reached yet, a known constant or */
+/* anything                                                          */
+typedef enum
+{
+	RV_UNDEFINED = 0,
+	RV_CONSTANT,
+	RV_UNKNOWN
+} tRegisterValueKind;
+
+typedef struct
+{
+	tRegisterValueKind eKind;
+	unsigned uValue;
+} tRegisterValue;
+
+/* Values of all registers at one point of the function */
+typedef struct
+{
+	tRegisterValue aRegisters[R_UNKNOWN];
+} tRegisterState;
+
+/* Values of the source operands of one instruction */
+typedef struct
+{
+	tRegister eRS;
+	tRegisterValue aRS;
+	tRegister eRT;
+	tRegisterValue aRT;
+} tOperandValues;
+
+/* Constant propagation over the whole function. The register states  */
+/* are propagated forward along the control flow (fall through, if/else */
+/* branches and jumps) until nothing changes anymore. Afterwards every  */
+/* instruction knows the constant values of its RS and RT operands, so  */
+/* codegen can look them up without walking the code again.             */
+class RegisterValues
+{
+public:
+	void analyze(const ControlFlowGraph &aGraph);
+	bool getValue(const tInstPos &aPos, tRegister eRegister, unsigned &uValue) const;
+
+private:
+	static void initState(tRegisterState &aState, tRegisterValueKind eKind);
+	static bool mergeState(tRegisterState &aDest, const tRegisterState &aSource);
+	static void setConstant(tRegisterState &aState, tRegister eRegister, unsigned uValue);
+	static void setUnknown(tRegisterState &aState, tRegister eRegister);
+	static void transfer(tRegisterState &aState, const Instruction &aInstruction);
+	void getSuccessors(const ControlFlowGraph &aGraph, tBlockIdx uBlock, std::vector<tBlockIdx> &collSuccessors) const;
+	tBlockIdx getContinuation(const ControlFlowGraph &aGraph, tInstPos aPos) const;
+
+	/* Operands of all instructions, block by block. m_collBlockStart */
+	/* holds the index of the first instruction of each block          */
+	std::vector<tOperandValues> m_collOperands;
+	std::vector<unsigned> m_collBlockStart;
+};
+
+#endif
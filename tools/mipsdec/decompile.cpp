@@ -0,0 +1,119 @@
+#include "decompile.h"
+#include "instruction.h"
+#include "codegen.h"
+#include "optimize.h"
+#include "function.h"
+#include "profile.h"
+#include "timer.h"
+#include "cache.h"
+#include "common.h"
+#include <stdio.h>
+
+/* Runs the complete pipeline for a single function. Everything mutable */
+/* lives in the local Function object, so this may be called from       */
+/* several threads at once as long as the symbols and the image are     */
+/* not modified anymore. The time of every phase and the optimizer      */
+/* statistics are added to pProfile, which must not be shared between   */
+/* threads. With a cache, unchanged functions skip everything but     */
+/* reading their code from the image.                                   */
+bool decompileFunction(const std::string &strFuncName, const BinaryImage &aImage, const std::string &strCodeFile, Profile *pProfile,
+	const DecompileCache *pCache)
+{
+	Function aFunction;
+	Profile aProfile;
+	CodeEmitter aEmitter;
+	double dStartTime = getTimeSeconds();
+	double dPhaseTime;
+	unsigned uAddress;
+	std::vector<unsigned> collWords;
+	tCacheKey uCacheKey = 0;
+
+	if(!Function::readFromImage(strFuncName, aImage, uAddress, collWords))
+	{
+		return false;
+	}
+
+	if(pCache)
+	{
+		uCacheKey = DecompileCache::getKey(strFuncName, uAddress, collWords);
+		aProfile.uNumCacheLookups = 1;
+
+		if(pCache->load(uCacheKey, aEmitter))
+		{
+			if(!aEmitter.flush(strCodeFile))
+			{
+				printf("Can't create code file: %s\n", strCodeFile.c_str());
+				return false;
+			}
+
+			aProfile.aPhaseTimes[PP_CODEGEN] = getTimeSeconds() - dStartTime;
+			aProfile.uNumCacheHits = 1;
+			aProfile.uNumFunctions = 1;
+			aProfile.uNumInstructions = (unsigned)collWords.size();
+
+			if(pProfile)
+			{
+				pProfile->add(aProfile);
+			}
+
+			return true;
+		}
+	}
+
+	if(!aFunction.parse(strFuncName, uAddress, collWords))
+	{
+		return false;
+	}
+
+	dPhaseTime = getTimeSeconds();
+	aProfile.aPhaseTimes[PP_PARSE] = dPhaseTime - dStartTime;
+	dStartTime = dPhaseTime;
+
+	//dumpInstructions(aFunction.m_aGraph, ControlFlowGraph::getBody());
+	resolveDelaySlots(aFunction.m_aGraph);
+	//dumpInstructions(aFunction.m_aGraph, ControlFlowGraph::getBody());
+
+	dPhaseTime = getTimeSeconds();
+	aProfile.aPhaseTimes[PP_DELAY_SLOTS] = dPhaseTime - dStartTime;
+	dStartTime = dPhaseTime;
+
+	aFunction.detectStackOffset();
+	aFunction.m_aGraph.updateJumpTargets();
+
+	dPhaseTime = getTimeSeconds();
+	aProfile.aPhaseTimes[PP_ANALYSIS] = dPhaseTime - dStartTime;
+	dStartTime = dPhaseTime;
+
+	optimizeInstructions(aFunction, aProfile.aOptimizer);
+
+	dPhaseTime = getTimeSeconds();
+	aProfile.aPhaseTimes[PP_OPTIMIZE] = dPhaseTime - dStartTime;
+	dStartTime = dPhaseTime;
+
+	//dumpInstructions(aFunction.m_aGraph, ControlFlowGraph::getBody());
+
+	generateCode(aEmitter, aFunction);
+
+	if(!aEmitter.flush(strCodeFile))
+	{
+		printf("Can't create code file: %s\n", strCodeFile.c_str());
+		return false;
+	}
+
+	/* A failed store only costs the next run some time */
+	if(pCache)
+	{
+		pCache->store(uCacheKey, aEmitter);
+	}
+
+	aProfile.aPhaseTimes[PP_CODEGEN] = getTimeSeconds() - dStartTime;
+	aProfile.uNumFunctions = 1;
+	aProfile.uNumInstructions = aFunction.uNumInstructions;
+
+	if(pProfile)
+	{
+		pProfile->add(aProfile);
+	}
+
+	return true;
+}
@@ -0,0 +1,14 @@
+#ifndef DECOMPILE_H
+#define DECOMPILE_H
+
+#include <string>
+#include <stddef.h>
+#include "image.h"
+
+class Profile;
+class DecompileCache;
+
+bool decompileFunction(const std::string &strFuncName, const BinaryImage &aImage, const std::string &strCodeFile, Profile *pProfile = NULL,
+	const DecompileCache *pCache = NULL);
+
+#endif
@@ -0,0 +1,141 @@
+#include "emitter.h"
+#include "common.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define vsnprintf _vsnprintf
+#endif
+
+#define EMITTER_INITIAL_SIZE	4096
+
+/* Longest indent handed out in one piece, deeper ones take more copies */
+static const char s_pTabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+#define MAX_INDENT_CHUNK	(sizeof(s_pTabs) - 1)
+
+CodeEmitter::CodeEmitter(void) :
+		m_collBuffer(EMITTER_INITIAL_SIZE),
+		m_uSize(0)
+{
+}
+
+void CodeEmitter::grow(size_t uMinSize)
+{
+	size_t uNewSize = m_collBuffer.size() * 2;
+
+	while(uNewSize < uMinSize)
+	{
+		uNewSize *= 2;
+	}
+
+	m_collBuffer.resize(uNewSize);
+}
+
+/* Formats straight into the buffer, only retried after growing it. The */
+/* Windows vsnprintf returns -1 instead of the needed length.           */
+void CodeEmitter::print(const char *pFormat, ...)
+{
+	while(true)
+	{
+		size_t uSpace = m_collBuffer.size() - m_uSize;
+		va_list aArgs;
+
+		va_start(aArgs, pFormat);
+		int iLength = vsnprintf(&m_collBuffer[m_uSize], uSpace, pFormat, aArgs);
+		va_end(aArgs);
+
+		if((iLength >= 0) && ((size_t)iLength < uSpace))
+		{
+			m_uSize += iLength;
+			return;
+		}
+
+		grow((iLength >= 0) ? (m_uSize + iLength + 1) : (m_collBuffer.size() + 1));
+	}
+}
+
+void CodeEmitter::indent(unsigned uDepth)
+{
+	if((m_uSize + uDepth) >= m_collBuffer.size())
+	{
+		grow(m_uSize + uDepth + 1);
+	}
+
+	while(uDepth > 0)
+	{
+		unsigned uChunk = (uDepth < MAX_INDENT_CHUNK) ? uDepth : MAX_INDENT_CHUNK;
+
+		memcpy(&m_collBuffer[m_uSize], s_pTabs, uChunk);
+		m_uSize += uChunk;
+		uDepth -= uChunk;
+	}
+}
+
+void CodeEmitter::write(const char *pData, size_t uSize)
+{
+	if((m_uSize + uSize) >= m_collBuffer.size())
+	{
+		grow(m_uSize + uSize + 1);
+	}
+
+	memcpy(&m_collBuffer[m_uSize], pData, uSize);
+	m_uSize += uSize;
+}
+
+bool CodeEmitter::flush(const std::string &strFileName) const
+{
+	FILE *pFile = fopen(strFileName.c_str(), "w");
+
+	if(!pFile)
+	{
+		return false;
+	}
+
+	bool bResult = (fwrite(&m_collBuffer[0], 1, m_uSize, pFile) == m_uSize);
+
+	if(fclose(pFile) != 0)
+	{
+		bResult = false;
+	}
+
+	return bResult;
+}
+
+/* Filled during static initialization like the decode tables, so the */
+/* names are read-only before any worker runs                          */
+class RegVarNames
+{
+public:
+	RegVarNames(void)
+	{
+		for(unsigned uRegister = 0; uRegister < R_UNKNOWN; uRegister++)
+		{
+			m_pNames[uRegister] = (uRegister == R_ZERO) ? "" : "REG_";
+			m_pNames[uRegister] += getRegName((tRegister)uRegister);
+		}
+
+		m_pNames[R_UNKNOWN] = "REG_<UNKN>";
+	}
+
+	const char *get(tRegister eRegister) const
+	{
+		return m_pNames[eRegister].c_str();
+	}
+
+private:
+	std::string m_pNames[R_UNKNOWN + 1];
+};
+
+static const RegVarNames s_RegVarNames;
+
+const char *getRegVarName(tRegister eRegister)
+{
+	if(eRegister >= R_UNKNOWN)
+	{
+		M_ASSERT(false);
+		return s_RegVarNames.get(R_UNKNOWN);
+	}
+
+	return s_RegVarNames.get(eRegister);
+}
@@ -0,0 +1,40 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <string>
+#include <vector>
+#include "register.h"
+
+/* Collects the generated code of one function in memory. Every function */
+/* gets its own emitter, so functions can be emitted from several        */
+/* threads at once. The file is written with a single call at the end.   */
+class CodeEmitter
+{
+public:
+	CodeEmitter(void);
+
+	void print(const char *pFormat, ...);
+	void indent(unsigned uDepth);
+	void write(const char *pData, size_t uSize);
+	bool flush(const std::string &strFileName) const;
+
+	const char *getData(void) const { return &m_collBuffer[0]; }
+	size_t getSize(void) const { return m_uSize; }
+
+	/* Addresses the code looked up in the symbols, the code is only */
+	/* valid as long as they resolve to the same names               */
+	void referenceSymbol(unsigned uAddress) { m_collSymbolRefs.push_back(uAddress); }
+	const std::vector<unsigned> &getSymbolReferences(void) const { return m_collSymbolRefs; }
+
+private:
+	void grow(size_t uMinSize);
+
+	std::vector<char> m_collBuffer;
+	size_t m_uSize;
+	std::vector<unsigned> m_collSymbolRefs;
+};
+
+/* Name of the variable holding a register, built once for all registers */
+const char *getRegVarName(tRegister eRegister);
+
+#endif
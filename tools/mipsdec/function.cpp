@@ -3,38 +3,46 @@
 
 void Function::detectStackOffset(void)
 {
-	tInstList::const_iterator itCurr = m_collInstList.begin();
-	tInstList::const_iterator itEnd = m_collInstList.end();
+	tInstPos aPos = m_aGraph.getBegin(ControlFlowGraph::getBody());
 
-	while(itCurr != itEnd)
+	while(!ControlFlowGraph::isEnd(aPos))
 	{
-		if(itCurr->modifiesRegister(R_SP))
+		const Instruction &aInstruction = m_aGraph.get(aPos);
+
+		if(aInstruction.modifiesRegister(R_SP))
 		{
-			M_ASSERT(itCurr->eType == IT_ADDIU);
-			M_ASSERT(itCurr->iSI < 0);
+			M_ASSERT(aInstruction.eType == IT_ADDIU);
+			M_ASSERT(aInstruction.iSI < 0);
 
-			uStackOffset = abs(itCurr->iSI);
+			uStackOffset = abs(aInstruction.iSI);
 			bHasStackOffset = true;
 
 			return;
 		}
 
-		itCurr++;
+		m_aGraph.next(aPos);
 	}
 
 	uStackOffset = 0;
 	bHasStackOffset = false;
 }
 
-static unsigned calcSymFileOffset(unsigned uSymAddress)
+bool Function::parseFromImage(const std::string &strFuncName, const BinaryImage &aImage)
 {
-	return uSymAddress - 0x80000000;
+	unsigned uAddress;
+	std::vector<unsigned> collWords;
+
+	if(!readFromImage(strFuncName, aImage, uAddress, collWords))
+	{
+		return false;
+	}
+
+	return parse(strFuncName, uAddress, collWords);
 }
 
-bool Function::parseFromFile(const std::string &strFuncName, const std::string &strBinFile)
+bool Function::readFromImage(const std::string &strFuncName, const BinaryImage &aImage, unsigned &uAddress, std::vector<unsigned> &collWords)
 {
 	unsigned uSymIdx;
-	strName = strFuncName;
 
 	if(!Symbols::lookup(strFuncName, uSymIdx))
 	{
@@ -42,139 +50,57 @@ bool Function::parseFromFile(const std::string &strFuncName, const std::string &
 		return false;
 	}
 
-	unsigned uInstructionCount;
+	uAddress = Symbols::get(uSymIdx)->uAddress;
+	unsigned uEndAddress;
+	unsigned uNextAddress;
 
-	if((uSymIdx + 1) == Symbols::getCount())
-	{
-		M_ASSERT(false); // FIXME: TODO
-		uInstructionCount = 0;
-	}
-	else
-	{
-		uInstructionCount = (Symbols::get(uSymIdx + 1)->uAddress - Symbols::get(uSymIdx)->uAddress) / 4;
-	}
-	
-	FILE *pBinFile = fopen(strBinFile.c_str(), "rb");
-	
-	if(!pBinFile)
+	/* Functions end at the next symbol above them or at the end of the segment */
+	if(!aImage.getSegmentEnd(uAddress, uEndAddress))
 	{
-		printf("Can't open binary file: %s\n", strBinFile.c_str());
+		printf("Function %s is not part of the binary file\n", strFuncName.c_str());
 		return false;
 	}
-	
-	fseek(pBinFile, calcSymFileOffset(Symbols::get(uSymIdx)->uAddress), SEEK_SET);
-	
-	for(unsigned uInstructionIdx = 0; uInstructionIdx < uInstructionCount; uInstructionIdx++)
-	{
-		unsigned uData = 0;
-
-		for(unsigned uByteIdx = 0; uByteIdx < sizeof(uData); uByteIdx++)
-		{
-			unsigned char uByte;
-
-			if(fread(&uByte, 1, sizeof(uByte), pBinFile) != sizeof(uByte))
-			{
-				printf("Short binary file read!\n");
-				return false;
-			}
-			
-			uData = (uData >> 8) | (uByte << 24);
-		}
-		
-		Instruction aInstruction;
-
-		aInstruction.eFormat = IF_UNKNOWN;
-
-		if(!aInstruction.parse(uData, Symbols::get(uSymIdx)->uAddress + (4 * uInstructionIdx)))
-		{
-			return false;
-		}
-		else
-		{
-			m_collInstList.push_back(aInstruction);
-		}
-	}
-	
-	fclose(pBinFile);
-
-	return true;
-}
 
-void Function::applyDelayedDeletes(void)
-{
-	while(applyDelayedDeletesRecursive(m_collInstList))
+	if((Symbols::getNextAddress(uAddress, uNextAddress)) && (uNextAddress < uEndAddress))
 	{
+		uEndAddress = uNextAddress;
 	}
-}
 
-bool Function::applyDelayedDeletesRecursive(tInstList &collInstList)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
+	if(!aImage.readWords(uAddress, (uEndAddress - uAddress) / 4, collWords))
 	{
-		if(itCurr->bDelayedDelete)
-		{
-			M_ASSERT(itCurr->collInsertAfter.size() == 0);
-			collInstList.erase(itCurr);
-
-			return true;
-		}
-
-		if(applyDelayedDeletesRecursive(itCurr->collIfBranch))
-		{
-			return true;
-		}
-
-		if(applyDelayedDeletesRecursive(itCurr->collElseBranch))
-		{
-			return true;
-		}
-
-		itCurr++;
+		printf("Short binary file read!\n");
+		return false;
 	}
 
-	return false;
+	return true;
 }
 
-void Function::applyDelayedInserts(void)
+bool Function::parse(const std::string &strFuncName, unsigned uAddress, const std::vector<unsigned> &collWords)
 {
-	while(applyDelayedInsertsRecursive(m_collInstList))
-	{
-	}
-}
+	unsigned uInstructionCount = (unsigned)collWords.size();
+	tInstVector collInstructions;
 
-bool Function::applyDelayedInsertsRecursive(tInstList &collInstList)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	strName = strFuncName;
+	collInstructions.reserve(uInstructionCount);
 
-	while(itCurr != itEnd)
+	for(unsigned uInstructionIdx = 0; uInstructionIdx < uInstructionCount; uInstructionIdx++)
 	{
-		if(itCurr->collInsertAfter.size() > 0)
-		{
-			tInstList::iterator itNext = itCurr;
-			itNext++;
-
-			collInstList.insert(itNext, itCurr->collInsertAfter.begin(), itCurr->collInsertAfter.end());
-			itCurr->collInsertAfter.clear();
+		Instruction aInstruction;
 
-			return true;
-		}
+		aInstruction.eFormat = IF_UNKNOWN;
 
-		if(applyDelayedInsertsRecursive(itCurr->collIfBranch))
+		if(!aInstruction.parse(collWords[uInstructionIdx], uAddress + (4 * uInstructionIdx)))
 		{
-			return true;
+			return false;
 		}
-
-		if(applyDelayedInsertsRecursive(itCurr->collElseBranch))
+		else
 		{
-			return true;
+			collInstructions.push_back(aInstruction);
 		}
-
-		itCurr++;
 	}
 
-	return false;
+	m_aGraph.adopt(collInstructions);
+	uNumInstructions = uInstructionCount;
+
+	return true;
 }
@@ -3,33 +3,35 @@
 
 #include <vector>
 #include "instruction.h"
+#include "cfg.h"
 #include "register.h"
 #include "symbols.h"
+#include "image.h"
 
 class Function
 {
 public:
 	Function(void) :
 		bHasStackOffset(false),
+		uNumInstructions(0),
 		uOptimizationPasses(0),
 		uStackOffset(0)
 	{
 	}
 
 	void detectStackOffset(void);
-	bool parseFromFile(const std::string &strFuncName, const std::string &strBinFile);
-	void applyDelayedDeletes(void);
-	void applyDelayedInserts(void);
+	bool parseFromImage(const std::string &strFuncName, const BinaryImage &aImage);
+	bool parse(const std::string &strFuncName, unsigned uAddress, const std::vector<unsigned> &collWords);
 
-	tInstList m_collInstList;
+	/* Code of a function as found in the image, without parsing it */
+	static bool readFromImage(const std::string &strFuncName, const BinaryImage &aImage, unsigned &uAddress, std::vector<unsigned> &collWords);
+
+	ControlFlowGraph m_aGraph;
 	bool bHasStackOffset;
+	unsigned uNumInstructions;
 	unsigned uOptimizationPasses;
 	unsigned uStackOffset;
 	std::string strName;
-
-private:
-	bool applyDelayedDeletesRecursive(tInstList &collInstList);
-	bool applyDelayedInsertsRecursive(tInstList &collInstList);
 };
 
 #endif
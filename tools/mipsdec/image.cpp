@@ -0,0 +1,306 @@
+#include "image.h"
+#include "common.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define ELF_HEADER_SIZE 52
+#define ELF_PHDR_SIZE 32
+#define ELF_CLASS_32 1
+#define ELF_DATA_LSB 1
+#define ELF_DATA_MSB 2
+#define ELF_PT_LOAD 1
+
+BinaryImage::BinaryImage(void) :
+		m_pData(NULL),
+		m_uSize(0),
+#ifndef _WIN32
+		m_pMapping(NULL),
+#endif
+		m_uLoadAddress(IMAGE_DEFAULT_LOAD_ADDRESS),
+		m_bBigEndian(false)
+{
+}
+
+BinaryImage::~BinaryImage(void)
+{
+	unload();
+}
+
+/* Only used for raw images, ELF files bring their own addresses */
+void BinaryImage::setLoadAddress(unsigned uLoadAddress)
+{
+	m_uLoadAddress = uLoadAddress;
+}
+
+/* Only used for raw images, ELF files bring their own byte order */
+void BinaryImage::setBigEndian(bool bBigEndian)
+{
+	m_bBigEndian = bBigEndian;
+}
+
+void BinaryImage::unload(void)
+{
+#ifdef _WIN32
+	m_collData.clear();
+#else
+	if(m_pMapping)
+	{
+		munmap(m_pMapping, m_uSize);
+		m_pMapping = NULL;
+	}
+#endif
+
+	m_pData = NULL;
+	m_uSize = 0;
+	m_collSegments.clear();
+}
+
+bool BinaryImage::mapFile(const std::string &strBinFile)
+{
+#ifdef _WIN32
+	FILE *pBinFile = fopen(strBinFile.c_str(), "rb");
+
+	if(!pBinFile)
+	{
+		printf("Can't open binary file: %s\n", strBinFile.c_str());
+		return false;
+	}
+
+	fseek(pBinFile, 0, SEEK_END);
+	long iFileSize = ftell(pBinFile);
+	fseek(pBinFile, 0, SEEK_SET);
+
+	if(iFileSize > 0)
+	{
+		m_collData.resize(iFileSize);
+
+		if(fread(&m_collData[0], 1, iFileSize, pBinFile) != (size_t)iFileSize)
+		{
+			printf("Short binary file read!\n");
+			m_collData.clear();
+			fclose(pBinFile);
+			return false;
+		}
+
+		m_pData = &m_collData[0];
+		m_uSize = m_collData.size();
+	}
+
+	fclose(pBinFile);
+
+	return true;
+#else
+	int iFile = open(strBinFile.c_str(), O_RDONLY);
+
+	if(iFile < 0)
+	{
+		printf("Can't open binary file: %s\n", strBinFile.c_str());
+		return false;
+	}
+
+	struct stat aStat;
+
+	if(fstat(iFile, &aStat) != 0)
+	{
+		printf("Can't open binary file: %s\n", strBinFile.c_str());
+		close(iFile);
+		return false;
+	}
+
+	/* Empty files can't be mapped */
+	if(aStat.st_size > 0)
+	{
+		void *pMapping = mmap(NULL, aStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+
+		if(pMapping == MAP_FAILED)
+		{
+			printf("Can't map binary file: %s\n", strBinFile.c_str());
+			close(iFile);
+			return false;
+		}
+
+		m_pMapping = pMapping;
+		m_pData = (const unsigned char *)pMapping;
+		m_uSize = aStat.st_size;
+	}
+
+	/* The mapping stays valid without the descriptor */
+	close(iFile);
+
+	return true;
+#endif
+}
+
+bool BinaryImage::load(const std::string &strBinFile)
+{
+	unload();
+
+	if(!mapFile(strBinFile))
+	{
+		return false;
+	}
+
+	if((m_uSize >= ELF_HEADER_SIZE) && (!memcmp(m_pData, "\177ELF", 4)))
+	{
+		if(!parseElfHeader())
+		{
+			printf("Unsupported ELF file: %s\n", strBinFile.c_str());
+			unload();
+			return false;
+		}
+
+		return true;
+	}
+
+	tImageSegment aSegment = { m_uLoadAddress, 0, (unsigned)m_uSize };
+	m_collSegments.push_back(aSegment);
+
+	return true;
+}
+
+size_t BinaryImage::getSize(void) const
+{
+	return m_uSize;
+}
+
+unsigned BinaryImage::readRawWord(size_t uOffset) const
+{
+	const unsigned char *pData = m_pData + uOffset;
+
+	if(m_bBigEndian)
+	{
+		return (pData[0] << 24) | (pData[1] << 16) | (pData[2] << 8) | pData[3];
+	}
+
+	return pData[0] | (pData[1] << 8) | (pData[2] << 16) | (pData[3] << 24);
+}
+
+unsigned short BinaryImage::readRawHalf(size_t uOffset) const
+{
+	const unsigned char *pData = m_pData + uOffset;
+
+	return m_bBigEndian ? ((pData[0] << 8) | pData[1]) : (pData[0] | (pData[1] << 8));
+}
+
+/* Takes the byte order and the PT_LOAD segments from a 32 bit ELF file */
+bool BinaryImage::parseElfHeader(void)
+{
+	if((m_pData[4] != ELF_CLASS_32) || ((m_pData[5] != ELF_DATA_LSB) && (m_pData[5] != ELF_DATA_MSB)))
+	{
+		return false;
+	}
+
+	m_bBigEndian = (m_pData[5] == ELF_DATA_MSB);
+
+	unsigned uPhOffset = readRawWord(0x1C);
+	unsigned uPhEntrySize = readRawHalf(0x2A);
+	unsigned uPhNum = readRawHalf(0x2C);
+
+	if((uPhEntrySize < ELF_PHDR_SIZE) || (uPhOffset > m_uSize) || (((m_uSize - uPhOffset) / uPhEntrySize) < uPhNum))
+	{
+		return false;
+	}
+
+	for(unsigned uIdx = 0; uIdx < uPhNum; uIdx++)
+	{
+		size_t uPhdr = uPhOffset + (uIdx * uPhEntrySize);
+
+		if(readRawWord(uPhdr) != ELF_PT_LOAD)
+		{
+			continue;
+		}
+
+		tImageSegment aSegment;
+
+		aSegment.uOffset = readRawWord(uPhdr + 4);
+		aSegment.uAddress = readRawWord(uPhdr + 8);
+		aSegment.uSize = readRawWord(uPhdr + 16);
+
+		if((aSegment.uOffset > m_uSize) || (aSegment.uSize > (m_uSize - aSegment.uOffset)))
+		{
+			return false;
+		}
+
+		if(aSegment.uSize > 0)
+		{
+			m_collSegments.push_back(aSegment);
+		}
+	}
+
+	return m_collSegments.size() > 0;
+}
+
+const tImageSegment *BinaryImage::findSegment(unsigned uAddress) const
+{
+	for(unsigned uIdx = 0; uIdx < m_collSegments.size(); uIdx++)
+	{
+		const tImageSegment &aSegment = m_collSegments[uIdx];
+
+		if((uAddress >= aSegment.uAddress) && ((uAddress - aSegment.uAddress) < aSegment.uSize))
+		{
+			return &aSegment;
+		}
+	}
+
+	return NULL;
+}
+
+/* End of the data backing uAddress, used as size limit for the last */
+/* function of a segment                                             */
+bool BinaryImage::getSegmentEnd(unsigned uAddress, unsigned &uEndAddress) const
+{
+	const tImageSegment *pSegment = findSegment(uAddress);
+
+	if(!pSegment)
+	{
+		return false;
+	}
+
+	uEndAddress = pSegment->uAddress + pSegment->uSize;
+
+	return true;
+}
+
+/* Decodes uCount instruction words starting at uAddress. The words are */
+/* copied in one go and only byte swapped if the host order differs     */
+bool BinaryImage::readWords(unsigned uAddress, unsigned uCount, std::vector<unsigned> &collWords) const
+{
+	collWords.clear();
+
+	if(!uCount)
+	{
+		return true;
+	}
+
+	const tImageSegment *pSegment = findSegment(uAddress);
+
+	if((!pSegment) || (uCount > ((pSegment->uSize - (uAddress - pSegment->uAddress)) / 4)))
+	{
+		return false;
+	}
+
+	collWords.resize(uCount);
+	memcpy(&collWords[0], m_pData + pSegment->uOffset + (uAddress - pSegment->uAddress), uCount * 4);
+
+	const unsigned uOne = 1;
+	bool bHostBigEndian = (*(const unsigned char *)&uOne == 0);
+
+	if(bHostBigEndian != m_bBigEndian)
+	{
+		for(unsigned uIdx = 0; uIdx < uCount; uIdx++)
+		{
+			unsigned uWord = collWords[uIdx];
+
+			collWords[uIdx] = (uWord >> 24) | ((uWord >> 8) & 0xFF00) | ((uWord << 8) & 0xFF0000) | (uWord << 24);
+		}
+	}
+
+	return true;
+}
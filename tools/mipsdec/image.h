@@ -0,0 +1,58 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <vector>
+#include <string>
+
+#define IMAGE_DEFAULT_LOAD_ADDRESS 0x80000000
+
+/* Part of the file mapped to the address space */
+typedef struct
+{
+	unsigned uAddress;
+	unsigned uOffset;
+	unsigned uSize;
+} tImageSegment;
+
+/* The binary is mapped into memory once and shared by all functions. */
+/* ELF files are mapped according to their program headers, any other */
+/* file is taken as raw image loaded at the load address              */
+class BinaryImage
+{
+public:
+	BinaryImage(void);
+	~BinaryImage(void);
+
+	void setLoadAddress(unsigned uLoadAddress);
+	void setBigEndian(bool bBigEndian);
+	bool load(const std::string &strBinFile);
+	size_t getSize(void) const;
+	bool getSegmentEnd(unsigned uAddress, unsigned &uEndAddress) const;
+	bool readWords(unsigned uAddress, unsigned uCount, std::vector<unsigned> &collWords) const;
+
+private:
+	BinaryImage(const BinaryImage &);
+	BinaryImage &operator=(const BinaryImage &);
+
+	void unload(void);
+	bool mapFile(const std::string &strBinFile);
+	unsigned readRawWord(size_t uOffset) const;
+	unsigned short readRawHalf(size_t uOffset) const;
+	bool parseElfHeader(void);
+	const tImageSegment *findSegment(unsigned uAddress) const;
+
+	const unsigned char *m_pData;
+	size_t m_uSize;
+
+#ifdef _WIN32
+	std::vector<unsigned char> m_collData;
+#else
+	void *m_pMapping;
+#endif
+
+	unsigned m_uLoadAddress;
+	bool m_bBigEndian;
+	std::vector<tImageSegment> m_collSegments;
+};
+
+#endif
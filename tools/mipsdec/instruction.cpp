@@ -2,102 +2,19 @@
 #include "register.h"
 #include "common.h"
 #include "symbols.h"
+#include <stdio.h>
 
-typedef enum
+static const tInstructionInfo &getInfo(tInstructionType eType)
 {
-	RF_NONE,
-	RF_RD,
-	RF_RS,
-	RF_RT,
-} tResultField;
+	const tInstructionInfo *pInfo = getInstructionInfo(eType);
 
-typedef struct
-{
-	unsigned uOpcode;
-	unsigned uSpecialOpcode;
-	unsigned uRegimmOpcode;
-	unsigned uCop0Opcode;
-	const char *pName;
-	tInstructionType eType;
-	tInstructionFormat eFormat;
-	tResultField eResultField;
-	tInstructionDelaySlot eDelaySlot;
-} tInstructionInfo;
-
-#define DECLARE_REGULAR_OPCODE(opcode, type, format, result_field, delayslot) {opcode, ~0UL, ~0UL, ~0UL, #type, IT_##type, format, result_field, delayslot}
-#define DECLARE_SPECIAL_OPCODE(specialopcode, type, format, result_field, delayslot) {0x00, specialopcode, ~0UL, ~0UL, #type, IT_##type, format, result_field, delayslot}
-#define DECLARE_REGIMM_OPCODE(regdimmopcode, type, format, result_field, delayslot) {0x01, ~0UL, regdimmopcode, ~0UL, #type, IT_##type, format, result_field, delayslot}
-#define DECLARE_COP0_OPCODE(cop0opcode, type, format, result_field, delayslot) {0x10, ~0UL, ~0UL, cop0opcode, #type, IT_##type, format, result_field, delayslot}
-#define DECLARE_VIRTUAL_OPCODE(type, format, result_field, delayslot) {~0UL, ~0UL, ~0UL, ~0UL, #type, IT_##type, format, result_field, delayslot}
-
-static tInstructionInfo s_InstructionInfo[] = 
-{
-	DECLARE_SPECIAL_OPCODE(0x21, ADDU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x09, ADDIU,	IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x24, AND,		IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0C, ANDI,	IF_RSRTUI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x04, BEQ,		IF_RSRTSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x14, BEQL,	IF_RSRTSI,	RF_NONE,	IDS_CONDITIONAL),
-	DECLARE_REGIMM_OPCODE (0x01, BGEZ,	IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x07, BGTZ,		IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x06, BLEZ,		IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGIMM_OPCODE (0x00, BLTZ,	IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x05, BNE,		IF_RSRTSI,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x15, BNEL,	IF_RSRTSI,	RF_NONE,	IDS_CONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x02, J,		IF_NOARG,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_SPECIAL_OPCODE(0x09, JALR,	IF_RSRD,	RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_SPECIAL_OPCODE(0x08, JR,		IF_RS,		RF_NONE,	IDS_UNCONDITIONAL),
-	DECLARE_REGULAR_OPCODE(0x20, LB,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x24, LBU,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x21, LH,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x25, LHU,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0F, LUI,		IF_RTUI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x23, LW,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x22, LWL,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x26, LWR,		IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_COP0_OPCODE   (0x00, MFC0,	IF_RTRDSEL,	RF_RT,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x10, MFHI,	IF_RD,		RF_RD,		IDS_NONE),
-	DECLARE_COP0_OPCODE   (0x04, MTC0,	IF_RTRDSEL,	RF_NONE,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x18, MULT,	IF_RSRT,	RF_NONE,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x19, MULTU,	IF_RSRT,	RF_NONE,	IDS_NONE),
-	DECLARE_VIRTUAL_OPCODE(      NOP,		IF_NOARG,	RF_NONE,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x27, NOR,	IF_RSRTRD,	RF_RD,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x25, OR,		IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0D, ORI,		IF_RSRTUI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x28, SB,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x29, SH,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x00, SLL,		IF_RTRDSA,	RF_RD,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0A, SLTI,	IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0B, SLTIU,	IF_RSRTSI,	RF_RT,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x2B, SLTU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x03, SRA,		IF_RTRDSA,	RF_RD,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x07, SRAV,		IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x02, SRL,		IF_RTRDSA,	RF_RD,		IDS_NONE),
-	DECLARE_VIRTUAL_OPCODE(      SSNOP,	IF_NOARG,	RF_NONE,	IDS_NONE),
-	DECLARE_SPECIAL_OPCODE(0x23, SUBU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x2B, SW,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x2A, SWL,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x2E, SWR,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
-	DECLARE_REGULAR_OPCODE(0x0E, XORI,	IF_RSRTUI,	RF_RT,		IDS_NONE),
-};
-
-#define NUM_INSTRUCTION_INFO_ENTRIES (sizeof(s_InstructionInfo) / sizeof(s_InstructionInfo[0]))
-
-static unsigned getInstructionInfoIdx(tInstructionType eType)
-{
-	unsigned uInfoIdx;
-
-	for(uInfoIdx = 0; uInfoIdx < NUM_INSTRUCTION_INFO_ENTRIES; uInfoIdx++)
+	if(pInfo == NULL)
 	{
-		if(s_InstructionInfo[uInfoIdx].eType == eType)
-		{
-			return uInfoIdx;
-		}
+		M_ASSERT(false);
+		return *getInstructionInfo(IT_ADDU);
 	}
 
-	M_ASSERT(false);
-
-	return 0;
+	return *pInfo;
 }
 
 void Instruction::encodeAbsoluteJump(unsigned uJAddress)
@@ -126,162 +43,65 @@ void Instruction::swap(Instruction &aOtherInstruction, bool bSwapAddress)
 	}
 }
 
-bool decodeData(unsigned uInstructionData, unsigned &uInfoIdx)
-{
-	unsigned uOpcode = uInstructionData >> 26;
-
-	for(uInfoIdx = 0; uInfoIdx < NUM_INSTRUCTION_INFO_ENTRIES; uInfoIdx++)
-	{
-		if(s_InstructionInfo[uInfoIdx].uOpcode == uOpcode)
-		{
-			switch(uOpcode)
-			{
-				case 0x00: /* SPECIAL instructions */
-				{
-					unsigned uSpecialOpcode = uInstructionData & 0x3F;
-
-					if(s_InstructionInfo[uInfoIdx].uSpecialOpcode == uSpecialOpcode)
-					{
-						return true;
-					}
-					break;
-				}
-				case 0x01: /* REGIMM instructions */
-				{
-					unsigned uRegimmOpcode = (uInstructionData >> 16) & 0x1F;
-
-					if(s_InstructionInfo[uInfoIdx].uRegimmOpcode == uRegimmOpcode)
-					{
-						return true;
-					}
-					break;
-				}
-				case 0x10: /* COP0 instructions */
-				{
-					unsigned uCop0Opcode = (uInstructionData >> 21) & 0x1F;
-
-					if(s_InstructionInfo[uInfoIdx].uCop0Opcode == uCop0Opcode)
-					{
-						return true;
-					}
-					break;
-				}
-				default:
-					return true;
-			}
-		}
-	}
-
-#if 1
-	unsigned uOp1 = uOpcode >> 3;
-	unsigned uOp2 = uOpcode & 7;
-	unsigned uSpecialOpcode = uInstructionData & 0x3F;
-#endif
-
-	M_ASSERT(false);
-	return false;
-}
-
 bool Instruction::parse(unsigned uInstructionData, unsigned uInstructionAddress)
 {
+	tDecodedInstruction aDecoded;
+
 	uAddress = uInstructionAddress;
 
-	unsigned uInfoIdx;
-	if(!decodeData(uInstructionData, uInfoIdx))
+	if(!decodeInstruction(uInstructionData, uInstructionAddress, aDecoded))
 	{
+		printf("Unknown instruction 0x%08X at 0x%08X (opcode 0x%02X, function 0x%02X)\n",
+			uInstructionData, uInstructionAddress, uInstructionData >> 26, uInstructionData & 0x3F);
 		return false;
 	}
 
-	eType = s_InstructionInfo[uInfoIdx].eType;
+	eType = aDecoded.eType;
 
-	switch(s_InstructionInfo[uInfoIdx].eFormat)
+	switch(aDecoded.eFormat)
 	{
 		case IF_NOARG:
 			decodeNOARG();
 			break;
 		case IF_RSRTRD:
-			decodeRSRTRD(uInstructionData);
+			decodeRSRTRD(aDecoded);
 			break;
 		case IF_RSRT:
-			decodeRSRT(uInstructionData);
+			decodeRSRT(aDecoded);
 			break;
 		case IF_RSRTSI:
-			decodeRSRTSI(uInstructionData);
+			decodeRSRTSI(aDecoded);
 			break;
 		case IF_RSSI:
-			decodeRSSI(uInstructionData);
+			decodeRSSI(aDecoded);
 			break;
 		case IF_RSRTUI:
-			decodeRSRTUI(uInstructionData);
+			decodeRSRTUI(aDecoded);
 			break;
 		case IF_RTUI:
-			decodeRTUI(uInstructionData);
+			decodeRTUI(aDecoded);
 			break;
 		case IF_RTRDSA:
-			decodeRTRDSA(uInstructionData);
+			decodeRTRDSA(aDecoded);
 			break;
 		case IF_RSRD:
-			decodeRSRD(uInstructionData);
+			decodeRSRD(aDecoded);
 			break;
 		case IF_RD:
-			decodeRD(uInstructionData);
+			decodeRD(aDecoded);
 			break;
 		case IF_RS:
-			decodeRS(uInstructionData);
+			decodeRS(aDecoded);
 			break;
 		case IF_RTRDSEL:
-			decodeRTRDSEL(uInstructionData);
+			decodeRTRDSEL(aDecoded);
 			break;
 		default:
 			M_ASSERT(false);
 			return false;
 	}
 
-	switch(eType)
-	{
-		case IT_BEQ:
-		case IT_BEQL:
-		case IT_BGTZ:
-		case IT_BLEZ:
-		case IT_BLTZ:
-		case IT_BNE:
-		case IT_BNEL:
-			uJumpAddress = uAddress + 4 + (iSI << 2);
-			break;
-		case IT_J:
-			uJumpAddress = ((uAddress + 4) & ~0xFFFFFFF) | ((uInstructionData & 0x3FFFFFF) << 2);
-			break;
-		case IT_JALR:
-			if(uInstructionData & (1 << 10))
-			{
-				eType = IT_JALR_HB;
-			}
-			break;
-		case IT_JR:
-			if(uInstructionData & (1 << 10))
-			{
-				eType = IT_JR_HB;
-			}
-			break;
-		case IT_SLL:
-			if((eRT == R_ZERO) && (eRD == R_ZERO))
-			{
-				switch(uSA)
-				{
-					case 0x00:
-						decodeNOARG();
-						eType = IT_NOP;
-						break;
-					case 0x01:
-						decodeNOARG();
-						eType = IT_SSNOP;
-						break;
-				}
-			}
-			break;
-		default:
-			break;
-	}
+	uJumpAddress = aDecoded.uJumpAddress;
 
 	return true;
 }
@@ -290,7 +110,7 @@ bool Instruction::modifiesRegister(tRegister eRegister) const
 {
 	M_ASSERT(eRegister != R_UNKNOWN);
 
-	switch(s_InstructionInfo[getInstructionInfoIdx(eType)].eResultField)
+	switch(getInfo(eType).eResultField)
 	{
 		case RF_NONE:
 			return false;
@@ -328,8 +148,6 @@ void Instruction::encodeRegisterMove(tRegister eSrcRegister, tRegister eDstRegis
 
 void Instruction::makeNOP(void)
 {
-	M_ASSERT(collIfBranch.size() == 0);
-	M_ASSERT(collElseBranch.size() == 0);
 	M_ASSERT(uJumpAddress == 0);
 
 	bool bWasJumpTarget = bIsJumpTarget;
@@ -343,27 +161,27 @@ void Instruction::makeNOP(void)
 
 tInstructionDelaySlot Instruction::getDelaySlotType(void)
 {
-	return s_InstructionInfo[getInstructionInfoIdx(eType)].eDelaySlot;
+	return getInfo(eType).eDelaySlot;
 }
 
 tInstructionClass Instruction::getClassType(void)
 {
 	/* FIXME: HACK! HACK! */
-	switch(s_InstructionInfo[getInstructionInfoIdx(eType)].pName[0])
+	switch(getInfo(eType).pName[0])
 	{
 		case 'B':
-			M_ASSERT(s_InstructionInfo[getInstructionInfoIdx(eType)].eDelaySlot != IDS_NONE);
+			M_ASSERT(getInfo(eType).eDelaySlot != IDS_NONE);
 			return IC_BRANCH;
 		case 'J':
-			M_ASSERT(s_InstructionInfo[getInstructionInfoIdx(eType)].eDelaySlot != IDS_NONE);
+			M_ASSERT(getInfo(eType).eDelaySlot != IDS_NONE);
 			return IC_JUMP;
 		default:
-			M_ASSERT(s_InstructionInfo[getInstructionInfoIdx(eType)].eDelaySlot == IDS_NONE);
+			M_ASSERT(getInfo(eType).eDelaySlot == IDS_NONE);
 			return IC_OTHER;
 	}
 }
 
-bool Instruction::isNOP(void)
+bool Instruction::isNOP(void) const
 {
 	switch(eType)
 	{
@@ -375,13 +193,6 @@ bool Instruction::isNOP(void)
 	}
 }
 
-void Instruction::deleteDelayed(void)
-{
-	M_ASSERT(!bDelayedDelete);
-
-	bDelayedDelete = true;
-}
-
 bool Instruction::isSame(const Instruction &aOtherInstruction) const
 {
 	if((eType != aOtherInstruction.eType) ||
@@ -410,9 +221,8 @@ void Instruction::setDefaults(void)
 	uUI = 0;
 	iSI = 0;
 	uSEL = 0;
+	uSA = 0;
 	bDelaySlotReordered = false;
-	collIfBranch.clear();
-	collElseBranch.clear();
 	uJumpAddress = 0;
 	bIsJumpTarget = false;
 }
@@ -423,368 +233,163 @@ void Instruction::decodeNOARG(void)
 	eFormat = IF_NOARG;
 }
 
-void Instruction::decodeRTRDSA(unsigned uInstructionData)
+void Instruction::decodeRTRDSA(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RTRDSA;
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	eRD = decodeRegister((uInstructionData >> 11) & 0x1F);
-	uSA = (unsigned char)((uInstructionData >> 6) & 0x1F);
+	eRT = decodeRegister(aDecoded.uRT);
+	eRD = decodeRegister(aDecoded.uRD);
+	uSA = aDecoded.uSA;
 }
 
-void Instruction::decodeRTRDSEL(unsigned uInstructionData)
+void Instruction::decodeRTRDSEL(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RTRDSEL;
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	//eRD = decodeRegister((uInstructionData >> 11) & 0x1F);
-	uSEL = (unsigned char)(uInstructionData & 0x7);
+	eRT = decodeRegister(aDecoded.uRT);
+	//eRD = decodeRegister(aDecoded.uRD);
+	uSEL = aDecoded.uSEL;
 }
 
-void Instruction::decodeRTUI(unsigned uInstructionData)
+void Instruction::decodeRTUI(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RTUI;
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	uUI = (unsigned short)(uInstructionData & 0xFFFF);
+	eRT = decodeRegister(aDecoded.uRT);
+	uUI = aDecoded.uImmediate;
 }
 
-void Instruction::decodeRSRTRD(unsigned uInstructionData)
+void Instruction::decodeRSRTRD(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSRTRD;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	eRD = decodeRegister((uInstructionData >> 11) & 0x1F);
+	eRS = decodeRegister(aDecoded.uRS);
+	eRT = decodeRegister(aDecoded.uRT);
+	eRD = decodeRegister(aDecoded.uRD);
 }
 
-void Instruction::decodeRSRD(unsigned uInstructionData)
+void Instruction::decodeRSRD(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSRD;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	eRD = decodeRegister((uInstructionData >> 11) & 0x1F);
+	eRS = decodeRegister(aDecoded.uRS);
+	eRD = decodeRegister(aDecoded.uRD);
 }
 
-void Instruction::decodeRSRT(unsigned uInstructionData)
+void Instruction::decodeRSRT(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSRT;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
+	eRS = decodeRegister(aDecoded.uRS);
+	eRT = decodeRegister(aDecoded.uRT);
 }
 
-void Instruction::decodeRSRTSI(unsigned uInstructionData)
+void Instruction::decodeRSRTSI(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSRTSI;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	iSI = (signed short)(uInstructionData & 0xFFFF);
+	eRS = decodeRegister(aDecoded.uRS);
+	eRT = decodeRegister(aDecoded.uRT);
+	iSI = (signed short)aDecoded.uImmediate;
 }
 
-void Instruction::decodeRSSI(unsigned uInstructionData)
+void Instruction::decodeRSSI(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSSI;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	iSI = (signed short)(uInstructionData & 0xFFFF);
+	eRS = decodeRegister(aDecoded.uRS);
+	iSI = (signed short)aDecoded.uImmediate;
 }
 
-void Instruction::decodeRSRTUI(unsigned uInstructionData)
+void Instruction::decodeRSRTUI(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RSRTUI;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-	eRT = decodeRegister((uInstructionData >> 16) & 0x1F);
-	uUI = (unsigned short)(uInstructionData & 0xFFFF);
+	eRS = decodeRegister(aDecoded.uRS);
+	eRT = decodeRegister(aDecoded.uRT);
+	uUI = aDecoded.uImmediate;
 }
 
-void Instruction::decodeRD(unsigned uInstructionData)
+void Instruction::decodeRD(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RD;
-	eRD = decodeRegister((uInstructionData >> 11) & 0x1F);
+	eRD = decodeRegister(aDecoded.uRD);
 }
 
-void Instruction::decodeRS(unsigned uInstructionData)
+void Instruction::decodeRS(const tDecodedInstruction &aDecoded)
 {
 	setDefaults();
 	eFormat = IF_RS;
-	eRS = decodeRegister((uInstructionData >> 21) & 0x1F);
-}
-
-static bool isJumpTarget(const tInstList &collInstList, unsigned uAddress)
-{
-	tInstList::const_iterator itCurr = collInstList.begin();
-	tInstList::const_iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
-	{
-		if((itCurr->uJumpAddress == uAddress) && (!itCurr->bIgnoreJump))
-		{
-			return true;
-		}
-
-		if(isJumpTarget(itCurr->collIfBranch, uAddress))
-		{
-			return true;
-		}
-
-		if(isJumpTarget(itCurr->collElseBranch, uAddress))
-		{
-			return true;
-		}
-
-		itCurr++;
-	}
-	
-	return false;
-}
-
-void getJumpTargets(tInstList &collInstList, std::vector<unsigned> &collJumpTargets)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
-	{
-		if((itCurr->uJumpAddress != 0) && (!itCurr->bIgnoreJump))
-		{
-			collJumpTargets.push_back(itCurr->uJumpAddress);
-		}
-
-		getJumpTargets(itCurr->collIfBranch, collJumpTargets);
-		getJumpTargets(itCurr->collElseBranch, collJumpTargets);
-
-		itCurr++;
-	}
-}
-
-void markJumpTargets(tInstList &collInstList, const std::vector<unsigned> &collJumpTargets)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	size_t uNumJumpTargets = collJumpTargets.size();
-
-	while(itCurr != itEnd)
-	{
-		itCurr->bIsJumpTarget = false;
-
-		for(unsigned uIdx = 0; uIdx < uNumJumpTargets; uIdx++)
-		{
-			if(itCurr->uAddress == collJumpTargets[uIdx])
-			{
-				itCurr->bIsJumpTarget = true;
-			}
-		}
-
-		markJumpTargets(itCurr->collIfBranch, collJumpTargets);
-		markJumpTargets(itCurr->collElseBranch, collJumpTargets);
-
-		itCurr++;
-	}
-}
-
-void updateJumpTargets(tInstList &collInstList)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	std::vector<unsigned> collJumpTargets;
-
-	getJumpTargets(collInstList, collJumpTargets);
-	markJumpTargets(collInstList, collJumpTargets);
-}
-
-void updateJumpTargetsOld(tInstList &collInstList)
-{
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
-	{
-		itCurr->bIsJumpTarget = isJumpTarget(collInstList, itCurr->uAddress);
-
-		updateJumpTargets(itCurr->collIfBranch);
-		updateJumpTargets(itCurr->collElseBranch);
-
-		itCurr++;
-	}
-}
-
-bool resolveRegisterValue(const tInstList &collInstList, const tInstList::const_iterator &itCurrInstruction, tRegister eRegister, unsigned &uRegisterVal)
-{
-	tInstList::const_iterator itBegin = collInstList.begin();
-	tInstList::const_iterator itCurr = itCurrInstruction;
-	tInstList::const_iterator itEnd = itCurrInstruction;
-	bool bGotAbsoluteVal = false;
-
-	do
-	{
-		Instruction aInstruction = *itCurr;
-
-		switch(itCurr->eType)
-		{
-			case IT_LUI:
-				if(itCurr->eRT == eRegister)
-				{
-					uRegisterVal = itCurr->uUI << 16;
-					bGotAbsoluteVal = true;
-				}
-				break;
-			case IT_ADDU:
-				if(itCurr->eRD == eRegister)
-				{
-					unsigned uVal1 = 0;
-
-					if((itCurr->eRS != R_ZERO) && (!resolveRegisterValue(collInstList, itCurr, itCurr->eRS, uVal1)))
-					{
-						return false;
-					}
-
-					unsigned uVal2 = 0;
-
-					if((itCurr->eRT != R_ZERO) && (!resolveRegisterValue(collInstList, itCurr, itCurr->eRT, uVal2)))
-					{
-						return false;
-					}
-
-					uRegisterVal = uVal1 + uVal2;
-
-					return true;
-				}
-			default:
-				break;
-		}
-
-		if(!bGotAbsoluteVal)
-		{
-			if(itCurr->bIsJumpTarget)
-			{
-				return false;
-			}
-
-			if(itCurr == itBegin)
-			{
-				return false;
-			}
-
-			itCurr--;
-		}
-	}
-	while(!bGotAbsoluteVal);
-	
-	/* Skip absolute set instruction */
-	itCurr++;
-
-	while(itCurr != itEnd)
-	{
-		const Instruction aInstruction = *itCurr;
-
-		switch(itCurr->eType)
-		{
-			case IT_ADDIU:
-				if(itCurr->eRT == eRegister)
-				{
-					M_ASSERT(itCurr->eRS == eRegister);
-					uRegisterVal += itCurr->iSI;
-				}
-				break;
-			default:
-			{
-				if(itCurr->modifiesRegister(eRegister))
-				{
-					M_ASSERT(false);
-					return false;
-				}
-				break;
-			}
-		}
-
-		itCurr++;
-	}
-	
-	return true;
+	eRS = decodeRegister(aDecoded.uRS);
 }
 
 const char *getInstrName(const Instruction &aInstruction)
 {
-	return s_InstructionInfo[getInstructionInfoIdx(aInstruction.eType)].pName;
+	return getInfo(aInstruction.eType).pName;
 }
 
-void dumpInstructions(const tInstList &collInstList)
+void dumpInstruction(const Instruction &aInstruction)
 {
-	tInstList::const_iterator itCurr = collInstList.begin();
-	tInstList::const_iterator itEnd = collInstList.end();
+	char pBuf[1000];
+	std::string strArg;
 
-	while(itCurr != itEnd)
+	switch(aInstruction.eFormat)
 	{
-		char pBuf[1000];
-		std::string strArg;
-
-		Instruction aInstruction = *itCurr;
-
-		switch(itCurr->eFormat)
-		{
-			case IF_NOARG:
-				strArg = "\t<NOARG>";
-				break;
-			case IF_RSRTRD:
-				sprintf(pBuf, "\t%s,%s,%s", getRegName(itCurr->eRS), getRegName(itCurr->eRT), getRegName(itCurr->eRD));
-				strArg = pBuf;
-				break;
-			case IF_RSRD:
-				sprintf(pBuf, "\t%s,%s", getRegName(itCurr->eRS), getRegName(itCurr->eRD));
-				strArg = pBuf;
-				break;
-			case IF_RSRTUI:
-				sprintf(pBuf, "\t%s,%s,0x%X", getRegName(itCurr->eRS), getRegName(itCurr->eRT), itCurr->uUI);
-				strArg = pBuf;
-				break;
-			case IF_RTUI:
-				sprintf(pBuf, "\t%s,0x%X", getRegName(itCurr->eRT), itCurr->uUI);
-				strArg = pBuf;
-				break;
-			case IF_RSSI:
-				sprintf(pBuf, "\t%s,%d", getRegName(itCurr->eRS), itCurr->iSI);
-				strArg = pBuf;
-				break;
-			case IF_RSRT:
-				sprintf(pBuf, "\t%s,%s", getRegName(itCurr->eRS), getRegName(itCurr->eRT));
-				strArg = pBuf;
-				break;
-			case IF_RSRTSI:
-				sprintf(pBuf, "\t%s,%s,%d", getRegName(itCurr->eRS), getRegName(itCurr->eRT), itCurr->iSI);
-				strArg = pBuf;
-				break;
-			case IF_RD:
-				sprintf(pBuf, "\t%s", getRegName(itCurr->eRD));
-				strArg = pBuf;
-				break;
-			case IF_RS:
-				sprintf(pBuf, "\t%s", getRegName(itCurr->eRS));
-				strArg = pBuf;
-				break;
-			case IF_RTRDSA:
-				sprintf(pBuf, "\t%s,%s,%d", getRegName(itCurr->eRT), getRegName(itCurr->eRD), itCurr->uSA);
-				strArg = pBuf;
-			case IF_RTRDSEL:
-				//sprintf(pBuf, "\t%s,%s,%d", getRegName(itCurr->eRT), getRegName(itCurr->eRD), itCurr->uSEL);
-				sprintf(pBuf, "\t%s,%d,%d", getRegName(itCurr->eRT), itCurr->eRD, itCurr->uSEL);
-				strArg = pBuf;
-				break;
-			case IF_UNKNOWN:
-				break;
-			default:
-				M_ASSERT(false);
-				strArg = "UGH!";
-				break;
-		}
-
-		printf("%08x:\t%08x\t%s%s\n", itCurr->uAddress, /*itCurr->uRaw*/0, getInstrName(*itCurr), strArg.c_str());
-
-		itCurr++;
+		case IF_NOARG:
+			strArg = "\t<NOARG>";
+			break;
+		case IF_RSRTRD:
+			sprintf(pBuf, "\t%s,%s,%s", getRegName(aInstruction.eRS), getRegName(aInstruction.eRT), getRegName(aInstruction.eRD));
+			strArg = pBuf;
+			break;
+		case IF_RSRD:
+			sprintf(pBuf, "\t%s,%s", getRegName(aInstruction.eRS), getRegName(aInstruction.eRD));
+			strArg = pBuf;
+			break;
+		case IF_RSRTUI:
+			sprintf(pBuf, "\t%s,%s,0x%X", getRegName(aInstruction.eRS), getRegName(aInstruction.eRT), aInstruction.uUI);
+			strArg = pBuf;
+			break;
+		case IF_RTUI:
+			sprintf(pBuf, "\t%s,0x%X", getRegName(aInstruction.eRT), aInstruction.uUI);
+			strArg = pBuf;
+			break;
+		case IF_RSSI:
+			sprintf(pBuf, "\t%s,%d", getRegName(aInstruction.eRS), aInstruction.iSI);
+			strArg = pBuf;
+			break;
+		case IF_RSRT:
+			sprintf(pBuf, "\t%s,%s", getRegName(aInstruction.eRS), getRegName(aInstruction.eRT));
+			strArg = pBuf;
+			break;
+		case IF_RSRTSI:
+			sprintf(pBuf, "\t%s,%s,%d", getRegName(aInstruction.eRS), getRegName(aInstruction.eRT), aInstruction.iSI);
+			strArg = pBuf;
+			break;
+		case IF_RD:
+			sprintf(pBuf, "\t%s", getRegName(aInstruction.eRD));
+			strArg = pBuf;
+			break;
+		case IF_RS:
+			sprintf(pBuf, "\t%s", getRegName(aInstruction.eRS));
+			strArg = pBuf;
+			break;
+		case IF_RTRDSA:
+			sprintf(pBuf, "\t%s,%s,%d", getRegName(aInstruction.eRT), getRegName(aInstruction.eRD), aInstruction.uSA);
+			strArg = pBuf;
+		case IF_RTRDSEL:
+			//sprintf(pBuf, "\t%s,%s,%d", getRegName(aInstruction.eRT), getRegName(aInstruction.eRD), aInstruction.uSEL);
+			sprintf(pBuf, "\t%s,%d,%d", getRegName(aInstruction.eRT), aInstruction.eRD, aInstruction.uSEL);
+			strArg = pBuf;
+			break;
+		case IF_UNKNOWN:
+			break;
+		default:
+			M_ASSERT(false);
+			strArg = "UGH!";
+			break;
 	}
+
+	printf("%08x:\t%08x\t%s%s\n", aInstruction.uAddress, /*aInstruction.uRaw*/0, getInstrName(aInstruction), strArg.c_str());
 }
@@ -1,31 +1,9 @@
 #ifndef INSTRUCTION_H
 #define INSTRUCTION_H
 
-#include <list>
 #include "register.h"
 #include "symbols.h"
-
-typedef enum {
-	IF_UNKNOWN,
-	IF_NOARG,
-	IF_RSRTRD,
-	IF_RSRT,
-	IF_RSRTSI,
-	IF_RSSI,
-	IF_RSRTUI,
-	IF_RTUI,
-	IF_RTRDSA,
-	IF_RSRD,
-	IF_RD,
-	IF_RS,
-	IF_RTRDSEL,
-} tInstructionFormat;
-
-typedef enum {
-	IDS_NONE,
-	IDS_CONDITIONAL,
-	IDS_UNCONDITIONAL,
-} tInstructionDelaySlot;
+#include "../mipsdecode/mipsdecode.h"
 
 typedef enum {
 	IC_BRANCH,
@@ -33,66 +11,10 @@ typedef enum {
 	IC_OTHER,
 } tInstructionClass;
 
-typedef enum {
-	IT_ADDIU,		// No delay slot
-	IT_ADDU,		// No delay slot
-	IT_AND,			// No delay slot
-	IT_ANDI,		// No delay slot
-	IT_BEQ,			// Delay slot
-	IT_BEQL,		// Conditional delay slot
-	IT_BGEZ,		// Delay slot
-	IT_BGTZ,		// Delay slot
-	IT_BLEZ,		// Delay slot
-	IT_BLTZ,		// Delay slot
-	IT_BNE,			// Delay slot
-	IT_BNEL,		// Conditional delay slot
-	IT_MFHI,		// No delay slot
-	IT_J,				// Delay slot
-	IT_JALR,		// Delay slot
-	IT_JALR_HB,	// Delay slot
-	IT_JR,			// Delay slot
-	IT_JR_HB,		// Delay slot
-	IT_LB,			// No delay slot
-	IT_LBU,			// No delay slot
-	IT_LH,			// No delay slot
-	IT_LHU,			// No delay slot
-	IT_LUI,			// No delay slot
-	IT_LW,			// No delay slot
-	IT_LWL,			// No delay slot
-	IT_LWR,			// No delay slot
-	IT_MFC0,		// No delay slot
-	IT_MTC0,		// No delay slot
-	IT_MULT,		// No delay slot
-	IT_MULTU,		// No delay slot
-	IT_NOP,			// No delay slot
-	IT_NOR,			// No delay slot
-	IT_OR,			// No delay slot
-	IT_ORI,			// No delay slot
-	IT_SB,			// No delay slot
-	IT_SH,			// No delay slot
-	IT_SLL,			// No delay slot
-	IT_SLTI,		// No delay slot
-	IT_SLTIU,		// No delay slot
-	IT_SLTU,		// No delay slot
-	IT_SRA,			// No delay slot
-	IT_SRAV,		// No delay slot
-	IT_SRL,			// No delay slot
-	IT_SSNOP,		// No delay slot
-	IT_SUBU,		// No delay slot
-	IT_SW,			// No delay slot
-	IT_SWL,			// No delay slot
-	IT_SWR,			// No delay slot
-	IT_XORI,		// No delay slot
-} tInstructionType;
-
-class Instruction;
-typedef std::list<Instruction> tInstList;
-
 class Instruction
 {
 public:
 	Instruction(void) :
-			bDelayedDelete(false),
 			bDelaySlotReordered(false),
 			bIgnoreJump(false)
 	{
@@ -106,8 +28,7 @@ public:
 	void makeNOP(void);
 	tInstructionDelaySlot getDelaySlotType(void);
 	tInstructionClass getClassType(void);
-	bool isNOP(void);
-	void deleteDelayed(void);
+	bool isNOP(void) const;
 	bool isSame(const Instruction &aOtherInstruction) const;
 
 	unsigned uAddress;
@@ -122,11 +43,6 @@ public:
 	unsigned char uSA;
 	unsigned int uJumpAddress;
 
-	tInstList collIfBranch;
-	tInstList collElseBranch;
-	tInstList collInsertAfter;
-
-	bool bDelayedDelete;
 	bool bDelaySlotReordered;
 	bool bIgnoreJump;
 	bool bIsJumpTarget;
@@ -134,22 +50,20 @@ public:
 private:
 	void setDefaults(void);
 	void decodeNOARG(void);
-	void decodeRTRDSEL(unsigned uInstructionData);
-	void decodeRTUI(unsigned uInstructionData);
-	void decodeRTRDSA(unsigned uInstructionData);
-	void decodeRSRTRD(unsigned uInstructionData);
-	void decodeRSRD(unsigned uInstructionData);
-	void decodeRSRT(unsigned uInstructionData);
-	void decodeRSRTSI(unsigned uInstructionData);
-	void decodeRSSI(unsigned uInstructionData);
-	void decodeRSRTUI(unsigned uInstructionData);
-	void decodeRD(unsigned uInstructionData);
-	void decodeRS(unsigned uInstructionData);
+	void decodeRTRDSEL(const tDecodedInstruction &aDecoded);
+	void decodeRTUI(const tDecodedInstruction &aDecoded);
+	void decodeRTRDSA(const tDecodedInstruction &aDecoded);
+	void decodeRSRTRD(const tDecodedInstruction &aDecoded);
+	void decodeRSRD(const tDecodedInstruction &aDecoded);
+	void decodeRSRT(const tDecodedInstruction &aDecoded);
+	void decodeRSRTSI(const tDecodedInstruction &aDecoded);
+	void decodeRSSI(const tDecodedInstruction &aDecoded);
+	void decodeRSRTUI(const tDecodedInstruction &aDecoded);
+	void decodeRD(const tDecodedInstruction &aDecoded);
+	void decodeRS(const tDecodedInstruction &aDecoded);
 };
 
-void updateJumpTargets(tInstList &collInstList);
-bool resolveRegisterValue(const tInstList &collInstList, const tInstList::const_iterator &itCurrInstruction, tRegister eRegister, unsigned &uRegisterVal);
-void dumpInstructions(const tInstList &collInstList);
+void dumpInstruction(const Instruction &aInstruction);
 const char *getInstrName(const Instruction &aInstruction);
 
 #endif
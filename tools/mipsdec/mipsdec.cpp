@@ -1,22 +1,193 @@
 #include "symbols.h"
-#include "instruction.h"
-#include "codegen.h"
-#include "optimize.h"
-#include "function.h"
+#include "image.h"
+#include "decompile.h"
+#include "parameter.h"
+#include "cache.h"
+#include "batch.h"
+#include "profile.h"
+#include "timer.h"
+#include "thread.h"
 #include "common.h"
+#include <stdlib.h>
 
-#ifndef _WIN32
-void __doFail(const char *pCondition, const char *pFile, const char *pFunction, unsigned int uLine)
+static void printSyntax(const char *pName)
 {
-	printf("Assertion (%s) failed in file: %s, function: %s, line %d\n", pCondition, pFile, pFunction, uLine);
+	printf("Syntax: %s [<options>] <function> <binary> <map>\n", pName);
+	printf("        %s [<options>] --all <binary> <map> [<outdir> [<threads>]]\n", pName);
+	printf("        %s [<options>] --list <listfile> <binary> <map> [<outdir> [<threads>]]\n", pName);
+	printf("Options for raw binaries (ELF files carry their own):\n");
+	printf("  --base <address>  load address, default 0x%08x\n", IMAGE_DEFAULT_LOAD_ADDRESS);
+	printf("  --big-endian      big endian byte order\n");
+	printf("Output:\n");
+	printf("  --output <file>   code file of a single function, default code.c\n");
+	printf("  --signatures <file>  C prototypes of known functions, one per line\n");
+	printf("  --cache <dir>     reuse the code of functions unchanged since the last run\n");
+	printf("Profiling:\n");
+	printf("  --profile         print the time spent in each pass\n");
+	printf("  --profile-json <file>  write the profile as JSON\n");
+}
+
+/* The table goes to the console only when asked for with --profile */
+static bool writeProfile(const Profile &aProfile, bool bPrintProfile, const std::string &strJsonFile)
+{
+	if(bPrintProfile)
+	{
+		aProfile.print(stdout, PF_TABLE);
+	}
+
+	if(strJsonFile.empty())
+	{
+		return true;
+	}
+
+	FILE *pJsonFile = fopen(strJsonFile.c_str(), "w");
+
+	if(!pJsonFile)
+	{
+		printf("Can't create profile file: %s\n", strJsonFile.c_str());
+		return false;
+	}
+
+	aProfile.print(pJsonFile, PF_JSON);
+	fclose(pJsonFile);
+
+	return true;
+}
+
+static int runBatch(int argc, char **argv, int iArgIdx, const tFuncNameList &collFuncNames, const BinaryImage &aImage, bool bPrintProfile,
+	const std::string &strJsonFile, const DecompileCache *pCache)
+{
+	Profile aProfile;
+	std::string strOutDir = ".";
+	unsigned uNumThreads = getNumCPUs();
+
+	if(iArgIdx < argc)
+	{
+		strOutDir = argv[iArgIdx++];
+	}
+
+	if(iArgIdx < argc)
+	{
+		uNumThreads = strtoul(argv[iArgIdx++], NULL, 0);
+	}
+
+	bool bResult = decompileBatch(collFuncNames, aImage, strOutDir, uNumThreads, aProfile, pCache);
+
+	if(!writeProfile(aProfile, bPrintProfile, strJsonFile))
+	{
+		bResult = false;
+	}
+
+	return bResult ? 0 : 1;
 }
-#endif
 
 int main(int argc, char **argv)
 {
+	BinaryImage aImage;
+	bool bPrintProfile = false;
+	std::string strJsonFile;
+	std::string strCodeFile = "code.c";
+	std::string strCacheDir;
+	int iArgIdx = 1;
+
+	while(iArgIdx < argc)
+	{
+		std::string strOption = argv[iArgIdx];
+
+		if((strOption == "--base") && ((iArgIdx + 1) < argc))
+		{
+			aImage.setLoadAddress(strtoul(argv[iArgIdx + 1], NULL, 0));
+			iArgIdx += 2;
+		}
+		else if((strOption == "--profile-json") && ((iArgIdx + 1) < argc))
+		{
+			strJsonFile = argv[iArgIdx + 1];
+			iArgIdx += 2;
+		}
+		else if((strOption == "--output") && ((iArgIdx + 1) < argc))
+		{
+			strCodeFile = argv[iArgIdx + 1];
+			iArgIdx += 2;
+		}
+		else if((strOption == "--cache") && ((iArgIdx + 1) < argc))
+		{
+			strCacheDir = argv[iArgIdx + 1];
+			iArgIdx += 2;
+		}
+		else if((strOption == "--signatures") && ((iArgIdx + 1) < argc))
+		{
+			if(!FunctionSignatures::parseSignatureFile(argv[iArgIdx + 1]))
+			{
+				return 1;
+			}
+
+			iArgIdx += 2;
+		}
+		else if(strOption == "--profile")
+		{
+			bPrintProfile = true;
+			iArgIdx++;
+		}
+		else if(strOption == "--big-endian")
+		{
+			aImage.setBigEndian(true);
+			iArgIdx++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	DecompileCache aCache(strCacheDir);
+	const DecompileCache *pCache = NULL;
+
+	if(!strCacheDir.empty())
+	{
+		if(!aCache.init())
+		{
+			return 1;
+		}
+
+		pCache = &aCache;
+	}
+
+	/* Names of call targets are bounded by the segments of the image */
+	Symbols::setImage(&aImage);
+
+	/* Skip the options, the name of the program stays */
+	argv[iArgIdx - 1] = argv[0];
+	argc -= iArgIdx - 1;
+	argv += iArgIdx - 1;
+
+	if((argc >= 4) && (std::string(argv[1]) == "--all"))
+	{
+		if((!Symbols::parseSymFile(argv[3])) || (!aImage.load(argv[2])))
+		{
+			return 1;
+		}
+
+		tFuncNameList collFuncNames;
+		getAllFunctionNames(aImage, collFuncNames);
+
+		return runBatch(argc, argv, 4, collFuncNames, aImage, bPrintProfile, strJsonFile, pCache);
+	}
+
+	if((argc >= 5) && (std::string(argv[1]) == "--list"))
+	{
+		tFuncNameList collFuncNames;
+
+		if((!Symbols::parseSymFile(argv[4])) || (!aImage.load(argv[3])) || (!readFunctionNameList(argv[2], collFuncNames)))
+		{
+			return 1;
+		}
+
+		return runBatch(argc, argv, 5, collFuncNames, aImage, bPrintProfile, strJsonFile, pCache);
+	}
+
 	if(argc != 4)
 	{
-		printf("Syntax: %s <function> <binary> <map>\n", argv[0]);
+		printSyntax(argv[0]);
 		return 1;
 	}
 
@@ -29,30 +200,19 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
-	Function aFunction;
-	
-	aFunction.parseFromFile(strFunction, strBinaryFile);
-	//dumpInstructions(collInstList);
-	resolveDelaySlots(aFunction.m_collInstList);
-	//dumpInstructions(collInstList);
-
-	aFunction.detectStackOffset();
-	updateJumpTargets(aFunction.m_collInstList);
-
-	while(optimizeInstructions(aFunction))
+	if(!aImage.load(strBinaryFile))
 	{
-		aFunction.applyDelayedInserts();
-		aFunction.applyDelayedDeletes();
-		updateJumpTargets(aFunction.m_collInstList);
-		//dumpInstructions(collInstList);
-		aFunction.uOptimizationPasses++;
-	} 
+		return 0;
+	}
 
-	//dumpInstructions(collInstList);
+	Profile aProfile;
+	double dStartTime = getTimeSeconds();
 
-	FILE *pCodeFile = fopen("code.c", "w");
-	generateCode(pCodeFile, aFunction);
-	fclose(pCodeFile);
+	if(decompileFunction(strFunction, aImage, strCodeFile, &aProfile, pCache))
+	{
+		aProfile.dWallTime = getTimeSeconds() - dStartTime;
+		writeProfile(aProfile, bPrintProfile, strJsonFile);
+	}
 
 	return 0;
 }
@@ -1,6 +1,11 @@
 #include "optimize.h"
 #include "instruction.h"
+#include "cfg.h"
+#include "timer.h"
 #include "common.h"
+#include <stdio.h>
+#include <queue>
+#include <functional>
 
 static bool delaySlotClash(const Instruction &aMasterInstruction, const Instruction &aDelaySlotInstruction)
 {
@@ -39,174 +44,152 @@ static bool delaySlotClash(const Instruction &aMasterInstruction, const Instruct
 	}
 }
 
-bool resolveDelaySlots(tInstList &collInstList)
+bool resolveDelaySlots(ControlFlowGraph &aGraph)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	tRegionRef aBody = ControlFlowGraph::getBody();
+	tInstVector collInstructions;
 
-	while(itCurr != itEnd)
-	{
-		tInstList::iterator itNext = itCurr;
-		itNext++;
+	/* Rebuild the function body in one pass, the branches get their */
+	/* delay slot instructions attached on the way                   */
+	aGraph.release(collInstructions);
 
-		if((!itCurr->bDelaySlotReordered) && (itCurr->getDelaySlotType() != IDS_NONE))
-		{
-			M_ASSERT(itNext != itEnd);
-			itCurr->bDelaySlotReordered = true;
+	size_t uNumInstructions = collInstructions.size();
+	size_t uIdx = 0;
 
-			switch(itCurr->getDelaySlotType())
-			{
-				case IDS_CONDITIONAL:
-				{
-					M_ASSERT(itCurr->getClassType() == IC_BRANCH);
-
-					/* Move delay slot instruction into if branch */
-					itCurr->collIfBranch.push_back(*itNext);
-					collInstList.erase(itNext);
-					break;
-				}
-				case IDS_UNCONDITIONAL:
-					if((itCurr->getClassType() == IC_BRANCH) && (delaySlotClash(*itCurr, *itNext)))
-					{
-						/* Move delay slot instruction into if and else branch */
-						itCurr->collIfBranch.push_back(*itNext);
-						itCurr->collElseBranch.push_back(*itNext);
-						collInstList.erase(itNext);
-					}
-					else
-					{
-						/* Swap master and delay slot instruction */
-						itCurr->swap(*itNext, false);
-						itCurr++;
-					}
-					break;
-				default:
-					M_ASSERT(false);
-					return false;
-			}
-
-			if(itCurr->getClassType() != IC_JUMP)
-			{
-				/* Close if branch using the original jump address */
-				Instruction aInstruction;
-				aInstruction.encodeAbsoluteJump(itCurr->uJumpAddress);
-				itCurr->collIfBranch.push_back(aInstruction);
-				itCurr->bIgnoreJump = true;
-			}
+	while(uIdx < uNumInstructions)
+	{
+		Instruction &aCurr = collInstructions[uIdx];
 
-			/* Restart from beginning - iterators might be broken */
-			itCurr = collInstList.begin();
-			itEnd = collInstList.end();
+		if((aCurr.bDelaySlotReordered) || (aCurr.getDelaySlotType() == IDS_NONE))
+		{
+			aGraph.append(aBody, aCurr);
+			uIdx++;
+			continue;
 		}
 
-		itCurr++;
-	}
+		M_ASSERT((uIdx + 1) < uNumInstructions);
 
-	return true;
-}
+		if((uIdx + 1) >= uNumInstructions)
+		{
+			aGraph.append(aBody, aCurr);
+			break;
+		}
 
-static unsigned getCalcNumJumpSources(tInstList &collInstList, unsigned uAddress, Instruction **pLastJumpSource = NULL, unsigned uDepth = 0)
-{
-	M_ASSERT(uAddress != 0);
-	M_ASSERT(uAddress != 0xFFFFFFFF);
+		Instruction &aNext = collInstructions[uIdx + 1];
+		tInstPos aBranchPos;
 
-	unsigned uNumJumpSources = 0;
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+		aCurr.bDelaySlotReordered = true;
 
-	while(itCurr != itEnd)
-	{
-		if((itCurr->uJumpAddress == uAddress) && (!itCurr->bIgnoreJump))
+		switch(aCurr.getDelaySlotType())
 		{
-			uNumJumpSources++;
-
-			if(pLastJumpSource)
+			case IDS_CONDITIONAL:
 			{
-				*pLastJumpSource = &(*itCurr);
+				M_ASSERT(aCurr.getClassType() == IC_BRANCH);
+
+				/* Move delay slot instruction into if branch */
+				aGraph.append(aBody, aCurr);
+				aBranchPos = aGraph.getLast(aBody);
+				aGraph.append(aGraph.getIfBranch(aBranchPos), aNext);
+				break;
 			}
+			case IDS_UNCONDITIONAL:
+				if((aCurr.getClassType() == IC_BRANCH) && (delaySlotClash(aCurr, aNext)))
+				{
+					/* Move delay slot instruction into if and else branch */
+					aGraph.append(aBody, aCurr);
+					aBranchPos = aGraph.getLast(aBody);
+					aGraph.append(aGraph.getIfBranch(aBranchPos), aNext);
+					aGraph.append(aGraph.getElseBranch(aBranchPos), aNext);
+				}
+				else
+				{
+					/* Swap master and delay slot instruction */
+					aCurr.swap(aNext, false);
+					aGraph.append(aBody, aCurr);
+					aGraph.append(aBody, aNext);
+					aBranchPos = aGraph.getLast(aBody);
+				}
+				break;
+			default:
+				M_ASSERT(false);
+				return false;
 		}
 
-		uNumJumpSources += getCalcNumJumpSources(itCurr->collIfBranch, uAddress, pLastJumpSource, uDepth + 1);
-		uNumJumpSources += getCalcNumJumpSources(itCurr->collElseBranch, uAddress, pLastJumpSource, uDepth + 1);
+		if(aGraph.get(aBranchPos).getClassType() != IC_JUMP)
+		{
+			/* Close if branch using the original jump address */
+			Instruction aInstruction;
+			aInstruction.encodeAbsoluteJump(aGraph.get(aBranchPos).uJumpAddress);
+			aGraph.append(aGraph.getIfBranch(aBranchPos), aInstruction);
+			aGraph.get(aBranchPos).bIgnoreJump = true;
+		}
 
-		itCurr++;
+		uIdx += 2;
 	}
 
-	return uNumJumpSources;
+	return true;
 }
 
+/* Every rule looks at a single block of the graph: either at the      */
+/* instruction ending it (which owns the branches), at the jump target  */
+/* starting it or at each of its instructions. After a rewrite only the */
+/* blocks that may match again are put back on the worklist.           */
+
 /* Try to move code blocks referenced by only one jump instruction   */
 /* back to the jump position                                         */
 /* Preconditions:                                                    */
 /* - Instruction before block is an absolute jump instruction        */
 /* - First instruction in the block is a jump target                 */
 /* - First instruction in the block has only one jump source         */
+/* - The jump source is not part of the block (no loops)             */
 /* - Last instruction in the block is an absolute jump instruction   */
 /* - No instruction in the block (except the first) is a jump target */
-static bool reassembleSingleJumpBlocks(Function &aFunction, tInstList &aCurrBranch)
+static bool reassembleSingleJumpBlocks(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	tInstList::iterator itCurr = aCurrBranch.begin();
-	tInstList::iterator itEnd = aCurrBranch.end();
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
 
-	while(itCurr != itEnd)
+	if(aGraph.get(aCurr).eType != IT_J)
 	{
-		if(itCurr->eType == IT_J)
-		{
-			tInstList::iterator itBlockBegin = itCurr;
-			itBlockBegin++;
+		return false;
+	}
 
-			/* Found jump instruction next has to be a jump target */
-			if((itBlockBegin != itEnd) && (itBlockBegin->bIsJumpTarget))
-			{
-				tInstList::iterator itBlockEnd = itBlockBegin;
-				itBlockEnd++;
+	tInstPos aBlockBegin = aCurr;
+	aGraph.next(aBlockBegin);
 
-				/* Now search for a closing jump instruction */
-				while(itBlockEnd != itEnd)
-				{
-					/* No jump targets allowed within block */
-					if(itBlockEnd->bIsJumpTarget)
-					{
-						break;
-					}
+	/* Found jump instruction next has to be a jump target */
+	if((ControlFlowGraph::isEnd(aBlockBegin)) || (!aGraph.get(aBlockBegin).bIsJumpTarget))
+	{
+		return false;
+	}
 
-					if(itBlockEnd->eType == IT_J)
-					{
-						/* Verify that the block has only one jump source */
-						Instruction *pLastJumpSource = NULL;
-
-						unsigned uNumJumpSources = getCalcNumJumpSources(aFunction.m_collInstList, itBlockBegin->uAddress, &pLastJumpSource);
-						if(uNumJumpSources == 1)
-						{
-							tInstList::iterator itBlockEndNext = itBlockEnd;
-							itBlockEndNext++;
-
-							/* Yeah! Found one... move block into if branch*/
-							M_ASSERT(pLastJumpSource->collInsertAfter.size() == 0);
-							pLastJumpSource->deleteDelayed();
-							pLastJumpSource->collInsertAfter.insert(pLastJumpSource->collInsertAfter.end(), itBlockBegin, itBlockEndNext);
-							aCurrBranch.erase(itBlockBegin, itBlockEndNext);
-
-							return true;
-						}
-					}
+	tInstPos aBlockEnd = aBlockBegin;
+	aGraph.next(aBlockEnd);
 
-					itBlockEnd++;
-				}
-			}
-		}
-
-		if(reassembleSingleJumpBlocks(aFunction, itCurr->collIfBranch))
+	/* Now search for a closing jump instruction */
+	while(!ControlFlowGraph::isEnd(aBlockEnd))
+	{
+		/* No jump targets allowed within block */
+		if(aGraph.get(aBlockEnd).bIsJumpTarget)
 		{
-			return true;
+			break;
 		}
 
-		if(reassembleSingleJumpBlocks(aFunction, itCurr->collElseBranch))
+		if(aGraph.get(aBlockEnd).eType == IT_J)
 		{
-			return true;
+			/* Verify that the block has only one jump source */
+			tInstPos aLastJumpSource;
+
+			unsigned uNumJumpSources = aGraph.getNumJumpSources(aGraph.get(aBlockBegin).uAddress, &aLastJumpSource);
+			if((uNumJumpSources == 1) && (!aGraph.contains(aBlockBegin, aBlockEnd, aLastJumpSource)))
+			{
+				/* Yeah! Found one... move block to the jump source */
+				aGraph.replace(aLastJumpSource, aGraph.extract(aBlockBegin, aBlockEnd));
+
+				return true;
+			}
 		}
 
-		itCurr++;
+		aGraph.next(aBlockEnd);
 	}
 
 	return false;
@@ -219,75 +202,57 @@ static bool reassembleSingleJumpBlocks(Function &aFunction, tInstList &aCurrBran
 /* - Last instruction in the if branch is an absolute jump instruction */
 /* - No else branch                                                    */
 /* - No instruction in the block is a jump target                      */
-static bool detectElseBranch(tInstList &collInstList)
+static bool detectElseBranch(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
 
-	while(itCurr != itEnd)
+	/* Do we have an if branch and no else branch? */
+	if((!aGraph.hasIfBranch(aCurr)) || (aGraph.hasElseBranch(aCurr)))
 	{
-		/* Do we have an if branch and no else branch? */
-		if((itCurr->collIfBranch.size() > 0) && (itCurr->collElseBranch.size() == 0))
-		{
-			tInstList::reverse_iterator itJumpInstruction = itCurr->collIfBranch.rbegin();
+		return false;
+	}
 
-			/* Last if branch instruction a jump instruction? */
-			if(itJumpInstruction->eType == IT_J)
-			{
-				tInstList::iterator itBlockBegin = itCurr;
-				itBlockBegin++;
+	tInstPos aJumpPos = aGraph.getLast(aGraph.getIfBranch(aCurr));
 
-				tInstList::iterator itBlockEnd = itCurr;
-				itBlockEnd++;
+	/* Last if branch instruction a jump instruction? */
+	if(aGraph.get(aJumpPos).eType != IT_J)
+	{
+		return false;
+	}
 
-				while(itBlockEnd != itEnd)
-				{
-					tInstList::iterator itBlockNext = itBlockEnd;
-					itBlockNext++;
+	unsigned uJumpAddress = aGraph.get(aJumpPos).uJumpAddress;
 
-					if(itBlockEnd->uAddress == itJumpInstruction->uJumpAddress)
-					{
-						/* Remove jump from if branch */
-						itCurr->collIfBranch.pop_back();
+	tInstPos aBlockBegin = aCurr;
+	aGraph.next(aBlockBegin);
 
-						/* Move block into else branch */
-						itCurr->collElseBranch.insert(itCurr->collElseBranch.begin(), itBlockBegin, itBlockEnd);
-						collInstList.erase(itBlockBegin, itBlockEnd);
-						return true;
-					}
+	tInstPos aBlockEnd = aBlockBegin;
 
-					/* No jump targets allowed */
-					if(itBlockEnd->bIsJumpTarget)
-					{
-						break;
-					}
+	while(!ControlFlowGraph::isEnd(aBlockEnd))
+	{
+		if(aGraph.get(aBlockEnd).uAddress == uJumpAddress)
+		{
+			/* Remove jump from if branch */
+			aGraph.erase(aJumpPos);
 
-#if 0
-					if(itBlockNext == itEnd)
-					{
-						/* Move block into else branch */
-						itCurr->collElseBranch.insert(itCurr->collElseBranch.begin(), itBlockBegin, itBlockNext);
-						collInstList.erase(itBlockBegin, itBlockNext);
-						return true;
-					}
-#endif
+			/* Move block into else branch */
+			if(!ControlFlowGraph::isSamePos(aBlockBegin, aBlockEnd))
+			{
+				tInstPos aBlockLast = aBlockEnd;
+				aGraph.prev(aBlockLast);
 
-					itBlockEnd++;
-				}
+				aGraph.insertFront(aGraph.getElseBranch(aCurr), aGraph.extract(aBlockBegin, aBlockLast));
 			}
-		}
 
-		if(detectElseBranch(itCurr->collIfBranch))
-		{
 			return true;
 		}
 
-		if(detectElseBranch(itCurr->collElseBranch))
+		/* No jump targets allowed */
+		if(aGraph.get(aBlockEnd).bIsJumpTarget)
 		{
-			return true;
+			break;
 		}
 
-		itCurr++;
+		aGraph.next(aBlockEnd);
 	}
 
 	return false;
@@ -330,96 +295,52 @@ static void invertCondition(Instruction &aInstruction)
 /* Preconditions:                                                      */
 /* - Empty else branch                                                 */
 /* - Non empty else branch                                             */
-static bool detectOnlyElseBranch(tInstList &collInstList)
+static bool detectOnlyElseBranch(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
 
-	while(itCurr != itEnd)
+	/* Do we have an else branch and no if branch? */
+	if((aGraph.hasIfBranch(aCurr)) || (!aGraph.hasElseBranch(aCurr)))
 	{
-		/* Do we have an else branch and no if branch? */
-		if((itCurr->collIfBranch.size() == 0) && (itCurr->collElseBranch.size() > 0))
-		{
-			invertCondition(*itCurr);
-			itCurr->collIfBranch = itCurr->collElseBranch;
-			itCurr->collElseBranch.clear();
-			return true;
-		}
-
-		if(detectOnlyElseBranch(itCurr->collIfBranch))
-		{
-			return true;
-		}
-
-		if(detectOnlyElseBranch(itCurr->collElseBranch))
-		{
-			return true;
-		}
-
-		itCurr++;
+		return false;
 	}
 
-	return false;
-}
-
-static bool removeClosingJump(tInstList &collInstList, unsigned uJumpTarget)
-{
-	M_ASSERT(uJumpTarget != 0);
-	M_ASSERT(uJumpTarget != 0xFFFFFFFF);
-
-	tInstList::reverse_iterator itCurr = collInstList.rbegin();
-	tInstList::reverse_iterator itEnd = collInstList.rend();
+	invertCondition(aGraph.get(aCurr));
+	aGraph.swapBranches(aCurr);
 
-	if(itCurr != itEnd)
-	{
-		if((itCurr->uJumpAddress == uJumpTarget) && (!itCurr->bIgnoreJump))
-		{
-			collInstList.pop_back();
-			return true;
-		}
-
-		if(removeClosingJump(itCurr->collIfBranch, uJumpTarget))
-		{
-			return true;
-		}
-
-		if(removeClosingJump(itCurr->collElseBranch, uJumpTarget))
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return true;
 }
 
-static bool removeClosingJump2(tInstList &collInstList, unsigned uNextAddress)
+static bool removeClosingJump2(ControlFlowGraph &aGraph, const tRegionRef &aRegion, unsigned uNextAddress)
 {
 	M_ASSERT(uNextAddress != 0);
 	M_ASSERT(uNextAddress != 0xFFFFFFFF);
 
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-	tInstList::iterator itNext = collInstList.begin();
-	itNext++;
+	tInstPos aCurr = aGraph.getBegin(aRegion);
+	tInstPos aNext = aCurr;
 
-	while((itCurr != itEnd) && (itNext != itEnd))
+	if(!ControlFlowGraph::isEnd(aNext))
 	{
-		if((itCurr->collIfBranch.size() > 0) && (itCurr->collElseBranch.size() == 0)) 
+		aGraph.next(aNext);
+	}
+
+	while((!ControlFlowGraph::isEnd(aCurr)) && (!ControlFlowGraph::isEnd(aNext)))
+	{
+		if((aGraph.hasIfBranch(aCurr)) && (!aGraph.hasElseBranch(aCurr)))
 		{
-			tInstList::reverse_iterator itIfLast = itCurr->collIfBranch.rbegin();
-		
-			if((itIfLast->uJumpAddress == uNextAddress) && (!itIfLast->bIgnoreJump))
+			tInstPos aIfLast = aGraph.getLast(aGraph.getIfBranch(aCurr));
+
+			if((aGraph.get(aIfLast).uJumpAddress == uNextAddress) && (!aGraph.get(aIfLast).bIgnoreJump))
 			{
-				itCurr->collIfBranch.pop_back();
-				itCurr->collElseBranch.insert(itCurr->collElseBranch.begin(), itNext, itEnd);
-				collInstList.erase(itNext, itEnd);
-				
+				aGraph.erase(aIfLast);
+				aGraph.insertFront(aGraph.getElseBranch(aCurr), aGraph.extract(aNext, aGraph.getLast(aRegion)));
+
 				return true;
 			}
 		}
 
-		itCurr++;
-		itNext++;
+		aCurr = aNext;
+		aGraph.next(aNext);
 	}
 
 	return false;
@@ -430,71 +351,55 @@ static bool removeClosingJump2(tInstList &collInstList, unsigned uNextAddress)
 /* Preconditions:                                                      */
 /* - Last instruction in the if/else branch                            */
 /* - Jump target directly follows the branch                           */
-static bool detectEndOfBranchJumps(tInstList &collInstList)
+static bool detectEndOfBranchJumps(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-	tInstList::iterator itNext = collInstList.begin();
-	itNext++;
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
+	tInstPos aNext = aCurr;
 
-	while((itCurr != itEnd) && (itNext != itEnd))
-	{
-		if(((itCurr->collIfBranch.size() > 0) || (itCurr->collElseBranch.size() > 0)) && (itNext->bIsJumpTarget))
-		{
-			if(removeClosingJump2(itCurr->collIfBranch, itNext->uAddress))
-			{
-				return true;
-			}
+	aGraph.next(aNext);
 
-			if(removeClosingJump2(itCurr->collElseBranch, itNext->uAddress))
-			{
-				return true;
-			}
-		
-			if(detectEndOfBranchJumps(itCurr->collIfBranch))
-			{
-				return true;
-			}
+	if((ControlFlowGraph::isEnd(aNext)) || (!aGraph.get(aNext).bIsJumpTarget) ||
+		((!aGraph.hasIfBranch(aCurr)) && (!aGraph.hasElseBranch(aCurr))))
+	{
+		return false;
+	}
 
-			if(detectEndOfBranchJumps(itCurr->collElseBranch))
-			{
-				return true;
-			}
-		}
+	unsigned uNextAddress = aGraph.get(aNext).uAddress;
 
-		itCurr++;
-		itNext++;
+	if(removeClosingJump2(aGraph, aGraph.getIfBranch(aCurr), uNextAddress))
+	{
+		return true;
 	}
 
-	return false;
+	return removeClosingJump2(aGraph, aGraph.getElseBranch(aCurr), uNextAddress);
 }
 
-static bool stripEpilogProlog(tInstList &collInstList, unsigned uStackOffset)
+static bool stripEpilogProlog(ControlFlowGraph &aGraph, tBlockIdx uBlock, unsigned uStackOffset)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
-
-	while(itCurr != itEnd)
+	for(tInstPos aCurr = aGraph.getBlockBegin(uBlock); aCurr.uBlock == uBlock; aGraph.next(aCurr))
 	{
-		if(itCurr->modifiesRegister(R_SP))
+		Instruction &aInstruction = aGraph.get(aCurr);
+
+		if(aInstruction.modifiesRegister(R_SP))
 		{
-			M_ASSERT(itCurr->eType == IT_ADDIU);
-			M_ASSERT((unsigned)abs(itCurr->iSI) == uStackOffset);
+			M_ASSERT(aInstruction.eType == IT_ADDIU);
+			M_ASSERT((unsigned)abs(aInstruction.iSI) == uStackOffset);
 
-			if(itCurr->bIsJumpTarget)
+			if(aInstruction.bIsJumpTarget)
 			{
-				itCurr->makeNOP();
+				aInstruction.makeNOP();
+				aGraph.touch(aCurr);
 			}
 			else
 			{
-				collInstList.erase(itCurr);
+				aGraph.erase(aCurr);
 			}
 			return true;
 		}
 
-		if(((itCurr->eType == IT_LW) || (itCurr->eType == IT_SW)) && (itCurr->eRS == R_SP))
+		if(((aInstruction.eType == IT_LW) || (aInstruction.eType == IT_SW)) && (aInstruction.eRS == R_SP))
 		{
-			int iDelta = uStackOffset - abs(itCurr->iSI);
+			int iDelta = uStackOffset - abs(aInstruction.iSI);
 			switch(iDelta)
 			{
 				case 4:
@@ -507,13 +412,14 @@ static bool stripEpilogProlog(tInstList &collInstList, unsigned uStackOffset)
 				case 32:
 				case 36:
 				case 40:*/
-					if(itCurr->bIsJumpTarget)
+					if(aInstruction.bIsJumpTarget)
 					{
-						itCurr->makeNOP();
+						aInstruction.makeNOP();
+						aGraph.touch(aCurr);
 					}
 					else
 					{
-						collInstList.erase(itCurr);
+						aGraph.erase(aCurr);
 					}
 					return true;
 					break;
@@ -521,291 +427,635 @@ static bool stripEpilogProlog(tInstList &collInstList, unsigned uStackOffset)
 					//M_ASSERT(false);
 			}
 		}
+	}
 
-		if(stripEpilogProlog(itCurr->collIfBranch, uStackOffset))
-		{
-			return true;
-		}
+	return false;
+}
 
-		if(stripEpilogProlog(itCurr->collElseBranch, uStackOffset))
+static bool detectEpilogProlog(Function &aFunction, tBlockIdx uBlock)
+{
+	if(!aFunction.bHasStackOffset)
+	{
+		return false;
+	}
+
+	return stripEpilogProlog(aFunction.m_aGraph, uBlock, aFunction.uStackOffset);
+}
+
+static bool stripNops(ControlFlowGraph &aGraph, tBlockIdx uBlock)
+{
+	for(tInstPos aCurr = aGraph.getBlockBegin(uBlock); aCurr.uBlock == uBlock; aGraph.next(aCurr))
+	{
+		if((aGraph.get(aCurr).isNOP()) && (!aGraph.get(aCurr).bIsJumpTarget))
 		{
+			aGraph.erase(aCurr);
 			return true;
 		}
-
-		itCurr++;
 	}
 
 	return false;
 }
 
-static bool detectEpilogProlog(Function &aFunction)
+static bool detectEndingIfBranch(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	if(!aFunction.bHasStackOffset)
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
+
+	if((!aGraph.hasIfBranch(aCurr)) || (!aGraph.hasElseBranch(aCurr)))
 	{
 		return false;
 	}
 
-	return stripEpilogProlog(aFunction.m_collInstList, aFunction.uStackOffset);
+	const Instruction &aLastIf = aGraph.get(aGraph.getLast(aGraph.getIfBranch(aCurr)));
+
+	if((aLastIf.eType == IT_J) || ((aLastIf.eType == IT_JR) && (aLastIf.eRS == R_RA)))
+	{
+		aGraph.insertAfter(aCurr, aGraph.extractRegion(aGraph.getElseBranch(aCurr)));
+
+		return true;
+	}
+
+	return false;
 }
 
-static bool stripNops(tInstList &collInstList)
+static bool detectIdenticalIfElseBranch(ControlFlowGraph &aGraph, tBlockIdx uBlock)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	tInstPos aCurr = aGraph.getBlockLast(uBlock);
 
-	while(itCurr != itEnd)
+	if((!aGraph.hasIfBranch(aCurr)) || (!aGraph.hasElseBranch(aCurr)))
 	{
-		if((itCurr->isNOP()) && (!itCurr->bIsJumpTarget))
-		{
-			collInstList.erase(itCurr);
-			return true;
-		}
+		return false;
+	}
 
-		if(stripNops(itCurr->collIfBranch))
-		{
-			return true;
-		}
+	tInstPos aLastIf = aGraph.getLast(aGraph.getIfBranch(aCurr));
+	tInstPos aLastElse = aGraph.getLast(aGraph.getElseBranch(aCurr));
 
-		if(stripNops(itCurr->collElseBranch))
-		{
-			return true;
-		}
+	if((!aGraph.hasIfBranch(aLastIf)) && (!aGraph.hasIfBranch(aLastElse)) && (aGraph.get(aLastIf).isSame(aGraph.get(aLastElse))))
+	{
+		M_ASSERT(!aGraph.hasElseBranch(aLastIf));
+		M_ASSERT(!aGraph.hasElseBranch(aLastElse));
+
+		Instruction aInstruction = aGraph.get(aLastIf);
+
+		aGraph.erase(aLastIf);
+		aGraph.erase(aLastElse);
 
-		itCurr++;
+		aGraph.insertAfter(aCurr, aInstruction);
+
+		return true;
 	}
 
 	return false;
 }
 
-static bool detectEndingIfBranch(tInstList &collInstList)
+#define MAX_CLONE_INSTRUCTIONS 10
+
+/* Counts the instructions [aBlockBegin, aBlockLast] including the nested */
+/* ones, stops as soon as more than uMaxCount have been found             */
+static unsigned getInstructionCount(const ControlFlowGraph &aGraph, const tInstPos &aBlockBegin, const tInstPos &aBlockLast, unsigned uMaxCount)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	unsigned uInstructionCount = 0;
+	tInstPos aCurr = aBlockBegin;
 
-	while(itCurr != itEnd)
+	while((!ControlFlowGraph::isEnd(aCurr)) && (uInstructionCount <= uMaxCount))
 	{
-		if((itCurr->collIfBranch.size() > 0) && (itCurr->collElseBranch.size() > 0))
+		if(!aGraph.get(aCurr).isNOP())
 		{
-			tInstList::reverse_iterator itLastIf = itCurr->collIfBranch.rbegin();
-		
-			if((itLastIf->eType == IT_J) || ((itLastIf->eType == IT_JR) && (itLastIf->eRS == R_RA)))
+			uInstructionCount++;
+
+			if(aGraph.ownsBranches(aCurr))
 			{
-				tInstList::iterator itNext = itCurr;
-				itNext++;
-				
-				collInstList.insert(itNext, itCurr->collElseBranch.begin(), itCurr->collElseBranch.end());
-				itCurr->collElseBranch.clear();
-				
-				return true;
+				tRegionRef aIfBranch = aGraph.getIfBranch(aCurr);
+				tRegionRef aElseBranch = aGraph.getElseBranch(aCurr);
+
+				uInstructionCount += getInstructionCount(aGraph, aGraph.getBegin(aIfBranch), aGraph.getLast(aIfBranch), uMaxCount);
+				uInstructionCount += getInstructionCount(aGraph, aGraph.getBegin(aElseBranch), aGraph.getLast(aElseBranch), uMaxCount);
 			}
 		}
-		
-		if(detectEndingIfBranch(itCurr->collIfBranch))
-		{
-			return true;
-		}
 
-		if(detectEndingIfBranch(itCurr->collElseBranch))
+		if(ControlFlowGraph::isSamePos(aCurr, aBlockLast))
 		{
-			return true;
+			break;
 		}
 
-		itCurr++;
+		aGraph.next(aCurr);
 	}
-	
-	return false;
+
+	return uInstructionCount;
 }
 
-static bool detectIdenticalIfElseBranch(tInstList &collInstList)
+static bool isBlockEndJump(const Instruction &aInstruction)
 {
-	tInstList::iterator itCurr = collInstList.begin();
-	tInstList::iterator itEnd = collInstList.end();
+	return (aInstruction.eType == IT_J) || ((aInstruction.eType == IT_JR) && (aInstruction.eRS == R_RA));
+}
 
-	while(itCurr != itEnd)
+static bool detectAndCloneSmallBlocks(ControlFlowGraph &aGraph, tBlockIdx uBlock)
+{
+	tInstPos aBlockBegin = aGraph.getBlockBegin(uBlock);
+
+	if(!aGraph.get(aBlockBegin).bIsJumpTarget)
 	{
-		if((itCurr->collIfBranch.size() > 0) && (itCurr->collElseBranch.size() > 0))
-		{
-			tInstList::reverse_iterator itLastIf = itCurr->collIfBranch.rbegin();
-			tInstList::reverse_iterator itLastElse = itCurr->collElseBranch.rbegin();
-		
-			if((itLastIf->collIfBranch.size() == 0) && (itLastElse->collIfBranch.size() == 0) && (itLastIf->isSame(*itLastElse)))
-			{
-				M_ASSERT(itLastIf->collElseBranch.size() == 0);
-				M_ASSERT(itLastElse->collElseBranch.size() == 0);
+		return false;
+	}
 
-				Instruction aInstruction = *itLastIf;
-				tInstList::iterator itNext = itCurr;
-				itNext++;
+	tInstPos aBlockEnd = aBlockBegin;
+	unsigned uInstructionCount = 0;
 
-				itCurr->collIfBranch.pop_back();
-				itCurr->collElseBranch.pop_back();
+	while(!ControlFlowGraph::isEnd(aBlockEnd))
+	{
+		/* The count only grows, give up as soon as the block gets too big */
+		uInstructionCount += getInstructionCount(aGraph, aBlockEnd, aBlockEnd, MAX_CLONE_INSTRUCTIONS);
 
-				collInstList.insert(itNext, aInstruction);
-			
-				return true;
-			}
-		}
-		
-		if(detectIdenticalIfElseBranch(itCurr->collIfBranch))
+		if(uInstructionCount > MAX_CLONE_INSTRUCTIONS)
 		{
-			return true;
+			break;
 		}
 
-		if(detectIdenticalIfElseBranch(itCurr->collElseBranch))
+		if(isBlockEndJump(aGraph.get(aBlockEnd)))
 		{
-			return true;
+			tInstPos aLastJumpSource;
+
+			unsigned uNumJumpSources = aGraph.getNumJumpSources(aGraph.get(aBlockBegin).uAddress, &aLastJumpSource);
+			M_ASSERT(uNumJumpSources >= 1);
+
+			/* Cloning a block into itself would never end */
+			if((uNumJumpSources >= 1) && (!aGraph.contains(aBlockBegin, aBlockEnd, aLastJumpSource)))
+			{
+				aGraph.replace(aLastJumpSource, aGraph.clone(aBlockBegin, aBlockEnd));
+
+				return true;
+			}
+
+			break;
 		}
 
-		itCurr++;
+		aGraph.next(aBlockEnd);
 	}
-	
+
 	return false;
 }
 
-static unsigned getInstructionCount(const tInstList::iterator &itBlockBegin, const tInstList::iterator &itBlockEnd)
+static bool applyRule(Function &aFunction, tOptimizerRule eRule, tBlockIdx uBlock, const std::vector<bool> &collBranchScope)
 {
-	unsigned uInstructionCount = 0;
-	tInstList::iterator itCurr = itBlockBegin;
+	ControlFlowGraph &aGraph = aFunction.m_aGraph;
 
-	while(itCurr != itBlockEnd)
+	switch(eRule)
 	{
-		if(!itCurr->isNOP())
+		case OR_SINGLE_JUMP_BLOCKS:
+			return reassembleSingleJumpBlocks(aGraph, uBlock);
+		case OR_ELSE_BRANCH:
+			return detectElseBranch(aGraph, uBlock);
+		case OR_ONLY_ELSE_BRANCH:
+			return detectOnlyElseBranch(aGraph, uBlock);
+		case OR_END_OF_BRANCH_JUMPS:
+			return (collBranchScope[uBlock]) && (detectEndOfBranchJumps(aGraph, uBlock));
+		case OR_EPILOG_PROLOG:
+			return detectEpilogProlog(aFunction, uBlock);
+		case OR_NOPS:
+			return stripNops(aGraph, uBlock);
+		case OR_ENDING_IF_BRANCH:
+			return detectEndingIfBranch(aGraph, uBlock);
+		case OR_IDENTICAL_IF_ELSE_BRANCH:
+			return detectIdenticalIfElseBranch(aGraph, uBlock);
+		case OR_CLONE_SMALL_BLOCKS:
+			return detectAndCloneSmallBlocks(aGraph, uBlock);
+		default:
+			M_ASSERT(false);
+			return false;
+	}
+}
+
+typedef std::pair<tOrderKey, tBlockIdx> tQueuedBlock;
+typedef std::priority_queue<tQueuedBlock, std::vector<tQueuedBlock>, std::greater<tQueuedBlock> > tBlockQueue;
+
+/* The blocks each rule still has to look at. Like the full scans this */
+/* replaces, every rule takes its blocks in code order: the blocks are */
+/* queued by their position, so after a rewrite the search goes on at  */
+/* the first block queued again instead of starting over               */
+class RewriteWorklist
+{
+public:
+	RewriteWorklist(const ControlFlowGraph &aGraph) :
+			m_aGraph(aGraph)
+	{
+		for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
 		{
-			uInstructionCount++;
-			uInstructionCount += getInstructionCount(itCurr->collIfBranch.begin(), itCurr->collIfBranch.end());
-			uInstructionCount += getInstructionCount(itCurr->collElseBranch.begin(), itCurr->collElseBranch.end());
+			m_aNumQueued[uRule] = 0;
 		}
-
-		itCurr++;
 	}
 
-	return uInstructionCount;
-}
+	void push(unsigned uRule, tBlockIdx uBlock)
+	{
+		std::vector<bool> &collQueued = m_aQueued[uRule];
 
-#define MAX_CLONE_INSTRUCTIONS 10
+		if(uBlock >= collQueued.size())
+		{
+			collQueued.resize(uBlock + 1, false);
+		}
 
-static bool detectAndCloneSmallBlocks(Function &aFunction, tInstList &aCurrBranch)
-{
-	tInstList::iterator itCurr = aCurrBranch.begin();
-	tInstList::iterator itEnd = aCurrBranch.end();
+		if(!collQueued[uBlock])
+		{
+			collQueued[uBlock] = true;
+			m_aNumQueued[uRule]++;
+			enqueue(uRule, uBlock);
+		}
+	}
 
-	while(itCurr != itEnd)
+	void push(tBlockIdx uBlock)
 	{
-		if(itCurr->bIsJumpTarget)
+		for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
 		{
-			tInstList::iterator itBlockBegin = itCurr;
-			tInstList::iterator itBlockEnd = itCurr;
+			push(uRule, uBlock);
+		}
+	}
 
-			while(itBlockEnd != itEnd)
-			{
-				if((itBlockEnd->eType == IT_J) || ((itBlockEnd->eType == IT_JR) && (itBlockEnd->eRS == R_RA)))
-				{
-					tInstList::iterator itBlockEndNext = itBlockEnd;
-					itBlockEndNext++;
+	void pushAll(const std::vector<tBlockIdx> &collBlocks)
+	{
+		for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
+		{
+			push(collBlocks[uIdx]);
+		}
+	}
 
-					unsigned uInstructionCount = getInstructionCount(itBlockBegin, itBlockEndNext);
+	/* The position of uBlock has changed: it is queued again at the */
+	/* new one or dropped if it is not part of the function anymore  */
+	void reorder(tBlockIdx uBlock)
+	{
+		bool bLinked = m_aGraph.getOrderKey(uBlock) != ORDER_NONE;
 
-					if(uInstructionCount <= MAX_CLONE_INSTRUCTIONS)
-					{
-						Instruction *pLastJumpSource = NULL;
+		for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
+		{
+			std::vector<bool> &collQueued = m_aQueued[uRule];
 
-						unsigned uNumJumpSources = getCalcNumJumpSources(aFunction.m_collInstList, itBlockBegin->uAddress, &pLastJumpSource);
-						M_ASSERT(uNumJumpSources >= 1);
-						M_ASSERT(pLastJumpSource->collInsertAfter.size() == 0);
+			if((uBlock >= collQueued.size()) || (!collQueued[uBlock]))
+			{
+				continue;
+			}
 
-						pLastJumpSource->deleteDelayed();
-						pLastJumpSource->collInsertAfter.insert(pLastJumpSource->collInsertAfter.end(), itBlockBegin, itBlockEndNext);
+			if(bLinked)
+			{
+				enqueue(uRule, uBlock);
+			}
+			else
+			{
+				collQueued[uBlock] = false;
+				m_aNumQueued[uRule]--;
+			}
+		}
+	}
 
-						return true;
-					}
+	/* Next queued block in code order, BLOCK_NONE if there is none */
+	tBlockIdx pop(unsigned uRule)
+	{
+		std::vector<bool> &collQueued = m_aQueued[uRule];
+		tBlockQueue &aQueue = m_aQueue[uRule];
 
-					break;
-				}
+		while(!aQueue.empty())
+		{
+			tQueuedBlock aEntry = aQueue.top();
+
+			aQueue.pop();
+
+			/* Entries from before the block has moved are outdated */
+			if((collQueued[aEntry.second]) && (m_aGraph.getOrderKey(aEntry.second) == aEntry.first))
+			{
+				collQueued[aEntry.second] = false;
+				m_aNumQueued[uRule]--;
 
-				itBlockEnd++;
+				return aEntry.second;
 			}
 		}
-		
-		if(detectAndCloneSmallBlocks(aFunction, itCurr->collIfBranch))
+
+		/* Whatever is left belongs to removed blocks */
+		if(m_aNumQueued[uRule] > 0)
 		{
-			return true;
+			collQueued.assign(collQueued.size(), false);
+			m_aNumQueued[uRule] = 0;
 		}
 
-		if(detectAndCloneSmallBlocks(aFunction, itCurr->collElseBranch))
+		return BLOCK_NONE;
+	}
+
+	bool isEmpty(unsigned uRule) const
+	{
+		return m_aNumQueued[uRule] == 0;
+	}
+
+private:
+	void enqueue(unsigned uRule, tBlockIdx uBlock)
+	{
+		tOrderKey uKey = m_aGraph.getOrderKey(uBlock);
+
+		if(uKey != ORDER_NONE)
 		{
-			return true;
+			m_aQueue[uRule].push(tQueuedBlock(uKey, uBlock));
 		}
+	}
+
+	const ControlFlowGraph &m_aGraph;
+	std::vector<bool> m_aQueued[OR_NUM_RULES];
+	unsigned m_aNumQueued[OR_NUM_RULES];
+	tBlockQueue m_aQueue[OR_NUM_RULES];
+};
+
+/* Queues every block whose rules may see a different result after uBlock */
+/* has changed: the block itself, the blocks in front of it whose rules   */
+/* look ahead (up to the next jump target or the end of a small block),   */
+/* and the same again for the enclosing branch owners                     */
+static void queueChangedBlock(const ControlFlowGraph &aGraph, RewriteWorklist &aWorklist, tBlockIdx uBlock)
+{
+	while(uBlock != BLOCK_NONE)
+	{
+		tBlockIdx uCurr = uBlock;
+		bool bPassedTarget = false;
+		bool bReachedTarget = false;
+
+		aWorklist.push(uBlock);
+
+		/* Single jump blocks and else branches */
+		while((!bPassedTarget) || (!bReachedTarget))
+		{
+			tBlockIdx uPrev = aGraph.getPrevBlock(uCurr);
+
+			if(uPrev == BLOCK_NONE)
+			{
+				break;
+			}
 
-		itCurr++;
+			aWorklist.push(uPrev);
+			bPassedTarget = bPassedTarget || aGraph.get(aGraph.getBlockBegin(uCurr)).bIsJumpTarget;
+			bReachedTarget = bReachedTarget || aGraph.get(aGraph.getBlockBegin(uPrev)).bIsJumpTarget;
+			uCurr = uPrev;
+		}
+
+		/* Small blocks to be cloned */
+		unsigned uInstructionCount = 0;
+
+		for(uCurr = aGraph.getPrevBlock(uBlock); uCurr != BLOCK_NONE; uCurr = aGraph.getPrevBlock(uCurr))
+		{
+			tInstPos aLast = aGraph.getBlockLast(uCurr);
+
+			uInstructionCount += getInstructionCount(aGraph, aGraph.getBlockBegin(uCurr), aLast, MAX_CLONE_INSTRUCTIONS);
+
+			if((isBlockEndJump(aGraph.get(aLast))) || (uInstructionCount > MAX_CLONE_INSTRUCTIONS))
+			{
+				break;
+			}
+
+			aWorklist.push(uCurr);
+		}
+
+		uBlock = aGraph.getOwner(uBlock);
 	}
+}
 
-	return false;
+static bool isFollowedByJumpTarget(const ControlFlowGraph &aGraph, tBlockIdx uBlock)
+{
+	tInstPos aNext = aGraph.getBlockLast(uBlock);
+	aGraph.next(aNext);
+
+	return (!ControlFlowGraph::isEnd(aNext)) && (aGraph.get(aNext).bIsJumpTarget);
 }
 
-bool optimizeInstructions(Function &aFunction)
+static void queueBranchScope(const ControlFlowGraph &aGraph, tBlockQueue &aQueue, const tRegionRef &aRegion)
 {
-#if 1
-	if(reassembleSingleJumpBlocks(aFunction, aFunction.m_collInstList))
+	for(tBlockIdx uBlock = aGraph.getBegin(aRegion).uBlock; uBlock != BLOCK_NONE; uBlock = aGraph.getNextBlock(uBlock))
 	{
-		return true;
+		aQueue.push(tQueuedBlock(aGraph.getOrderKey(uBlock), uBlock));
 	}
-#endif
+}
+
+/* End of branch jumps are only searched within the branches of      */
+/* instructions followed by a jump target (on every level). Blocks   */
+/* entering this scope without being changed themselves are queued.  */
+/* Only the given blocks, the blocks in front of them and the        */
+/* branches whose scope has changed are looked at, always the owners */
+/* before the blocks of their branches                               */
+static void updateBranchScope(const ControlFlowGraph &aGraph, RewriteWorklist &aWorklist, const std::vector<tBlockIdx> &collBlocks,
+	std::vector<bool> &collBranchScope, std::vector<bool> &collBranchesInScope)
+{
+	tBlockQueue aQueue;
+	tBlockIdx uLast = BLOCK_NONE;
 
-#if 1
-	if(detectElseBranch(aFunction.m_collInstList))
+	for(unsigned uIdx = 0; uIdx < collBlocks.size(); uIdx++)
 	{
-		return true;
+		tBlockIdx uBlock = collBlocks[uIdx];
+
+		if(aGraph.getOrderKey(uBlock) == ORDER_NONE)
+		{
+			continue;
+		}
+
+		aQueue.push(tQueuedBlock(aGraph.getOrderKey(uBlock), uBlock));
+
+		/* Whether it is followed by a jump target may have changed */
+		if(aGraph.getPrevBlock(uBlock) != BLOCK_NONE)
+		{
+			aQueue.push(tQueuedBlock(aGraph.getOrderKey(aGraph.getPrevBlock(uBlock)), aGraph.getPrevBlock(uBlock)));
+		}
 	}
-#endif
 
-#if 1
-	if(detectOnlyElseBranch(aFunction.m_collInstList))
+	while(!aQueue.empty())
 	{
-		return true;
+		tBlockIdx uBlock = aQueue.top().second;
+
+		aQueue.pop();
+
+		if(uBlock == uLast)
+		{
+			continue;
+		}
+
+		uLast = uBlock;
+
+		if(uBlock >= collBranchScope.size())
+		{
+			collBranchScope.resize(uBlock + 1, false);
+			collBranchesInScope.resize(uBlock + 1, false);
+		}
+
+		tBlockIdx uOwner = aGraph.getOwner(uBlock);
+		bool bInScope = (uOwner == BLOCK_NONE) || (collBranchesInScope[uOwner]);
+		bool bBranchesInScope = (bInScope) && (isFollowedByJumpTarget(aGraph, uBlock));
+
+		if((bInScope) && (!collBranchScope[uBlock]))
+		{
+			aWorklist.push(OR_END_OF_BRANCH_JUMPS, uBlock);
+		}
+
+		collBranchScope[uBlock] = bInScope;
+
+		if(bBranchesInScope != collBranchesInScope[uBlock])
+		{
+			tInstPos aLast = aGraph.getBlockLast(uBlock);
+
+			collBranchesInScope[uBlock] = bBranchesInScope;
+			queueBranchScope(aGraph, aQueue, aGraph.getIfBranch(aLast));
+			queueBranchScope(aGraph, aQueue, aGraph.getElseBranch(aLast));
+		}
 	}
-#endif
+}
 
-#if 1
-	if(detectEndOfBranchJumps(aFunction.m_collInstList))
+/* Applies the rewrite rules until none matches anymore. Like before the */
+/* highest priority rule is always applied first at the first matching   */
+/* position, but only the blocks affected by the previous rewrite are    */
+/* looked at again                                                       */
+void optimizeInstructions(Function &aFunction, OptimizerStats &aStats)
+{
+	ControlFlowGraph &aGraph = aFunction.m_aGraph;
+	RewriteWorklist aWorklist(aGraph);
+	std::vector<tBlockIdx> collBlocks;
+	std::vector<tBlockIdx> collChanged;
+	std::vector<tBlockIdx> collReordered;
+	std::vector<bool> collBranchScope;
+	std::vector<bool> collBranchesInScope;
+	bool bSweep = true;
+	bool bSweepDone = false;
+
+	aGraph.getBlocks(ControlFlowGraph::getBody(), collBlocks);
+	aWorklist.pushAll(collBlocks);
+	updateBranchScope(aGraph, aWorklist, collBlocks, collBranchScope, collBranchesInScope);
+
+	while(true)
 	{
-		return true;
-	}
-#endif
+		unsigned uRule = 0;
 
-#if 1
-	if(detectEpilogProlog(aFunction))
+		while((uRule < OR_NUM_RULES) && (aWorklist.isEmpty(uRule)))
+		{
+			uRule++;
+		}
+
+		if(uRule == OR_NUM_RULES)
+		{
+			if(bSweepDone)
+			{
+				break;
+			}
+
+			/* Close with a sweep over the whole function, this only */
+			/* finds something if a dependency has been overlooked   */
+			collBlocks.clear();
+			aGraph.getBlocks(ControlFlowGraph::getBody(), collBlocks);
+			aWorklist.pushAll(collBlocks);
+			bSweep = true;
+			bSweepDone = true;
+			continue;
+		}
+
+		tRuleStats &aRuleStats = aStats.aRules[uRule];
+		double dStartTime = getTimeSeconds();
+		bool bHit = false;
+		tBlockIdx uBlock;
+
+		while((!bHit) && ((uBlock = aWorklist.pop(uRule)) != BLOCK_NONE))
+		{
+			aRuleStats.uChecks++;
+			bHit = applyRule(aFunction, (tOptimizerRule)uRule, uBlock, collBranchScope);
+		}
+
+		aRuleStats.dTime += getTimeSeconds() - dStartTime;
+
+		if(!bHit)
+		{
+			continue;
+		}
+
+		aRuleStats.uHits++;
+		aFunction.uOptimizationPasses++;
+
+		/* The first sweep is the initial one */
+		if((bSweep) && (bSweepDone))
+		{
+			aStats.uSweepHits++;
+		}
+
+		bSweep = false;
+		bSweepDone = false;
+
+		dStartTime = getTimeSeconds();
+		aGraph.commitChanges(collChanged, collReordered);
+
+		for(unsigned uIdx = 0; uIdx < collReordered.size(); uIdx++)
+		{
+			aWorklist.reorder(collReordered[uIdx]);
+		}
+
+		for(unsigned uIdx = 0; uIdx < collChanged.size(); uIdx++)
+		{
+			queueChangedBlock(aGraph, aWorklist, collChanged[uIdx]);
+		}
+
+		/* Moved blocks may have changed their owner */
+		collChanged.insert(collChanged.end(), collReordered.begin(), collReordered.end());
+		updateBranchScope(aGraph, aWorklist, collChanged, collBranchScope, collBranchesInScope);
+		aStats.dUpdateTime += getTimeSeconds() - dStartTime;
+	}
+}
+OptimizerStats::OptimizerStats(void) :
+		dUpdateTime(0.0),
+		uSweepHits(0)
+{
+	for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
 	{
-		return true;
+		aRules[uRule].uHits = 0;
+		aRules[uRule].uChecks = 0;
+		aRules[uRule].dTime = 0.0;
 	}
-#endif
+}
 
-#if 1
-	if(stripNops(aFunction.m_collInstList))
+void OptimizerStats::add(const OptimizerStats &aOther)
+{
+	for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
 	{
-		return true;
+		aRules[uRule].uHits += aOther.aRules[uRule].uHits;
+		aRules[uRule].uChecks += aOther.aRules[uRule].uChecks;
+		aRules[uRule].dTime += aOther.aRules[uRule].dTime;
 	}
-#endif
 
-#if 1
-	if(detectEndingIfBranch(aFunction.m_collInstList))
+	dUpdateTime += aOther.dUpdateTime;
+	uSweepHits += aOther.uSweepHits;
+}
+
+void OptimizerStats::print(FILE *pFile) const
+{
+	fprintf(pFile, "%-28s %10s %10s %12s\n", "Rule", "Hits", "Checks", "Time [ms]");
+
+	for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
 	{
-		return true;
+		fprintf(pFile, "%-28s %10d %10d %12.3f\n", getRuleName((tOptimizerRule)uRule),
+			aRules[uRule].uHits, aRules[uRule].uChecks, aRules[uRule].dTime * 1000.0);
 	}
-#endif
 
-#if 1
-	if(detectIdenticalIfElseBranch(aFunction.m_collInstList))
+	fprintf(pFile, "%-28s %10s %10s %12.3f\n", "jump target updates", "", "", dUpdateTime * 1000.0);
+
+	if(uSweepHits > 0)
 	{
-		return true;
+		fprintf(pFile, "%d rewrites were only found by the closing sweep\n", uSweepHits);
 	}
-#endif
+}
 
-#if 1
-	if(detectAndCloneSmallBlocks(aFunction, aFunction.m_collInstList))
+const char *getRuleName(tOptimizerRule eRule)
+{
+	switch(eRule)
 	{
-		return true;
+		case OR_SINGLE_JUMP_BLOCKS:
+			return "single jump blocks";
+		case OR_ELSE_BRANCH:
+			return "else branch";
+		case OR_ONLY_ELSE_BRANCH:
+			return "only else branch";
+		case OR_END_OF_BRANCH_JUMPS:
+			return "end of branch jumps";
+		case OR_EPILOG_PROLOG:
+			return "epilog/prolog";
+		case OR_NOPS:
+			return "nops";
+		case OR_ENDING_IF_BRANCH:
+			return "ending if branch";
+		case OR_IDENTICAL_IF_ELSE_BRANCH:
+			return "identical if/else branch";
+		case OR_CLONE_SMALL_BLOCKS:
+			return "clone small blocks";
+		default:
+			return "unknown";
 	}
-#endif
-
-	return false;
 }
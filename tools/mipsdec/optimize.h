@@ -1,10 +1,52 @@
 #ifndef OPTIMIZE_H
 #define OPTIMIZE_H
 
+#include <stdio.h>
 #include "instruction.h"
 #include "function.h"
+#include "cfg.h"
 
-bool resolveDelaySlots(tInstList &collInstList);
-bool optimizeInstructions(Function &aFunction);
+/* Rewrite rules in order of priority */
+typedef enum
+{
+	OR_SINGLE_JUMP_BLOCKS = 0,
+	OR_ELSE_BRANCH,
+	OR_ONLY_ELSE_BRANCH,
+	OR_END_OF_BRANCH_JUMPS,
+	OR_EPILOG_PROLOG,
+	OR_NOPS,
+	OR_ENDING_IF_BRANCH,
+	OR_IDENTICAL_IF_ELSE_BRANCH,
+	OR_CLONE_SMALL_BLOCKS,
+	OR_NUM_RULES
+} tOptimizerRule;
+
+typedef struct
+{
+	unsigned uHits;
+	unsigned uChecks;
+	double dTime;
+} tRuleStats;
+
+class OptimizerStats
+{
+public:
+	OptimizerStats(void);
+
+	void add(const OptimizerStats &aOther);
+	void print(FILE *pFile = stdout) const;
+
+	tRuleStats aRules[OR_NUM_RULES];
+
+	/* Time spent updating the jump targets and the worklist */
+	double dUpdateTime;
+
+	/* Rewrites only found by the closing sweep over the whole function */
+	unsigned uSweepHits;
+};
+
+const char *getRuleName(tOptimizerRule eRule);
+bool resolveDelaySlots(ControlFlowGraph &aGraph);
+void optimizeInstructions(Function &aFunction, OptimizerStats &aStats);
 
 #endif
@@ -1,8 +1,14 @@
 #include "parameter.h"
 #include "common.h"
 #include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
 
-#define DECLARE_BASIC_TYPE(size, name) { size, name	}
+#define DECLARE_BASIC_TYPE(size, name) { size, name, NULL, 0 }
+#define DECLARE_STRUCT_TYPE(name, fields) { 0, name, fields, sizeof(fields) / sizeof(fields[0]) }
 
 static const tTypeInfo aTypeVoid = DECLARE_BASIC_TYPE(0, "void");
 static const tTypeInfo aTypeChar = DECLARE_BASIC_TYPE(1, "char");
@@ -13,72 +19,82 @@ static const tTypeInfo aTypeUnsignedShort = DECLARE_BASIC_TYPE(2, "unsigned shor
 static const tTypeInfo aTypeUnsignedLong = DECLARE_BASIC_TYPE(4, "unsigned long");
 static const tTypeInfo aTypeTodo = DECLARE_BASIC_TYPE(4, "void");
 
-static const tTypeInfo aTypeListHead = { 0, "struct list_head",
-	{
-		{"next", TF_BY_REFERENCE, &aTypeListHead},
-		{"prev", TF_BY_REFERENCE, &aTypeListHead},
-	}
+extern const tTypeInfo aTypeListHead;
+
+static const tParameter aFieldsListHead[] =
+{
+	{"next", TF_BY_REFERENCE, &aTypeListHead},
+	{"prev", TF_BY_REFERENCE, &aTypeListHead},
 };
 
-static const tTypeInfo aTypeResource = { 0, "struct resource",
-	{
-		{"name", TF_BY_REFERENCE | TF_CONST, &aTypeChar},
-		{"start", TF_NONE, &aTypeUnsignedLong},
-		{"end", TF_NONE, &aTypeUnsignedLong},
-		{"flags", TF_NONE, &aTypeUnsignedLong},
-		{"parent", TF_BY_REFERENCE, &aTypeResource},
-		{"silbing", TF_BY_REFERENCE, &aTypeResource},
-		{"child", TF_BY_REFERENCE, &aTypeResource},
-	}
+const tTypeInfo aTypeListHead = DECLARE_STRUCT_TYPE("struct list_head", aFieldsListHead);
+
+extern const tTypeInfo aTypeResource;
+
+static const tParameter aFieldsResource[] =
+{
+	{"name", TF_BY_REFERENCE | TF_CONST, &aTypeChar},
+	{"start", TF_NONE, &aTypeUnsignedLong},
+	{"end", TF_NONE, &aTypeUnsignedLong},
+	{"flags", TF_NONE, &aTypeUnsignedLong},
+	{"parent", TF_BY_REFERENCE, &aTypeResource},
+	{"silbing", TF_BY_REFERENCE, &aTypeResource},
+	{"child", TF_BY_REFERENCE, &aTypeResource},
 };
 
-static const tTypeInfo aTypePciDeviceId = { 0, "struct pci_device_id",
-	{
-		{"vendor", TF_NONE, &aTypeUnsignedInt},
-		{"device", TF_NONE, &aTypeUnsignedInt},
-		{"subvendor", TF_NONE, &aTypeUnsignedInt},
-		{"subdevice", TF_NONE, &aTypeUnsignedInt},
-		{"class", TF_NONE, &aTypeUnsignedInt},
-		{"class_mask", TF_NONE, &aTypeUnsignedInt},
-		{"driver_data", TF_NONE, &aTypeUnsignedLong},
-	}
+const tTypeInfo aTypeResource = DECLARE_STRUCT_TYPE("struct resource", aFieldsResource);
+
+static const tParameter aFieldsPciDeviceId[] =
+{
+	{"vendor", TF_NONE, &aTypeUnsignedInt},
+	{"device", TF_NONE, &aTypeUnsignedInt},
+	{"subvendor", TF_NONE, &aTypeUnsignedInt},
+	{"subdevice", TF_NONE, &aTypeUnsignedInt},
+	{"class", TF_NONE, &aTypeUnsignedInt},
+	{"class_mask", TF_NONE, &aTypeUnsignedInt},
+	{"driver_data", TF_NONE, &aTypeUnsignedLong},
 };
 
+static const tTypeInfo aTypePciDeviceId = DECLARE_STRUCT_TYPE("struct pci_device_id", aFieldsPciDeviceId);
+
 extern const tTypeInfo aTypePciDev;
+extern const tTypeInfo aTypePciBus;
 
-static const tTypeInfo aTypePciBus = { 0, "struct pci_bus",
-	{
-		{"node", TF_NONE, &aTypeListHead},
-		{"parent", TF_BY_REFERENCE, &aTypePciBus},
-		{"children", TF_NONE, &aTypeListHead},
-		{"devices", TF_NONE, &aTypeListHead},
-		{"self", TF_BY_REFERENCE, &aTypePciDev},
-		{"resource", TF_BY_REFERENCE, &aTypeResource, 4},
-		{"ops", TF_BY_REFERENCE, &aTypeTodo}, // struct pci_ops
-		{"sysdata", TF_BY_REFERENCE, &aTypeVoid},
-		{"procdir", TF_BY_REFERENCE, &aTypeTodo}, // struct proc_dir_entry
-		{"number", TF_NONE, &aTypeUnsignedChar},
-		{"primary", TF_NONE, &aTypeUnsignedChar},
-		{"secondary", TF_NONE, &aTypeUnsignedChar},
-		{"subordinate", TF_NONE, &aTypeUnsignedChar},
-		{"name", TF_NONE, &aTypeUnsignedChar, 48},
-		{"vendor", TF_NONE, &aTypeUnsignedShort},
-		{"device", TF_NONE, &aTypeUnsignedShort},
-		{"serial", TF_NONE, &aTypeUnsignedInt},
-		{"pnpver", TF_NONE, &aTypeUnsignedChar},
-		{"productver", TF_NONE, &aTypeUnsignedChar},
-		{"checksum", TF_NONE, &aTypeUnsignedChar},
-		{"pad1", TF_NONE, &aTypeUnsignedChar},
-	}
+static const tParameter aFieldsPciBus[] =
+{
+	{"node", TF_NONE, &aTypeListHead},
+	{"parent", TF_BY_REFERENCE, &aTypePciBus},
+	{"children", TF_NONE, &aTypeListHead},
+	{"devices", TF_NONE, &aTypeListHead},
+	{"self", TF_BY_REFERENCE, &aTypePciDev},
+	{"resource", TF_BY_REFERENCE, &aTypeResource, 4},
+	{"ops", TF_BY_REFERENCE, &aTypeTodo}, // struct pci_ops
+	{"sysdata", TF_BY_REFERENCE, &aTypeVoid},
+	{"procdir", TF_BY_REFERENCE, &aTypeTodo}, // struct proc_dir_entry
+	{"number", TF_NONE, &aTypeUnsignedChar},
+	{"primary", TF_NONE, &aTypeUnsignedChar},
+	{"secondary", TF_NONE, &aTypeUnsignedChar},
+	{"subordinate", TF_NONE, &aTypeUnsignedChar},
+	{"name", TF_NONE, &aTypeUnsignedChar, 48},
+	{"vendor", TF_NONE, &aTypeUnsignedShort},
+	{"device", TF_NONE, &aTypeUnsignedShort},
+	{"serial", TF_NONE, &aTypeUnsignedInt},
+	{"pnpver", TF_NONE, &aTypeUnsignedChar},
+	{"productver", TF_NONE, &aTypeUnsignedChar},
+	{"checksum", TF_NONE, &aTypeUnsignedChar},
+	{"pad1", TF_NONE, &aTypeUnsignedChar},
 };
 
-const tTypeInfo aTypePciDev = { 0, "struct pci_dev",
-	{
-		{"global_list", TF_NONE, &aTypeListHead},
-		{"bus_list", TF_NONE, &aTypeListHead},
-	}
+const tTypeInfo aTypePciBus = DECLARE_STRUCT_TYPE("struct pci_bus", aFieldsPciBus);
+
+static const tParameter aFieldsPciDev[] =
+{
+	{"global_list", TF_NONE, &aTypeListHead},
+	{"bus_list", TF_NONE, &aTypeListHead},
 };
 
+const tTypeInfo aTypePciDev = DECLARE_STRUCT_TYPE("struct pci_dev", aFieldsPciDev);
+
 #if 0
 struct pci_dev {
         struct list_head global_list;   /* node in list of all PCI devices */
@@ -138,22 +154,500 @@ struct pci_dev {
 };
 #endif
 
-static tFunctionParameters collFunctionParameters[] = 
+/* Types a signature can name without creating a new one */
+static const tTypeInfo *collKnownTypes[] =
 {
-#include "user_function_parameter.inc"
+	&aTypeVoid,
+	&aTypeChar,
+	&aTypeUnsignedChar,
+	&aTypeInt,
+	&aTypeUnsignedInt,
+	&aTypeUnsignedShort,
+	&aTypeUnsignedLong,
+	&aTypeListHead,
+	&aTypeResource,
+	&aTypePciDeviceId,
+	&aTypePciBus,
+	&aTypePciDev,
 };
 
-#define NUM_FUNCTION_PARAMETERS (sizeof(collFunctionParameters) / sizeof(collFunctionParameters[0]))
+#define NUM_KNOWN_TYPES (sizeof(collKnownTypes) / sizeof(collKnownTypes[0]))
+
+#define SIGNATURE_IDX_NONE (~0U)
+
+std::vector<FunctionSignatures::tSignature> FunctionSignatures::m_collSignatures;
+std::vector<tParameter> FunctionSignatures::m_collParameters;
+std::set<std::string> FunctionSignatures::m_collStrings;
+std::map<std::string, tTypeInfo> FunctionSignatures::m_mapTypes;
+std::vector<unsigned> FunctionSignatures::m_collNameHash;
+
+/**********************************************************************/
+/* One C prototype per line, '#', '//' and C comments are ignored:   */
+/*                                                                    */
+/*   int pci_enable_device(struct pci_dev *dev);                      */
+/*   int printk(const char *fmt, ...);                                */
+/*   int request_irq(unsigned int irq, void (*handler)(int), int f);  */
+/*                                                                    */
+/* Unknown types are created on the fly, unnamed parameters are named */
+/* after their position. Function pointer parameters become void *.   */
+/* Lines that can't be parsed are reported and skipped.               */
+/**********************************************************************/
+bool FunctionSignatures::parseSignatureFile(const std::string &strSignatureFile)
+{
+	m_collSignatures.clear();
+	m_collParameters.clear();
+	m_collStrings.clear();
+	m_mapTypes.clear();
+	m_collNameHash.clear();
+
+	FILE *pSignatureFile = fopen(strSignatureFile.c_str(), "r");
+
+	if(!pSignatureFile)
+	{
+		printf("Can't open signature file: %s\n", strSignatureFile.c_str());
+		return false;
+	}
+
+	char pBuf[4096];
+	unsigned uLine = 0;
+
+	while(fgets(pBuf, sizeof(pBuf), pSignatureFile))
+	{
+		uLine++;
+		pBuf[strcspn(pBuf, "\r\n")] = 0;
+
+		/* A partly parsed parameter list is dropped again */
+		size_t uNumParameters = m_collParameters.size();
+
+		if(!parseSignature(pBuf))
+		{
+			printf("Skipping signature line: %d (\"%s\")\n", uLine, pBuf);
+			m_collParameters.resize(uNumParameters);
+		}
+	}
+
+	fclose(pSignatureFile);
+
+	buildIndex();
+
+	return true;
+}
+
+static std::string trim(const std::string &strText)
+{
+	std::string::size_type uStart = strText.find_first_not_of(" \t\r\n");
+
+	if(uStart == std::string::npos)
+	{
+		return "";
+	}
+
+	return strText.substr(uStart, strText.find_last_not_of(" \t\r\n") - uStart + 1);
+}
+
+/* A C comment left open ends with the line, like the others */
+static std::string stripComments(const std::string &strLine)
+{
+	std::string strText = strLine.substr(0, std::min(strLine.find('#'), strLine.find("//")));
+	std::string::size_type uStart;
+
+	while((uStart = strText.find("/*")) != std::string::npos)
+	{
+		std::string::size_type uEnd = strText.find("*/", uStart + 2);
+
+		strText.replace(uStart, (uEnd == std::string::npos) ? std::string::npos : (uEnd + 2 - uStart), " ");
+	}
+
+	return strText;
+}
+
+/* Splits at the commas outside of parentheses, so that the parameters */
+/* of function pointers stay together                                  */
+static bool splitArguments(const std::string &strArguments, std::vector<std::string> &collArguments)
+{
+	unsigned uDepth = 0;
+	std::string::size_type uStart = 0;
+
+	for(std::string::size_type uPos = 0; uPos < strArguments.length(); uPos++)
+	{
+		if(strArguments[uPos] == '(')
+		{
+			uDepth++;
+		}
+		else if(strArguments[uPos] == ')')
+		{
+			if(!uDepth)
+			{
+				return false;
+			}
+
+			uDepth--;
+		}
+		else if((strArguments[uPos] == ',') && !uDepth)
+		{
+			collArguments.push_back(trim(strArguments.substr(uStart, uPos - uStart)));
+			uStart = uPos + 1;
+		}
+	}
+
+	collArguments.push_back(trim(strArguments.substr(uStart)));
+
+	return uDepth == 0;
+}
+
+/* "type (*name)(arguments)", the name may be missing */
+static bool parseFunctionPointer(const std::string &strArgument, std::string &strName)
+{
+	std::string::size_type uOpen = strArgument.find('(');
+	std::string::size_type uStar = strArgument.find_first_not_of(" \t", uOpen + 1);
+
+	if((uOpen == 0) || (uStar == std::string::npos) || (strArgument[uStar] != '*'))
+	{
+		return false;
+	}
+
+	std::string::size_type uClose = strArgument.find(')', uStar);
+
+	if(uClose == std::string::npos)
+	{
+		return false;
+	}
+
+	strName = trim(strArgument.substr(uStar + 1, uClose - uStar - 1));
+
+	for(std::string::size_type uPos = 0; uPos < strName.length(); uPos++)
+	{
+		if((strName[uPos] != '_') && !isalnum((unsigned char)strName[uPos]))
+		{
+			return false;
+		}
+	}
+
+	std::string strRest = trim(strArgument.substr(uClose + 1));
+
+	return (strRest.length() >= 2) && (strRest[0] == '(') && (strRest[strRest.length() - 1] == ')');
+}
+
+bool FunctionSignatures::parseSignature(const std::string &strLine)
+{
+	std::string strSignature = trim(stripComments(strLine));
+
+	if(strSignature.empty())
+	{
+		return true;
+	}
+
+	std::string::size_type uOpen = strSignature.find('(');
+	std::string::size_type uClose = strSignature.rfind(')');
+
+	if((uOpen == std::string::npos) || (uClose == std::string::npos) || (uClose < uOpen) ||
+		(trim(strSignature.substr(uClose + 1)).find_first_not_of(";") != std::string::npos))
+	{
+		return false;
+	}
+
+	tSignature aSignature;
+	tParameter aReturnValue;
+	std::string strFunctionName;
+
+	if(!parseDeclaration(strSignature.substr(0, uOpen), true, strFunctionName, aReturnValue))
+	{
+		return false;
+	}
+
+	aSignature.pName = storeString(strFunctionName);
+	aSignature.uFirstParameter = m_collParameters.size();
+	aReturnValue.pName = storeString("ret");
+	m_collParameters.push_back(aReturnValue);
+
+	std::string strArguments = trim(strSignature.substr(uOpen + 1, uClose - uOpen - 1));
+
+	std::vector<std::string> collArguments;
+
+	if((strArguments != "") && (strArguments != "void") && !splitArguments(strArguments, collArguments))
+	{
+		return false;
+	}
+
+	for(unsigned uArgIdx = 0; uArgIdx < collArguments.size(); uArgIdx++)
+	{
+		const std::string &strArgument = collArguments[uArgIdx];
+		tParameter aParameter;
+
+		if(strArgument == "...")
+		{
+			aParameter.pName = storeString(strArgument);
+			aParameter.uFlags = TF_NONE;
+			aParameter.pInfo = NULL;
+			aParameter.uArrayElements = 0;
+		}
+		else
+		{
+			std::string strName;
+
+			if(strArgument.find('(') != std::string::npos)
+			{
+				if(!parseFunctionPointer(strArgument, strName))
+				{
+					return false;
+				}
+
+				aParameter.uFlags = TF_BY_REFERENCE;
+				aParameter.pInfo = &aTypeVoid;
+				aParameter.uArrayElements = 0;
+			}
+			else if(!parseDeclaration(strArgument, false, strName, aParameter))
+			{
+				return false;
+			}
+
+			if(strName.empty())
+			{
+				char pName[32];
+				sprintf(pName, "arg%u", (unsigned)(m_collParameters.size() - aSignature.uFirstParameter));
+				strName = pName;
+			}
+
+			aParameter.pName = storeString(strName);
+		}
+
+		m_collParameters.push_back(aParameter);
+	}
+
+	tParameter aTerminator = { NULL, TF_NONE, NULL, 0 };
+	m_collParameters.push_back(aTerminator);
+	m_collSignatures.push_back(aSignature);
+
+	return true;
+}
 
-tParameter *getFunctionParameters(const std::string &strFunctionName)
+static bool isTypeKeyword(const std::string &strWord)
 {
-	for(unsigned uIdx = 0; uIdx < NUM_FUNCTION_PARAMETERS; uIdx++)
+	static const char *pKeywords[] = { "void", "char", "short", "int", "long", "signed", "unsigned", "float", "double" };
+
+	for(unsigned uIdx = 0; uIdx < (sizeof(pKeywords) / sizeof(pKeywords[0])); uIdx++)
+	{
+		if(strWord == pKeywords[uIdx])
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Pointers beyond the first level and arrays end up in the type name */
+bool FunctionSignatures::parseDeclaration(const std::string &strDeclaration, bool bNameRequired, std::string &strName, tParameter &aParameter)
+{
+	std::vector<std::string> collWords;
+	unsigned uIndirections = 0;
+	unsigned uFlags = TF_NONE;
+	std::string::size_type uPos = 0;
+
+	while(uPos < strDeclaration.length())
+	{
+		char cChar = strDeclaration[uPos];
+
+		if((cChar == ' ') || (cChar == '\t'))
+		{
+			uPos++;
+		}
+		else if(cChar == '*')
+		{
+			uIndirections++;
+			uPos++;
+		}
+		else if(cChar == '[')
+		{
+			std::string::size_type uEnd = strDeclaration.find(']', uPos);
+
+			if(uEnd == std::string::npos)
+			{
+				return false;
+			}
+
+			uIndirections++;
+			uPos = uEnd + 1;
+		}
+		else if((cChar == '_') || isalnum((unsigned char)cChar))
+		{
+			std::string::size_type uEnd = uPos;
+
+			while((uEnd < strDeclaration.length()) && ((strDeclaration[uEnd] == '_') || isalnum((unsigned char)strDeclaration[uEnd])))
+			{
+				uEnd++;
+			}
+
+			std::string strWord = strDeclaration.substr(uPos, uEnd - uPos);
+
+			if(strWord == "const")
+			{
+				uFlags |= TF_CONST;
+			}
+			else if((strWord != "extern") && (strWord != "static") && (strWord != "inline") && (strWord != "volatile"))
+			{
+				collWords.push_back(strWord);
+			}
+
+			uPos = uEnd;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	/* The last word names the declaration unless it's part of the type */
+	size_t uNumWords = collWords.size();
+
+	if(bNameRequired || ((uNumWords >= 2) && !isTypeKeyword(collWords[uNumWords - 1]) &&
+		(collWords[uNumWords - 2] != "struct") && (collWords[uNumWords - 2] != "union") && (collWords[uNumWords - 2] != "enum")))
 	{
-		if(strFunctionName == collFunctionParameters[uIdx].pName)
+		if(uNumWords < 2)
 		{
-			return collFunctionParameters[uIdx].collParameters;
+			return false;
 		}
+
+		strName = collWords[--uNumWords];
+	}
+	else
+	{
+		strName = "";
+	}
+
+	if(!uNumWords)
+	{
+		return false;
+	}
+
+	std::string strTypeName = collWords[0];
+
+	for(unsigned uIdx = 1; uIdx < uNumWords; uIdx++)
+	{
+		strTypeName += " " + collWords[uIdx];
+	}
+
+	if(uIndirections)
+	{
+		uFlags |= TF_BY_REFERENCE;
+		strTypeName += (uIndirections > 1) ? " " : "";
+		strTypeName.append(uIndirections - 1, '*');
+	}
+
+	aParameter.pName = NULL;
+	aParameter.uFlags = uFlags;
+	aParameter.pInfo = getType(strTypeName);
+	aParameter.uArrayElements = 0;
+
+	return true;
+}
+
+const tTypeInfo *FunctionSignatures::getType(const std::string &strTypeName)
+{
+	for(unsigned uIdx = 0; uIdx < NUM_KNOWN_TYPES; uIdx++)
+	{
+		if(strTypeName == collKnownTypes[uIdx]->pName)
+		{
+			return collKnownTypes[uIdx];
+		}
+	}
+
+	std::map<std::string, tTypeInfo>::iterator it = m_mapTypes.find(strTypeName);
+
+	if(it == m_mapTypes.end())
+	{
+		tTypeInfo aType = DECLARE_BASIC_TYPE(0, NULL);
+
+		it = m_mapTypes.insert(std::make_pair(strTypeName, aType)).first;
+		it->second.pName = it->first.c_str();
+	}
+
+	return &it->second;
+}
+
+const char *FunctionSignatures::storeString(const std::string &strString)
+{
+	return m_collStrings.insert(strString).first->c_str();
+}
+
+/* FNV-1a */
+unsigned FunctionSignatures::hashName(const char *pName)
+{
+	unsigned uHash = 2166136261U;
+
+	while(*pName)
+	{
+		uHash ^= (unsigned char)*pName++;
+		uHash *= 16777619U;
+	}
+
+	return uHash;
+}
+
+void FunctionSignatures::buildIndex(void)
+{
+	size_t uNumSignatures = m_collSignatures.size();
+	size_t uHashSize = 16;
+
+	while(uHashSize < (uNumSignatures * 2))
+	{
+		uHashSize <<= 1;
+	}
+
+	m_collNameHash.assign(uHashSize, SIGNATURE_IDX_NONE);
+
+	for(unsigned uIdx = 0; uIdx < uNumSignatures; uIdx++)
+	{
+		const char *pName = m_collSignatures[uIdx].pName;
+		size_t uSlot = hashName(pName) & (uHashSize - 1);
+
+		while(m_collNameHash[uSlot] != SIGNATURE_IDX_NONE)
+		{
+			/* Keep the first signature of duplicate names, the names */
+			/* are interned so comparing the pointers is enough      */
+			if(m_collSignatures[m_collNameHash[uSlot]].pName == pName)
+			{
+				break;
+			}
+
+			uSlot = (uSlot + 1) & (uHashSize - 1);
+		}
+
+		if(m_collNameHash[uSlot] == SIGNATURE_IDX_NONE)
+		{
+			m_collNameHash[uSlot] = uIdx;
+		}
+	}
+}
+
+/* Read-only after parseSignatureFile(), so workers may look up concurrently */
+const tParameter *FunctionSignatures::lookup(const std::string &strFunctionName)
+{
+	size_t uHashSize = m_collNameHash.size();
+
+	if(!uHashSize)
+	{
+		return NULL;
+	}
+
+	size_t uSlot = hashName(strFunctionName.c_str()) & (uHashSize - 1);
+
+	while(m_collNameHash[uSlot] != SIGNATURE_IDX_NONE)
+	{
+		const tSignature &aSignature = m_collSignatures[m_collNameHash[uSlot]];
+
+		if(strFunctionName == aSignature.pName)
+		{
+			return &m_collParameters[aSignature.uFirstParameter];
+		}
+
+		uSlot = (uSlot + 1) & (uHashSize - 1);
 	}
 
 	return NULL;
-}
\ No newline at end of file
+}
+
+size_t FunctionSignatures::getCount(void)
+{
+	return m_collSignatures.size();
+}
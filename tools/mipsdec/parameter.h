@@ -2,6 +2,9 @@
 #define PARAMETER_H
 
 #include <string>
+#include <vector>
+#include <set>
+#include <map>
 
 typedef enum {
 	TF_NONE = 0,
@@ -23,14 +26,45 @@ typedef struct TypeInfo
 {
 	unsigned uSize;
 	const char *pName;
-	tParameter subFields[100];
+	const tParameter *pSubFields;
+	unsigned uNumSubFields;
 } tTypeInfo;
 
-typedef struct {
-	const char *pName;
-	tParameter collParameters[100];
-} tFunctionParameters;
+/* Parameter lists start with the return value and end with an entry */
+/* without name, variable arguments have no type info                */
+class FunctionSignatures
+{
+public:
+	static bool parseSignatureFile(const std::string &strSignatureFile);
+	static const tParameter *lookup(const std::string &strFunctionName);
+	static size_t getCount(void);
+
+private:
+	static bool parseSignature(const std::string &strLine);
+	static bool parseDeclaration(const std::string &strDeclaration, bool bNameRequired, std::string &strName, tParameter &aParameter);
+	static const tTypeInfo *getType(const std::string &strTypeName);
+	static const char *storeString(const std::string &strString);
+	static void buildIndex(void);
+	static unsigned hashName(const char *pName);
+
+	typedef struct
+	{
+		const char *pName;
+		unsigned uFirstParameter;
+	} tSignature;
+
+	static std::vector<tSignature> m_collSignatures;
+
+	/* All parameter lists back to back, each with its terminator */
+	static std::vector<tParameter> m_collParameters;
+
+	/* Names and types referenced by the parameters, nodes of sets */
+	/* and maps never move                                         */
+	static std::set<std::string> m_collStrings;
+	static std::map<std::string, tTypeInfo> m_mapTypes;
 
-tParameter *getFunctionParameters(const std::string &strFunctionName);
+	/* Open addressed name hash like the one of the symbols */
+	static std::vector<unsigned> m_collNameHash;
+};
 
 #endif
@@ -0,0 +1,129 @@
+#include "profile.h"
+#include "common.h"
+
+Profile::Profile(void) :
+		uNumFunctions(0),
+		uNumInstructions(0),
+		uNumCacheLookups(0),
+		uNumCacheHits(0),
+		dWallTime(0.0)
+{
+	for(unsigned uPhase = 0; uPhase < PP_NUM_PHASES; uPhase++)
+	{
+		aPhaseTimes[uPhase] = 0.0;
+	}
+}
+
+void Profile::add(const Profile &aOther)
+{
+	uNumFunctions += aOther.uNumFunctions;
+	uNumInstructions += aOther.uNumInstructions;
+	uNumCacheLookups += aOther.uNumCacheLookups;
+	uNumCacheHits += aOther.uNumCacheHits;
+
+	for(unsigned uPhase = 0; uPhase < PP_NUM_PHASES; uPhase++)
+	{
+		aPhaseTimes[uPhase] += aOther.aPhaseTimes[uPhase];
+	}
+
+	aOptimizer.add(aOther.aOptimizer);
+}
+
+void Profile::print(FILE *pFile, tProfileFormat eFormat) const
+{
+	if(eFormat == PF_JSON)
+	{
+		printJson(pFile);
+	}
+	else
+	{
+		printTable(pFile);
+	}
+}
+
+static double getRate(unsigned uCount, double dTime)
+{
+	return (dTime > 0.0) ? (uCount / dTime) : 0.0;
+}
+
+double Profile::getCacheHitRate(void) const
+{
+	return uNumCacheLookups ? ((100.0 * uNumCacheHits) / uNumCacheLookups) : 0.0;
+}
+
+void Profile::printTable(FILE *pFile) const
+{
+	fprintf(pFile, "%d functions, %d instructions in %.3f seconds (%.1f functions/s, %.1f instructions/s)\n",
+		uNumFunctions, uNumInstructions, dWallTime, getRate(uNumFunctions, dWallTime), getRate(uNumInstructions, dWallTime));
+
+	if(uNumCacheLookups)
+	{
+		fprintf(pFile, "Cache: %d of %d functions hit (%.1f%%)\n", uNumCacheHits, uNumCacheLookups, getCacheHitRate());
+	}
+
+	fprintf(pFile, "%-28s %12s\n", "Phase", "Time [ms]");
+
+	for(unsigned uPhase = 0; uPhase < PP_NUM_PHASES; uPhase++)
+	{
+		fprintf(pFile, "%-28s %12.3f\n", getPhaseName((tProfilePhase)uPhase), aPhaseTimes[uPhase] * 1000.0);
+	}
+
+	fprintf(pFile, "\n");
+	aOptimizer.print(pFile);
+}
+
+/* Rule and phase names don't need any escaping */
+void Profile::printJson(FILE *pFile) const
+{
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "  \"functions\": %d,\n", uNumFunctions);
+	fprintf(pFile, "  \"instructions\": %d,\n", uNumInstructions);
+	fprintf(pFile, "  \"wall_time_ms\": %.3f,\n", dWallTime * 1000.0);
+	fprintf(pFile, "  \"functions_per_second\": %.1f,\n", getRate(uNumFunctions, dWallTime));
+	fprintf(pFile, "  \"instructions_per_second\": %.1f,\n", getRate(uNumInstructions, dWallTime));
+	fprintf(pFile, "  \"cache_lookups\": %d,\n", uNumCacheLookups);
+	fprintf(pFile, "  \"cache_hits\": %d,\n", uNumCacheHits);
+	fprintf(pFile, "  \"cache_hit_rate\": %.1f,\n", getCacheHitRate());
+	fprintf(pFile, "  \"phases\": [\n");
+
+	for(unsigned uPhase = 0; uPhase < PP_NUM_PHASES; uPhase++)
+	{
+		fprintf(pFile, "    { \"name\": \"%s\", \"time_ms\": %.3f }%s\n", getPhaseName((tProfilePhase)uPhase),
+			aPhaseTimes[uPhase] * 1000.0, ((uPhase + 1) < PP_NUM_PHASES) ? "," : "");
+	}
+
+	fprintf(pFile, "  ],\n");
+	fprintf(pFile, "  \"rules\": [\n");
+
+	for(unsigned uRule = 0; uRule < OR_NUM_RULES; uRule++)
+	{
+		const tRuleStats &aRule = aOptimizer.aRules[uRule];
+
+		fprintf(pFile, "    { \"name\": \"%s\", \"hits\": %d, \"checks\": %d, \"time_ms\": %.3f }%s\n", getRuleName((tOptimizerRule)uRule),
+			aRule.uHits, aRule.uChecks, aRule.dTime * 1000.0, ((uRule + 1) < OR_NUM_RULES) ? "," : "");
+	}
+
+	fprintf(pFile, "  ],\n");
+	fprintf(pFile, "  \"jump_target_updates_ms\": %.3f,\n", aOptimizer.dUpdateTime * 1000.0);
+	fprintf(pFile, "  \"sweep_hits\": %d\n", aOptimizer.uSweepHits);
+	fprintf(pFile, "}\n");
+}
+
+const char *getPhaseName(tProfilePhase ePhase)
+{
+	switch(ePhase)
+	{
+		case PP_PARSE:
+			return "parse";
+		case PP_DELAY_SLOTS:
+			return "delay slots";
+		case PP_ANALYSIS:
+			return "stack and jump analysis";
+		case PP_OPTIMIZE:
+			return "optimize";
+		case PP_CODEGEN:
+			return "codegen";
+		default:
+			return "unknown";
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include "optimize.h"
+
+/* Steps of the pipeline run for every function */
+typedef enum
+{
+	PP_PARSE = 0,
+	PP_DELAY_SLOTS,
+	PP_ANALYSIS,
+	PP_OPTIMIZE,
+	PP_CODEGEN,
+	PP_NUM_PHASES
+} tProfilePhase;
+
+typedef enum
+{
+	PF_TABLE = 0,
+	PF_JSON
+} tProfileFormat;
+
+class Profile
+{
+public:
+	Profile(void);
+
+	void add(const Profile &aOther);
+	void print(FILE *pFile, tProfileFormat eFormat) const;
+	double getCacheHitRate(void) const;
+
+	unsigned uNumFunctions;
+	unsigned uNumInstructions;
+	unsigned uNumCacheLookups;
+	unsigned uNumCacheHits;
+
+	/* Summed up over all threads, so the phases may take longer */
+	/* than the wall time of a batch run                          */
+	double aPhaseTimes[PP_NUM_PHASES];
+
+	/* Measured by the caller, not summed up by add() */
+	double dWallTime;
+
+	OptimizerStats aOptimizer;
+
+private:
+	void printTable(FILE *pFile) const;
+	void printJson(FILE *pFile) const;
+};
+
+const char *getPhaseName(tProfilePhase ePhase);
+
+#endif
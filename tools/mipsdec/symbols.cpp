@@ -1,11 +1,53 @@
 #include "symbols.h"
+#include "image.h"
 #include "common.h"
+#include <algorithm>
+
+#define SYM_IDX_NONE (~0U)
 
 tSymList Symbols::m_collSymbolList;
+tSymIdxList Symbols::m_collAddressIndex;
+tSymIdxList Symbols::m_collNameHash;
+const BinaryImage *Symbols::m_pImage = NULL;
+
+class SymbolAddressLess
+{
+public:
+	SymbolAddressLess(const tSymList &collSymbolList) :
+		m_collSymbolList(collSymbolList)
+	{
+	}
+
+	bool operator()(unsigned uSymIdx1, unsigned uSymIdx2) const
+	{
+		return m_collSymbolList[uSymIdx1].uAddress < m_collSymbolList[uSymIdx2].uAddress;
+	}
+
+	bool operator()(unsigned uSymIdx, const unsigned *pAddress) const
+	{
+		return m_collSymbolList[uSymIdx].uAddress < *pAddress;
+	}
+
+	bool operator()(const unsigned *pAddress, unsigned uSymIdx) const
+	{
+		return *pAddress < m_collSymbolList[uSymIdx].uAddress;
+	}
+
+private:
+	const tSymList &m_collSymbolList;
+};
+
+/* The image is only read, it has to stay loaded while symbols are looked up */
+void Symbols::setImage(const BinaryImage *pImage)
+{
+	m_pImage = pImage;
+}
 
 bool Symbols::parseSymFile(const std::string &strSymFile)
 {
 	m_collSymbolList.clear();
+	m_collAddressIndex.clear();
+	m_collNameHash.clear();
 
 	FILE *pSymFile = fopen(strSymFile.c_str(), "r");
 	
@@ -47,22 +89,91 @@ bool Symbols::parseSymFile(const std::string &strSymFile)
 	}
 	
 	fclose(pSymFile);
+
+	buildIndex();
 	
 	return true;
+}
 
+/* FNV-1a */
+unsigned Symbols::hashName(const char *pName)
+{
+	unsigned uHash = 2166136261U;
+
+	while(*pName)
+	{
+		uHash ^= (unsigned char)*pName++;
+		uHash *= 16777619U;
+	}
+
+	return uHash;
 }
 
-bool Symbols::lookup(const std::string &strSymName, unsigned &uSymIdx)
+void Symbols::buildIndex(void)
 {
 	size_t uNumSymbols = m_collSymbolList.size();
 
+	m_collAddressIndex.resize(uNumSymbols);
+
 	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
 	{
-		if(m_collSymbolList[uIdx].strName == strSymName)
+		m_collAddressIndex[uIdx] = uIdx;
+	}
+
+	std::stable_sort(m_collAddressIndex.begin(), m_collAddressIndex.end(), SymbolAddressLess(m_collSymbolList));
+
+	size_t uHashSize = 16;
+
+	while(uHashSize < (uNumSymbols * 2))
+	{
+		uHashSize <<= 1;
+	}
+
+	m_collNameHash.assign(uHashSize, SYM_IDX_NONE);
+
+	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	{
+		const std::string &strName = m_collSymbolList[uIdx].strName;
+		size_t uSlot = hashName(strName.c_str()) & (uHashSize - 1);
+
+		while(m_collNameHash[uSlot] != SYM_IDX_NONE)
+		{
+			/* Keep the first definition of duplicate names */
+			if(m_collSymbolList[m_collNameHash[uSlot]].strName == strName)
+			{
+				break;
+			}
+
+			uSlot = (uSlot + 1) & (uHashSize - 1);
+		}
+
+		if(m_collNameHash[uSlot] == SYM_IDX_NONE)
 		{
-			uSymIdx = uIdx;
+			m_collNameHash[uSlot] = uIdx;
+		}
+	}
+}
+
+bool Symbols::lookup(const std::string &strSymName, unsigned &uSymIdx)
+{
+	size_t uHashSize = m_collNameHash.size();
+
+	if(!uHashSize)
+	{
+		return false;
+	}
+
+	size_t uSlot = hashName(strSymName.c_str()) & (uHashSize - 1);
+
+	while(m_collNameHash[uSlot] != SYM_IDX_NONE)
+	{
+		if(m_collSymbolList[m_collNameHash[uSlot]].strName == strSymName)
+		{
+			uSymIdx = m_collNameHash[uSlot];
 			return true;
 		}
+
+		uSlot = (uSlot + 1) & (uHashSize - 1);
 	}
 	
 	return false;
@@ -70,18 +181,97 @@ bool Symbols::lookup(const std::string &strSymName, unsigned &uSymIdx)
 
 bool Symbols::lookup(unsigned uAddress, unsigned &uSymIdx)
 {
-	size_t uNumSymbols = m_collSymbolList.size();
+	tSymIdxList::const_iterator it = std::lower_bound(m_collAddressIndex.begin(), m_collAddressIndex.end(), &uAddress, SymbolAddressLess(m_collSymbolList));
 
-	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	if((it == m_collAddressIndex.end()) || (m_collSymbolList[*it].uAddress != uAddress))
+	{
+		return false;
+	}
+
+	uSymIdx = *it;
+	return true;
+}
+
+/* Like lookup() but also resolves addresses inside of a symbol to the */
+/* closest symbol at or below the address. A symbol ends at the next   */
+/* symbol and at the end of its segment, the last symbol of the map    */
+/* only matches its own address unless the image is known              */
+bool Symbols::lookupContaining(unsigned uAddress, unsigned &uSymIdx)
+{
+	tSymIdxList::const_iterator it = std::upper_bound(m_collAddressIndex.begin(), m_collAddressIndex.end(), &uAddress, SymbolAddressLess(m_collSymbolList));
+
+	if(it == m_collAddressIndex.begin())
+	{
+		return false;
+	}
+
+	bool bHaveEnd = (it != m_collAddressIndex.end());
+	unsigned uEndAddress = bHaveEnd ? m_collSymbolList[*it].uAddress : 0;
+	unsigned uSymAddress = m_collSymbolList[*(it - 1)].uAddress;
+	unsigned uSegmentEnd;
+
+	if(uAddress != uSymAddress)
 	{
-		if(m_collSymbolList[uIdx].uAddress == uAddress)
+		if(m_pImage)
 		{
-			uSymIdx = uIdx;
-			return true;
+			if(!m_pImage->getSegmentEnd(uSymAddress, uSegmentEnd))
+			{
+				return false;
+			}
+
+			if((!bHaveEnd) || (uSegmentEnd < uEndAddress))
+			{
+				uEndAddress = uSegmentEnd;
+				bHaveEnd = true;
+			}
+		}
+
+		if((!bHaveEnd) || (uAddress >= uEndAddress))
+		{
+			return false;
 		}
 	}
-	
-	return false;
+
+	return lookup(uSymAddress, uSymIdx);
+}
+
+/* Address of the closest symbol above uAddress, independent of the */
+/* order of the map and of aliases at uAddress                      */
+bool Symbols::getNextAddress(unsigned uAddress, unsigned &uNextAddress)
+{
+	tSymIdxList::const_iterator it = std::upper_bound(m_collAddressIndex.begin(), m_collAddressIndex.end(), &uAddress, SymbolAddressLess(m_collSymbolList));
+
+	if(it == m_collAddressIndex.end())
+	{
+		return false;
+	}
+
+	uNextAddress = m_collSymbolList[*it].uAddress;
+	return true;
+}
+
+/* Name of a call or jump target, addresses inside of a symbol are */
+/* given as "symbol+0xOFFSET"                                        */
+bool Symbols::getTargetName(unsigned uAddress, std::string &strName)
+{
+	unsigned uSymIdx;
+
+	if(!lookupContaining(uAddress, uSymIdx))
+	{
+		return false;
+	}
+
+	strName = m_collSymbolList[uSymIdx].strName;
+
+	if(uAddress != m_collSymbolList[uSymIdx].uAddress)
+	{
+		char pOffset[16];
+
+		sprintf(pOffset, "+0x%X", uAddress - m_collSymbolList[uSymIdx].uAddress);
+		strName += pOffset;
+	}
+
+	return true;
 }
 
 size_t Symbols::getCount(void)
@@ -11,18 +11,39 @@ typedef struct {
 } tSymbolEntry;
 
 typedef std::vector<tSymbolEntry> tSymList;
+typedef std::vector<unsigned> tSymIdxList;
+
+class BinaryImage;
 
 class Symbols
 {
 public:
 	static bool parseSymFile(const std::string &strSymFile);
+	static void setImage(const BinaryImage *pImage);
 	static bool lookup(const std::string &strSymName, unsigned &uSymIdx);
 	static bool lookup(unsigned uAddress, unsigned &uSymIdx);
+	static bool lookupContaining(unsigned uAddress, unsigned &uSymIdx);
+	static bool getNextAddress(unsigned uAddress, unsigned &uNextAddress);
+	static bool getTargetName(unsigned uAddress, std::string &strName);
 	static size_t getCount(void);
 	static const tSymbolEntry *get(unsigned uSymIdx);
 
 private:
+	static void buildIndex(void);
+	static unsigned hashName(const char *pName);
+
 	static tSymList m_collSymbolList;
+
+	/* Symbol indices sorted by address (stable, so the first symbol */
+	/* in the map wins for aliases)                                  */
+	static tSymIdxList m_collAddressIndex;
+
+	/* Open addressed name hash, size is a power of two, empty slots */
+	/* hold ~0                                                       */
+	static tSymIdxList m_collNameHash;
+
+	/* Segments of the binary, they bound lookupContaining() */
+	static const BinaryImage *m_pImage;
 };
 
 #endif
@@ -0,0 +1,117 @@
+#include "thread.h"
+#include "common.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+Mutex::Mutex(void)
+{
+#ifdef _WIN32
+	InitializeCriticalSection(&m_aMutex);
+#else
+	pthread_mutex_init(&m_aMutex, NULL);
+#endif
+}
+
+Mutex::~Mutex(void)
+{
+#ifdef _WIN32
+	DeleteCriticalSection(&m_aMutex);
+#else
+	pthread_mutex_destroy(&m_aMutex);
+#endif
+}
+
+void Mutex::lock(void)
+{
+#ifdef _WIN32
+	EnterCriticalSection(&m_aMutex);
+#else
+	pthread_mutex_lock(&m_aMutex);
+#endif
+}
+
+void Mutex::unlock(void)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&m_aMutex);
+#else
+	pthread_mutex_unlock(&m_aMutex);
+#endif
+}
+
+bool Thread::start(tThreadFunc pFunc, void *pArg)
+{
+	M_ASSERT(!m_bRunning);
+
+	m_pFunc = pFunc;
+	m_pArg = pArg;
+
+#ifdef _WIN32
+	m_hThread = CreateThread(NULL, 0, threadEntry, this, 0, NULL);
+
+	if(!m_hThread)
+	{
+		return false;
+	}
+#else
+	if(pthread_create(&m_aThread, NULL, threadEntry, this) != 0)
+	{
+		return false;
+	}
+#endif
+
+	m_bRunning = true;
+
+	return true;
+}
+
+void Thread::join(void)
+{
+	if(!m_bRunning)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	WaitForSingleObject(m_hThread, INFINITE);
+	CloseHandle(m_hThread);
+#else
+	pthread_join(m_aThread, NULL);
+#endif
+
+	m_bRunning = false;
+}
+
+#ifdef _WIN32
+DWORD WINAPI Thread::threadEntry(LPVOID pThread)
+{
+	Thread *pThis = (Thread *)pThread;
+	pThis->m_pFunc(pThis->m_pArg);
+
+	return 0;
+}
+#else
+void *Thread::threadEntry(void *pThread)
+{
+	Thread *pThis = (Thread *)pThread;
+	pThis->m_pFunc(pThis->m_pArg);
+
+	return NULL;
+}
+#endif
+
+unsigned getNumCPUs(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO aSystemInfo;
+	GetSystemInfo(&aSystemInfo);
+
+	return aSystemInfo.dwNumberOfProcessors;
+#else
+	long iNumCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (iNumCPUs > 0) ? (unsigned)iNumCPUs : 1;
+#endif
+}
@@ -0,0 +1,64 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef void (*tThreadFunc)(void *pArg);
+
+class Mutex
+{
+public:
+	Mutex(void);
+	~Mutex(void);
+
+	void lock(void);
+	void unlock(void);
+
+private:
+	Mutex(const Mutex &);
+	Mutex &operator=(const Mutex &);
+
+#ifdef _WIN32
+	CRITICAL_SECTION m_aMutex;
+#else
+	pthread_mutex_t m_aMutex;
+#endif
+};
+
+class Thread
+{
+public:
+	Thread(void) :
+		m_pFunc(NULL),
+		m_pArg(NULL),
+		m_bRunning(false)
+	{
+	}
+
+	bool start(tThreadFunc pFunc, void *pArg);
+	void join(void);
+
+private:
+	Thread(const Thread &);
+	Thread &operator=(const Thread &);
+
+#ifdef _WIN32
+	static DWORD WINAPI threadEntry(LPVOID pThread);
+	HANDLE m_hThread;
+#else
+	static void *threadEntry(void *pThread);
+	pthread_t m_aThread;
+#endif
+
+	tThreadFunc m_pFunc;
+	void *m_pArg;
+	bool m_bRunning;
+};
+
+unsigned getNumCPUs(void);
+
+#endif
@@ -0,0 +1,26 @@
+#include "timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <stddef.h>
+#endif
+
+double getTimeSeconds(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER aFrequency;
+	LARGE_INTEGER aCounter;
+
+	QueryPerformanceFrequency(&aFrequency);
+	QueryPerformanceCounter(&aCounter);
+
+	return (double)aCounter.QuadPart / (double)aFrequency.QuadPart;
+#else
+	struct timeval aTime;
+	gettimeofday(&aTime, NULL);
+
+	return aTime.tv_sec + (aTime.tv_usec / 1000000.0);
+#endif
+}
@@ -0,0 +1,6 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+double getTimeSeconds(void);
+
+#endif
@@ -0,0 +1,236 @@
+#include "mipsdecode.h"
+#include <string.h>
+
+#define DECLARE_REGULAR_OPCODE(opcode, type, format, result_field, delayslot) {opcode, ~0U, ~0U, ~0U, #type, IT_##type, format, result_field, delayslot}
+#define DECLARE_SPECIAL_OPCODE(specialopcode, type, format, result_field, delayslot) {0x00, specialopcode, ~0U, ~0U, #type, IT_##type, format, result_field, delayslot}
+#define DECLARE_REGIMM_OPCODE(regdimmopcode, type, format, result_field, delayslot) {0x01, ~0U, regdimmopcode, ~0U, #type, IT_##type, format, result_field, delayslot}
+#define DECLARE_COP0_OPCODE(cop0opcode, type, format, result_field, delayslot) {0x10, ~0U, ~0U, cop0opcode, #type, IT_##type, format, result_field, delayslot}
+#define DECLARE_VIRTUAL_OPCODE(type, format, result_field, delayslot) {~0U, ~0U, ~0U, ~0U, #type, IT_##type, format, result_field, delayslot}
+
+static const tInstructionInfo s_InstructionInfo[] = 
+{
+	DECLARE_SPECIAL_OPCODE(0x21, ADDU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x09, ADDIU,	IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x24, AND,		IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0C, ANDI,	IF_RSRTUI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x04, BEQ,		IF_RSRTSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x14, BEQL,	IF_RSRTSI,	RF_NONE,	IDS_CONDITIONAL),
+	DECLARE_REGIMM_OPCODE (0x01, BGEZ,	IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x07, BGTZ,		IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x06, BLEZ,		IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGIMM_OPCODE (0x00, BLTZ,	IF_RSSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x05, BNE,		IF_RSRTSI,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x15, BNEL,	IF_RSRTSI,	RF_NONE,	IDS_CONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x02, J,		IF_NOARG,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_SPECIAL_OPCODE(0x09, JALR,	IF_RSRD,	RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_SPECIAL_OPCODE(0x08, JR,		IF_RS,		RF_NONE,	IDS_UNCONDITIONAL),
+	DECLARE_REGULAR_OPCODE(0x20, LB,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x24, LBU,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x21, LH,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x25, LHU,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0F, LUI,		IF_RTUI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x23, LW,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x22, LWL,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x26, LWR,		IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_COP0_OPCODE   (0x00, MFC0,	IF_RTRDSEL,	RF_RT,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x10, MFHI,	IF_RD,		RF_RD,		IDS_NONE),
+	DECLARE_COP0_OPCODE   (0x04, MTC0,	IF_RTRDSEL,	RF_NONE,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x18, MULT,	IF_RSRT,	RF_NONE,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x19, MULTU,	IF_RSRT,	RF_NONE,	IDS_NONE),
+	DECLARE_VIRTUAL_OPCODE(      NOP,		IF_NOARG,	RF_NONE,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x27, NOR,	IF_RSRTRD,	RF_RD,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x25, OR,		IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0D, ORI,		IF_RSRTUI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x28, SB,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x29, SH,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x00, SLL,		IF_RTRDSA,	RF_RD,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0A, SLTI,	IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0B, SLTIU,	IF_RSRTSI,	RF_RT,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x2B, SLTU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x03, SRA,		IF_RTRDSA,	RF_RD,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x07, SRAV,		IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x02, SRL,		IF_RTRDSA,	RF_RD,		IDS_NONE),
+	DECLARE_VIRTUAL_OPCODE(      SSNOP,	IF_NOARG,	RF_NONE,	IDS_NONE),
+	DECLARE_SPECIAL_OPCODE(0x23, SUBU,	IF_RSRTRD,	RF_RD,		IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x2B, SW,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x2A, SWL,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x2E, SWR,		IF_RSRTSI,	RF_NONE,	IDS_NONE),
+	DECLARE_REGULAR_OPCODE(0x0E, XORI,	IF_RSRTUI,	RF_RT,		IDS_NONE),
+};
+
+#define NUM_INSTRUCTION_INFO_ENTRIES (sizeof(s_InstructionInfo) / sizeof(s_InstructionInfo[0]))
+
+#define OPCODE_SPECIAL	0x00
+#define OPCODE_REGIMM	0x01
+#define OPCODE_COP0		0x10
+
+#define INFO_IDX_NONE		0xFF
+#define INFO_IDX_SPECIAL	0xFE
+#define INFO_IDX_REGIMM		0xFD
+#define INFO_IDX_COP0		0xFC
+
+/* Two level decode tables, indexed by the primary opcode and then by  */
+/* the function (SPECIAL), rt (REGIMM) or rs (COP0) field. They are    */
+/* filled from s_InstructionInfo during static initialization, so they */
+/* are complete and read-only before main() (and any worker) runs.     */
+class InstructionDecodeTables
+{
+public:
+	InstructionDecodeTables(void)
+	{
+		memset(m_pPrimary, INFO_IDX_NONE, sizeof(m_pPrimary));
+		memset(m_pSpecial, INFO_IDX_NONE, sizeof(m_pSpecial));
+		memset(m_pRegimm, INFO_IDX_NONE, sizeof(m_pRegimm));
+		memset(m_pCop0, INFO_IDX_NONE, sizeof(m_pCop0));
+		memset(m_pByType, INFO_IDX_NONE, sizeof(m_pByType));
+
+		m_pPrimary[OPCODE_SPECIAL] = INFO_IDX_SPECIAL;
+		m_pPrimary[OPCODE_REGIMM] = INFO_IDX_REGIMM;
+		m_pPrimary[OPCODE_COP0] = INFO_IDX_COP0;
+
+		for(unsigned uInfoIdx = 0; uInfoIdx < NUM_INSTRUCTION_INFO_ENTRIES; uInfoIdx++)
+		{
+			const tInstructionInfo &aInfo = s_InstructionInfo[uInfoIdx];
+
+			setEntry(m_pByType[aInfo.eType], uInfoIdx);
+
+			switch(aInfo.uOpcode)
+			{
+				case ~0U: /* Virtual instructions */
+					break;
+				case OPCODE_SPECIAL:
+					setEntry(m_pSpecial[aInfo.uSpecialOpcode], uInfoIdx);
+					break;
+				case OPCODE_REGIMM:
+					setEntry(m_pRegimm[aInfo.uRegimmOpcode], uInfoIdx);
+					break;
+				case OPCODE_COP0:
+					setEntry(m_pCop0[aInfo.uCop0Opcode], uInfoIdx);
+					break;
+				default:
+					setEntry(m_pPrimary[aInfo.uOpcode], uInfoIdx);
+					break;
+			}
+		}
+	}
+
+	unsigned char decode(unsigned uInstructionData) const
+	{
+		unsigned char uInfoIdx = m_pPrimary[uInstructionData >> 26];
+
+		switch(uInfoIdx)
+		{
+			case INFO_IDX_SPECIAL:
+				return m_pSpecial[uInstructionData & 0x3F];
+			case INFO_IDX_REGIMM:
+				return m_pRegimm[(uInstructionData >> 16) & 0x1F];
+			case INFO_IDX_COP0:
+				return m_pCop0[(uInstructionData >> 21) & 0x1F];
+			default:
+				return uInfoIdx;
+		}
+	}
+
+	unsigned char getByType(tInstructionType eType) const
+	{
+		return m_pByType[eType];
+	}
+
+private:
+	static void setEntry(unsigned char &uEntry, unsigned uInfoIdx)
+	{
+		/* First table entry wins, just like the old linear search */
+		if(uEntry == INFO_IDX_NONE)
+		{
+			uEntry = (unsigned char)uInfoIdx;
+		}
+	}
+
+	unsigned char m_pPrimary[64];
+	unsigned char m_pSpecial[64];
+	unsigned char m_pRegimm[32];
+	unsigned char m_pCop0[32];
+	unsigned char m_pByType[IT_NUM_TYPES];
+};
+
+static const InstructionDecodeTables s_DecodeTables;
+
+bool decodeInstruction(unsigned uInstructionData, unsigned uInstructionAddress, tDecodedInstruction &aDecoded)
+{
+	unsigned uInfoIdx = s_DecodeTables.decode(uInstructionData);
+
+	if(uInfoIdx == INFO_IDX_NONE)
+	{
+		return false;
+	}
+
+	aDecoded.eType = s_InstructionInfo[uInfoIdx].eType;
+	aDecoded.eFormat = s_InstructionInfo[uInfoIdx].eFormat;
+	aDecoded.uRS = (unsigned char)((uInstructionData >> 21) & 0x1F);
+	aDecoded.uRT = (unsigned char)((uInstructionData >> 16) & 0x1F);
+	aDecoded.uRD = (unsigned char)((uInstructionData >> 11) & 0x1F);
+	aDecoded.uSA = (unsigned char)((uInstructionData >> 6) & 0x1F);
+	aDecoded.uSEL = (unsigned char)(uInstructionData & 0x7);
+	aDecoded.uImmediate = (unsigned short)(uInstructionData & 0xFFFF);
+	aDecoded.uJumpAddress = 0;
+
+	switch(aDecoded.eType)
+	{
+		case IT_BEQ:
+		case IT_BEQL:
+		case IT_BGTZ:
+		case IT_BLEZ:
+		case IT_BLTZ:
+		case IT_BNE:
+		case IT_BNEL:
+			aDecoded.uJumpAddress = uInstructionAddress + 4 + (((signed short)aDecoded.uImmediate) << 2);
+			break;
+		case IT_J:
+			aDecoded.uJumpAddress = ((uInstructionAddress + 4) & ~0xFFFFFFF) | ((uInstructionData & 0x3FFFFFF) << 2);
+			break;
+		case IT_JALR:
+			if(uInstructionData & (1 << 10))
+			{
+				aDecoded.eType = IT_JALR_HB;
+			}
+			break;
+		case IT_JR:
+			if(uInstructionData & (1 << 10))
+			{
+				aDecoded.eType = IT_JR_HB;
+			}
+			break;
+		case IT_SLL:
+			if((aDecoded.uRT == 0) && (aDecoded.uRD == 0))
+			{
+				switch(aDecoded.uSA)
+				{
+					case 0x00:
+						aDecoded.eType = IT_NOP;
+						aDecoded.eFormat = IF_NOARG;
+						break;
+					case 0x01:
+						aDecoded.eType = IT_SSNOP;
+						aDecoded.eFormat = IF_NOARG;
+						break;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+
+	return true;
+}
+
+const tInstructionInfo *getInstructionInfo(tInstructionType eType)
+{
+	unsigned uInfoIdx = s_DecodeTables.getByType(eType);
+
+	if(uInfoIdx == INFO_IDX_NONE)
+	{
+		return NULL;
+	}
+
+	return &s_InstructionInfo[uInfoIdx];
+}
@@ -0,0 +1,125 @@
+#ifndef MIPSDECODE_H
+#define MIPSDECODE_H
+
+/* Table driven MIPS32 instruction decoder, shared by mipsdec and the */
+/* MIPS32 RTL generator of udcompiler. Only knows about single        */
+/* instruction words, no state is kept between calls.                 */
+
+typedef enum {
+	IF_UNKNOWN,
+	IF_NOARG,
+	IF_RSRTRD,
+	IF_RSRT,
+	IF_RSRTSI,
+	IF_RSSI,
+	IF_RSRTUI,
+	IF_RTUI,
+	IF_RTRDSA,
+	IF_RSRD,
+	IF_RD,
+	IF_RS,
+	IF_RTRDSEL,
+} tInstructionFormat;
+
+typedef enum {
+	IDS_NONE,
+	IDS_CONDITIONAL,
+	IDS_UNCONDITIONAL,
+} tInstructionDelaySlot;
+
+typedef enum {
+	IT_ADDIU,		// No delay slot
+	IT_ADDU,		// No delay slot
+	IT_AND,			// No delay slot
+	IT_ANDI,		// No delay slot
+	IT_BEQ,			// Delay slot
+	IT_BEQL,		// Conditional delay slot
+	IT_BGEZ,		// Delay slot
+	IT_BGTZ,		// Delay slot
+	IT_BLEZ,		// Delay slot
+	IT_BLTZ,		// Delay slot
+	IT_BNE,			// Delay slot
+	IT_BNEL,		// Conditional delay slot
+	IT_MFHI,		// No delay slot
+	IT_J,				// Delay slot
+	IT_JALR,		// Delay slot
+	IT_JALR_HB,	// Delay slot
+	IT_JR,			// Delay slot
+	IT_JR_HB,		// Delay slot
+	IT_LB,			// No delay slot
+	IT_LBU,			// No delay slot
+	IT_LH,			// No delay slot
+	IT_LHU,			// No delay slot
+	IT_LUI,			// No delay slot
+	IT_LW,			// No delay slot
+	IT_LWL,			// No delay slot
+	IT_LWR,			// No delay slot
+	IT_MFC0,		// No delay slot
+	IT_MTC0,		// No delay slot
+	IT_MULT,		// No delay slot
+	IT_MULTU,		// No delay slot
+	IT_NOP,			// No delay slot
+	IT_NOR,			// No delay slot
+	IT_OR,			// No delay slot
+	IT_ORI,			// No delay slot
+	IT_SB,			// No delay slot
+	IT_SH,			// No delay slot
+	IT_SLL,			// No delay slot
+	IT_SLTI,		// No delay slot
+	IT_SLTIU,		// No delay slot
+	IT_SLTU,		// No delay slot
+	IT_SRA,			// No delay slot
+	IT_SRAV,		// No delay slot
+	IT_SRL,			// No delay slot
+	IT_SSNOP,		// No delay slot
+	IT_SUBU,		// No delay slot
+	IT_SW,			// No delay slot
+	IT_SWL,			// No delay slot
+	IT_SWR,			// No delay slot
+	IT_XORI,		// No delay slot
+
+	IT_NUM_TYPES
+} tInstructionType;
+
+typedef enum
+{
+	RF_NONE,
+	RF_RD,
+	RF_RS,
+	RF_RT,
+} tResultField;
+
+typedef struct
+{
+	unsigned uOpcode;
+	unsigned uSpecialOpcode;
+	unsigned uRegimmOpcode;
+	unsigned uCop0Opcode;
+	const char *pName;
+	tInstructionType eType;
+	tInstructionFormat eFormat;
+	tResultField eResultField;
+	tInstructionDelaySlot eDelaySlot;
+} tInstructionInfo;
+
+/* Fields of one instruction word. Registers are the raw register   */
+/* numbers. Fields not used by the format are extracted nonetheless. */
+typedef struct
+{
+	tInstructionType eType;
+	tInstructionFormat eFormat;
+	unsigned char uRS;
+	unsigned char uRT;
+	unsigned char uRD;
+	unsigned char uSA;
+	unsigned char uSEL;
+	unsigned short uImmediate;
+	unsigned uJumpAddress;
+} tDecodedInstruction;
+
+bool decodeInstruction(unsigned uInstructionData, unsigned uInstructionAddress, tDecodedInstruction &aDecoded);
+
+/* NULL for types without a table entry */
+const tInstructionInfo *getInstructionInfo(tInstructionType eType);
+
+#endif
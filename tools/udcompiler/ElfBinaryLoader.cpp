@@ -1,7 +1,11 @@
 #include "ElfBinaryLoader.h"
 #include <stdio.h>
+#include <algorithm>
+#include <string.h>
 
 ElfBinaryLoader::ElfBinaryLoader() :
+	m_pBinaryData(NULL),
+	m_uBinarySize(0),
 	m_enArchType(ARCH_TYPE_UNKNOWN),
 	m_bHaveStringTable(false)
 {
@@ -9,78 +13,372 @@ ElfBinaryLoader::ElfBinaryLoader() :
 
 bool ElfBinaryLoader::loadFile(const std::string &strFileName)
 {
-	FILE *pFileHandle = ::fopen(strFileName.c_str(), "rb");
+	m_collSectionHeaders.clear();
+	m_collAddressIndex.clear();
+	m_collNameIndex.clear();
+	m_collIndexedSymbols.clear();
+	m_collSymbolIndex.clear();
+	m_collSymbolsRead.clear();
+
+	// Sections are handed out as views into the mapping, nothing is copied
+	if(!m_aBinaryFile.open(strFileName))
+	{
+		m_pBinaryData = NULL;
+		m_uBinarySize = 0;
+		return false;
+	}
+
+	m_pBinaryData = m_aBinaryFile.getData();
+	m_uBinarySize = m_aBinaryFile.getSize();
 
-	if(!pFileHandle)
+	if(!parseElfHeader())
 	{
 		return false;
 	}
 
-	::fseek(pFileHandle, 0, SEEK_END);
-	long uFileSize = ::ftell(pFileHandle);
-	::fseek(pFileHandle, 0, SEEK_SET);
+	buildAddressIndex();
+
+	return true;
+}
+
+static unsigned hashName(const char *pName)
+{
+	unsigned uHash = 2166136261U;
+
+	for(; *pName; pName++)
+	{
+		uHash = (uHash ^ (unsigned char)*pName) * 16777619U;
+	}
+
+	return uHash;
+}
+
+bool ElfBinaryLoader::getCodeSectionByName(const std::string &strName, SectionView &aView)
+{
+	unsigned uSectionIdx;
 
-	if(!uFileSize)
+	if(!findSectionByName(strName, uSectionIdx))
 	{
-		::fclose(pFileHandle);
 		return false;
 	}
 
-	m_collBinaryData.resize(uFileSize);
-	bool bResult = ::fread(&m_collBinaryData[0], 1, uFileSize, pFileHandle) == uFileSize;
+	return getSectionView(uSectionIdx, aView);
+}
+
+bool ElfBinaryLoader::findSectionByName(const std::string &strName, unsigned &uSectionIdx)
+{
+	if(m_collNameIndex.empty())
+	{
+		buildNameIndex();
+	}
 
-	::fclose(pFileHandle);
+	unsigned uMask = m_collNameIndex.size() - 1;
 
-	if(!bResult)
+	for(unsigned uSlot = hashName(strName.c_str()) & uMask; m_collNameIndex[uSlot]; uSlot = (uSlot + 1) & uMask)
+	{
+		unsigned uIdx = m_collNameIndex[uSlot] - 1;
+
+		if(!strcmp(getStringTableEntry(m_collSectionHeaders[uIdx].getHeader().sh_name), strName.c_str()))
+		{
+			uSectionIdx = uIdx;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool isSymbolBefore(const LoaderBase::tSymbol &aSymbol1, const LoaderBase::tSymbol &aSymbol2)
+{
+	return aSymbol1.uOffset < aSymbol2.uOffset;
+}
+
+bool ElfBinaryLoader::getFunctionSymbols(const std::string &strSectionName, tCollSymbols &collSymbols)
+{
+	unsigned uSectionIdx;
+
+	collSymbols.clear();
+
+	if(!findSectionByName(strSectionName, uSectionIdx))
 	{
 		return false;
 	}
 
-	if(!parseElfHeader())
+	for(unsigned uIdx = 0; uIdx < m_collSectionHeaders.size(); uIdx++)
+	{
+		if((m_collSectionHeaders[uIdx].getHeader().sh_type == SHT_SYMTAB) && (!addFunctionSymbols(uIdx, uSectionIdx, collSymbols)))
+		{
+			return false;
+		}
+	}
+
+	std::stable_sort(collSymbols.begin(), collSymbols.end(), isSymbolBefore);
+
+	if(m_collSymbolsRead.size() <= uSectionIdx)
+	{
+		m_collSymbolsRead.resize(m_collSectionHeaders.size(), false);
+	}
+
+	m_collSymbolsRead[uSectionIdx] = true;
+
+	return true;
+}
+
+// The symbol tables of a section are read on the first lookup, later
+// lookups only probe the hash
+bool ElfBinaryLoader::getFunctionSymbolByName(const std::string &strSectionName, const std::string &strName, tSymbol &aSymbol)
+{
+	unsigned uSectionIdx;
+
+	if(!findSectionByName(strSectionName, uSectionIdx))
+	{
+		return false;
+	}
+
+	if((m_collSymbolsRead.size() <= uSectionIdx) || (!m_collSymbolsRead[uSectionIdx]))
+	{
+		tCollSymbols collSymbols;
+
+		if(!getFunctionSymbols(strSectionName, collSymbols))
+		{
+			return false;
+		}
+	}
+
+	if(m_collSymbolIndex.empty())
+	{
+		return false;
+	}
+
+	unsigned uMask = m_collSymbolIndex.size() - 1;
+
+	for(unsigned uSlot = hashName(strName.c_str()) & uMask; m_collSymbolIndex[uSlot]; uSlot = (uSlot + 1) & uMask)
+	{
+		const tIndexedSymbol &aEntry = m_collIndexedSymbols[m_collSymbolIndex[uSlot] - 1];
+
+		if((aEntry.uSectionIdx == uSectionIdx) && (!strcmp(aEntry.aSymbol.pName, strName.c_str())))
+		{
+			aSymbol = aEntry.aSymbol;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Relocatable objects store section offsets in st_value, everything
+// else absolute addresses. Subtracting the section address covers both.
+bool ElfBinaryLoader::addFunctionSymbols(unsigned uSymbolTableIdx, unsigned uSectionIdx, tCollSymbols &collSymbols)
+{
+	const Elf32_Shdr &aHeader = m_collSectionHeaders[uSymbolTableIdx].getHeader();
+	const Elf32_Shdr &aSection = m_collSectionHeaders[uSectionIdx].getHeader();
+
+	if((aHeader.sh_entsize < sizeof(Elf32_Sym)) || (aHeader.sh_link >= m_collSectionHeaders.size()))
 	{
 		return false;
 	}
 
+	if((aHeader.sh_offset > m_uBinarySize) || (aHeader.sh_size > (m_uBinarySize - aHeader.sh_offset)))
+	{
+		return false;
+	}
+
+	const ElfSectionHeader &aStringTable = m_collSectionHeaders[aHeader.sh_link];
+	unsigned uNumSymbols = aHeader.sh_size / aHeader.sh_entsize;
+
+	for(unsigned uIdx = 0; uIdx < uNumSymbols; uIdx++)
+	{
+		const Elf32_Sym *pSymbol = reinterpret_cast<const Elf32_Sym *>(m_pBinaryData + aHeader.sh_offset + (uIdx * aHeader.sh_entsize));
+
+		if((ELF32_ST_TYPE(pSymbol->st_info) != STT_FUNC) || (pSymbol->st_shndx != uSectionIdx))
+		{
+			continue;
+		}
+
+		tSymbol aSymbol;
+		const char *pName = aStringTable.getString(pSymbol->st_name);
+
+		aSymbol.pName = pName ? pName : "";
+		aSymbol.uOffset = pSymbol->st_value - aSection.sh_addr;
+		aSymbol.uSize = pSymbol->st_size;
+
+		if(aSymbol.uOffset < aSection.sh_size)
+		{
+			collSymbols.push_back(aSymbol);
+			addSymbolName(aSymbol, uSectionIdx);
+		}
+	}
+
 	return true;
 }
 
-bool ElfBinaryLoader::getCodeSectionByName(const std::string &strName, tCollData &collData)
+// Same probing as the section name hash. A name defined twice in a
+// section keeps its first symbol, reading a section again adds nothing.
+void ElfBinaryLoader::addSymbolName(const tSymbol &aSymbol, unsigned uSectionIdx)
+{
+	if((2 * (m_collIndexedSymbols.size() + 1)) > m_collSymbolIndex.size())
+	{
+		growSymbolIndex();
+	}
+
+	unsigned uMask = m_collSymbolIndex.size() - 1;
+	unsigned uSlot = hashName(aSymbol.pName) & uMask;
+
+	for(; m_collSymbolIndex[uSlot]; uSlot = (uSlot + 1) & uMask)
+	{
+		const tIndexedSymbol &aEntry = m_collIndexedSymbols[m_collSymbolIndex[uSlot] - 1];
+
+		if((aEntry.uSectionIdx == uSectionIdx) && (!strcmp(aEntry.aSymbol.pName, aSymbol.pName)))
+		{
+			return;
+		}
+	}
+
+	tIndexedSymbol aEntry;
+
+	aEntry.aSymbol = aSymbol;
+	aEntry.uSectionIdx = uSectionIdx;
+	m_collIndexedSymbols.push_back(aEntry);
+	m_collSymbolIndex[uSlot] = m_collIndexedSymbols.size();
+}
+
+void ElfBinaryLoader::growSymbolIndex()
+{
+	unsigned uNumSlots = m_collSymbolIndex.empty() ? 64 : (2 * m_collSymbolIndex.size());
+
+	m_collSymbolIndex.assign(uNumSlots, 0);
+
+	for(unsigned uIdx = 0; uIdx < m_collIndexedSymbols.size(); uIdx++)
+	{
+		unsigned uSlot = hashName(m_collIndexedSymbols[uIdx].aSymbol.pName) & (uNumSlots - 1);
+
+		while(m_collSymbolIndex[uSlot])
+		{
+			uSlot = (uSlot + 1) & (uNumSlots - 1);
+		}
+
+		m_collSymbolIndex[uSlot] = uIdx + 1;
+	}
+}
+
+// Linear probing in a table of at least twice the section count, so
+// there is always a free slot to stop at. Sections sharing a name keep
+// the first one, as the linear search did.
+void ElfBinaryLoader::buildNameIndex()
 {
+	unsigned uNumSlots = 16;
+
+	while(uNumSlots < (2 * m_collSectionHeaders.size()))
+	{
+		uNumSlots *= 2;
+	}
+
+	m_collNameIndex.assign(uNumSlots, 0);
+
 	for(unsigned uIdx = 0; uIdx < m_collSectionHeaders.size(); uIdx++)
 	{
-		const Elf32_Shdr &aHeader = m_collSectionHeaders[uIdx].getHeader();
+		const char *pName = getStringTableEntry(m_collSectionHeaders[uIdx].getHeader().sh_name);
+		unsigned uSlot = hashName(pName) & (uNumSlots - 1);
 
-		if(getStringTableEntry(aHeader.sh_name) == strName)
+		while((m_collNameIndex[uSlot]) && (strcmp(getStringTableEntry(m_collSectionHeaders[m_collNameIndex[uSlot] - 1].getHeader().sh_name), pName)))
 		{
-			collData.resize(aHeader.sh_size);
+			uSlot = (uSlot + 1) & (uNumSlots - 1);
+		}
 
-			for(unsigned uIdx = 0; uIdx < aHeader.sh_size; uIdx++)
-			{
-				collData[uIdx] = m_collBinaryData[aHeader.sh_offset + uIdx];
-			}
+		if(!m_collNameIndex[uSlot])
+		{
+			m_collNameIndex[uSlot] = uIdx + 1;
+		}
+	}
+}
 
-			return true;
+static bool isAddressEntryBefore(unsigned uAddress, const std::pair<unsigned, unsigned> &aEntry)
+{
+	return uAddress < aEntry.first;
+}
+
+// Sections at the same address are sorted backwards, so the lookup
+// walking down from the top finds the first section of the file first
+static bool isAddressEntryLess(const std::pair<unsigned, unsigned> &aEntry1, const std::pair<unsigned, unsigned> &aEntry2)
+{
+	if(aEntry1.first != aEntry2.first)
+	{
+		return aEntry1.first < aEntry2.first;
+	}
+
+	return aEntry1.second > aEntry2.second;
+}
+
+bool ElfBinaryLoader::getCodeSectionByAddress(unsigned uAddress, SectionView &aView)
+{
+	tAddressIndex::const_iterator it = std::upper_bound(m_collAddressIndex.begin(), m_collAddressIndex.end(), uAddress, isAddressEntryBefore);
+
+	// Walk back over all sections starting at or below the address, the
+	// first one covering it wins
+	while(it != m_collAddressIndex.begin())
+	{
+		it--;
+
+		const Elf32_Shdr &aHeader = m_collSectionHeaders[it->second].getHeader();
+
+		if((uAddress - aHeader.sh_addr) < aHeader.sh_size)
+		{
+			return getSectionView(it->second, aView);
 		}
 	}
 
 	return false;
 }
 
-bool ElfBinaryLoader::getCodeSectionByAddress(unsigned uAddress, tCollData &collData)
+// Sections that occupy memory at run time and have their contents in
+// the file, relocatable objects place all of them at address zero
+void ElfBinaryLoader::buildAddressIndex()
+{
+	m_collAddressIndex.clear();
+
+	for(unsigned uIdx = 0; uIdx < m_collSectionHeaders.size(); uIdx++)
+	{
+		const Elf32_Shdr &aHeader = m_collSectionHeaders[uIdx].getHeader();
+
+		if((aHeader.sh_flags & SHF_ALLOC) && (aHeader.sh_type != SHT_NOBITS) && (aHeader.sh_size))
+		{
+			m_collAddressIndex.push_back(tAddressEntry(aHeader.sh_addr, uIdx));
+		}
+	}
+
+	std::sort(m_collAddressIndex.begin(), m_collAddressIndex.end(), isAddressEntryLess);
+}
+
+bool ElfBinaryLoader::getSectionView(unsigned uSectionIdx, SectionView &aView)
 {
+	const Elf32_Shdr &aHeader = m_collSectionHeaders[uSectionIdx].getHeader();
+
+	if(aHeader.sh_type == SHT_NOBITS)
+	{
+		aView = SectionView(NULL, 0, aHeader.sh_addr);
+		return true;
+	}
+
+	if((aHeader.sh_offset > m_uBinarySize) || (aHeader.sh_size > (m_uBinarySize - aHeader.sh_offset)))
+	{
+		return false;
+	}
+
+	aView = SectionView(m_pBinaryData + aHeader.sh_offset, aHeader.sh_size, aHeader.sh_addr);
+
 	return true;
 }
 
 bool ElfBinaryLoader::parseElfHeader()
 {
-	Elf32_Ehdr *pElfHeader;
+	const Elf32_Ehdr *pElfHeader;
 
-	if(m_collBinaryData.size() < sizeof(*pElfHeader))
+	if(m_uBinarySize < sizeof(*pElfHeader))
 	{
 		return false;
 	}
 
-	pElfHeader = reinterpret_cast<Elf32_Ehdr *>(&m_collBinaryData[0]);
+	pElfHeader = reinterpret_cast<const Elf32_Ehdr *>(m_pBinaryData);
 
 	if((pElfHeader->e_ident[EI_MAG0] != 0x7F) || (pElfHeader->e_ident[EI_MAG1] != 'E') ||
 		(pElfHeader->e_ident[EI_MAG2] != 'L') || (pElfHeader->e_ident[EI_MAG3] != 'F'))
@@ -105,7 +403,7 @@ bool ElfBinaryLoader::parseElfHeader()
 		return false;
 	}
 
-	if((pElfHeader->e_shstrndx != SHN_UNDEF) && (pElfHeader->e_shstrndx > m_collSectionHeaders.size()))
+	if((pElfHeader->e_shstrndx != SHN_UNDEF) && (pElfHeader->e_shstrndx >= m_collSectionHeaders.size()))
 	{
 		return false;
 	}
@@ -135,21 +433,21 @@ bool ElfBinaryLoader::parseSectionHeaders(unsigned uOffset, unsigned uNumSection
 		return false;
 	}
 
-	if(uNumBytesPerSection < sizeof(m_collSectionHeaders))
+	if(uNumBytesPerSection < sizeof(Elf32_Shdr))
 	{
 		return false;
 	}
 
-	if((uOffset + (uNumSections * uNumBytesPerSection)) > m_collBinaryData.size())
+	if((uOffset > m_uBinarySize) || (uNumSections > ((m_uBinarySize - uOffset) / uNumBytesPerSection)))
 	{
 		return false;
 	}
 
 	for(unsigned uIdx = 0; uIdx < uNumSections; uIdx++)
 	{
-		Elf32_Shdr *pSectionHeader = reinterpret_cast<Elf32_Shdr *>(&m_collBinaryData[uOffset + (uIdx * uNumBytesPerSection)]);
+		const Elf32_Shdr *pSectionHeader = reinterpret_cast<const Elf32_Shdr *>(m_pBinaryData + uOffset + (uIdx * uNumBytesPerSection));
 
-		if((pSectionHeader->sh_type == SHT_NOBITS) && ((pSectionHeader->sh_offset + pSectionHeader->sh_size) > m_collBinaryData.size()))
+		if((pSectionHeader->sh_type == SHT_NOBITS) && ((pSectionHeader->sh_offset > m_uBinarySize) || (pSectionHeader->sh_size > (m_uBinarySize - pSectionHeader->sh_offset))))
 		{
 			return false;
 		}
@@ -182,11 +480,7 @@ bool ElfBinaryLoader::postProcessSectionHeaders()
 	{
 		const Elf32_Shdr &aHeader = m_collSectionHeaders[uIdx].getHeader();
 
-		unsigned uVal1 = aHeader.sh_name;
-		size_t uVal2 = m_collSectionHeaders[m_uStringTableSectionIdx].getNumStrings();
-		std::string strDummy;
-
-		if((aHeader.sh_name) && ((!m_bHaveStringTable) || (!m_collSectionHeaders[m_uStringTableSectionIdx].getString(aHeader.sh_name, strDummy))))
+		if((aHeader.sh_name) && ((!m_bHaveStringTable) || (!m_collSectionHeaders[m_uStringTableSectionIdx].getString(aHeader.sh_name))))
 		{
 			return false;
 		}
@@ -195,10 +489,10 @@ bool ElfBinaryLoader::postProcessSectionHeaders()
 	return true;
 }
 
+// Only validates the table, the entries are looked up in place. The
+// terminating zero makes every offset inside the table a valid string.
 bool ElfBinaryLoader::readStringTable(ElfSectionHeader &aSectionHeader)
 {
-	aSectionHeader.clearStrings();
-
 	const Elf32_Shdr &aHeader = aSectionHeader.getHeader();
 
 	if(aHeader.sh_type != SHT_STRTAB)
@@ -206,36 +500,31 @@ bool ElfBinaryLoader::readStringTable(ElfSectionHeader &aSectionHeader)
 		return false;
 	}
 
-	if((m_collBinaryData[aHeader.sh_offset]) || (m_collBinaryData[aHeader.sh_offset + aHeader.sh_size - 1]))
+	if((!aHeader.sh_size) || (aHeader.sh_offset > m_uBinarySize) || (aHeader.sh_size > (m_uBinarySize - aHeader.sh_offset)))
 	{
 		return false;
 	}
 
-	size_t uOffset = 0;
+	const char *pStrings = reinterpret_cast<const char *>(m_pBinaryData + aHeader.sh_offset);
 
-	while(uOffset < aHeader.sh_size)
+	if((pStrings[0]) || (pStrings[aHeader.sh_size - 1]))
 	{
-		std::string strContent = reinterpret_cast<const char *>(&m_collBinaryData[aHeader.sh_offset + uOffset]);
-		aSectionHeader.addString(uOffset, strContent);
-		uOffset += strContent.length() + 1;
+		return false;
 	}
 
+	aSectionHeader.setStrings(pStrings);
+
 	return true;
 }
 
-std::string ElfBinaryLoader::getStringTableEntry(unsigned uOffset)
+const char *ElfBinaryLoader::getStringTableEntry(unsigned uOffset)
 {
 	if(!m_bHaveStringTable)
 	{
 		return "";
 	}
 
-	std::string strEntry;
-
-	if(!m_collSectionHeaders[m_uStringTableSectionIdx].getString(uOffset, strEntry))
-	{
-		return "";
-	}
+	const char *pEntry = m_collSectionHeaders[m_uStringTableSectionIdx].getString(uOffset);
 
-	return strEntry;
+	return pEntry ? pEntry : "";
 }
@@ -9,39 +9,41 @@
 #include "ElfSpec.h"
 #endif
 
+#ifndef MAPPEDFILE_H
+#include "MappedFile.h"
+#endif
+
 #include <vector>
-#include <map>
 
 class ElfSectionHeader
 {
 public:
-	typedef std::map<size_t, std::string> tStringTable;
-
-	ElfSectionHeader(const Elf32_Shdr &aRawSectionHeader)
+	ElfSectionHeader(const Elf32_Shdr &aRawSectionHeader) :
+		m_pStrings(NULL)
 	{
 		m_aSectionHeader = aRawSectionHeader;
 	}
 
-	const Elf32_Shdr &getHeader() { return m_aSectionHeader; }
-	void clearStrings() { return m_collStringTable.clear(); }
-	size_t getNumStrings() { return m_collStringTable.size(); }
-	void addString(size_t uOffset, const std::string &strContent) { m_collStringTable[uOffset] = strContent; }
-	bool getString(size_t uOffset, std::string &strContent)
-	{
-		tStringTable::iterator it = m_collStringTable.find(uOffset);
+	const Elf32_Shdr &getHeader() const { return m_aSectionHeader; }
 
-		if(it == m_collStringTable.end())
+	// String tables stay in the mapped file, entries are resolved on
+	// request. Any offset inside the table is valid, linkers point into
+	// the middle of entries to share common suffixes.
+	void setStrings(const char *pStrings) { m_pStrings = pStrings; }
+	bool hasStrings() const { return m_pStrings != NULL; }
+	const char *getString(size_t uOffset) const
+	{
+		if((!m_pStrings) || (uOffset >= m_aSectionHeader.sh_size))
 		{
-			return false;
+			return NULL;
 		}
 
-		strContent = it->second;
-		return true;
+		return m_pStrings + uOffset;
 	}
 
 private:
 	Elf32_Shdr m_aSectionHeader;
-	tStringTable m_collStringTable;
+	const char *m_pStrings;
 };
 
 class ElfBinaryLoader : public LoaderBase
@@ -51,20 +53,54 @@ public:
 
 	bool loadFile(const std::string &strFileName);
 	eArchType getArchType() { return m_enArchType; }
-	bool getCodeSectionByName(const std::string &strName, tCollData &collData);
-	bool getCodeSectionByAddress(unsigned uAddress, tCollData &collData);
-	bool getMainCodeSection(tCollData &collData) { return getCodeSectionByName(".text", collData); }
+	bool getCodeSectionByName(const std::string &strName, SectionView &aView);
+	bool getCodeSectionByAddress(unsigned uAddress, SectionView &aView);
+	bool getMainCodeSection(SectionView &aView) { return getCodeSectionByName(".text", aView); }
+	bool getFunctionSymbols(const std::string &strSectionName, tCollSymbols &collSymbols);
+	bool getFunctionSymbolByName(const std::string &strSectionName, const std::string &strName, tSymbol &aSymbol);
 
 private:
+	// Start address and index of an allocated section, sorted by address
+	typedef std::pair<unsigned, unsigned> tAddressEntry;
+	typedef std::vector<tAddressEntry> tAddressIndex;
+
+	// Function symbol and the section it was read for
+	typedef struct
+	{
+		tSymbol aSymbol;
+		unsigned uSectionIdx;
+	} tIndexedSymbol;
+
 	bool parseElfHeader();
 	bool parseSectionHeaders(unsigned uOffset, unsigned uNumSections, unsigned uNumBytesPerSection);
 	bool postProcessSectionHeaders();
+	void buildAddressIndex();
+	void buildNameIndex();
+	bool findSectionByName(const std::string &strName, unsigned &uSectionIdx);
+	bool addFunctionSymbols(unsigned uSymbolTableIdx, unsigned uSectionIdx, tCollSymbols &collSymbols);
+	void addSymbolName(const tSymbol &aSymbol, unsigned uSectionIdx);
+	void growSymbolIndex();
+	bool getSectionView(unsigned uSectionIdx, SectionView &aView);
 
 	bool readStringTable(ElfSectionHeader &aSectionHeader);
-	std::string getStringTableEntry(unsigned uOffset);
+	const char *getStringTableEntry(unsigned uOffset);
 
-	std::vector<unsigned char> m_collBinaryData;
+	MappedFile m_aBinaryFile;
+	const unsigned char *m_pBinaryData;
+	size_t m_uBinarySize;
 	std::vector<ElfSectionHeader> m_collSectionHeaders;
+	tAddressIndex m_collAddressIndex;
+
+	// Open addressed section name hash, slots hold the section index + 1.
+	// Only built once a section is looked up by name.
+	std::vector<unsigned> m_collNameIndex;
+
+	// Function symbols by name, filled while symbol tables are read.
+	// Slots hold the index into m_collIndexedSymbols + 1.
+	std::vector<tIndexedSymbol> m_collIndexedSymbols;
+	std::vector<unsigned> m_collSymbolIndex;
+	std::vector<bool> m_collSymbolsRead;
+
 	eArchType m_enArchType;
 	bool m_bHaveStringTable;
 	unsigned m_uStringTableSectionIdx;
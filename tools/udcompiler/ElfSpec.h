@@ -64,6 +64,11 @@ typedef struct {
 #define SHT_LOUSER 0x80000000 
 #define SHT_HIUSER 0xffffffff 
 
+#define SHF_WRITE 0x1 
+#define SHF_ALLOC 0x2 
+#define SHF_EXECINSTR 0x4 
+#define SHF_MASKPROC 0xf0000000 
+
 typedef struct {
        Elf32_Word      sh_name;
        Elf32_Word      sh_type;
@@ -77,4 +82,22 @@ typedef struct {
        Elf32_Word      sh_entsize;
 } Elf32_Shdr;
 
+typedef struct {
+       Elf32_Word      st_name;
+       Elf32_Addr      st_value;
+       Elf32_Word      st_size;
+       unsigned char   st_info;
+       unsigned char   st_other;
+       Elf32_Half      st_shndx;
+} Elf32_Sym;
+
+#define ELF32_ST_BIND(i) ((i) >> 4) 
+#define ELF32_ST_TYPE(i) ((i) & 0xf) 
+
+#define STT_NOTYPE 0 
+#define STT_OBJECT 1 
+#define STT_FUNC 2 
+#define STT_SECTION 3 
+#define STT_FILE 4 
+
 #endif
\ No newline at end of file
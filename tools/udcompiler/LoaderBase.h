@@ -16,11 +16,56 @@ public:
 
 	typedef std::vector<unsigned char> tCollData;
 
+	// Read-only window into the loaded file. Only valid as long as the
+	// loader that handed it out keeps the file loaded.
+	class SectionView
+	{
+	public:
+		SectionView() :
+			m_pData(NULL),
+			m_uSize(0),
+			m_uAddress(0)
+		{}
+
+		SectionView(const unsigned char *pData, size_t uSize, unsigned uAddress) :
+			m_pData(pData),
+			m_uSize(uSize),
+			m_uAddress(uAddress)
+		{}
+
+		const unsigned char *getData() const { return m_pData; }
+		size_t getSize() const { return m_uSize; }
+		unsigned getAddress() const { return m_uAddress; }
+		bool isEmpty() const { return m_uSize == 0; }
+		const unsigned char &operator[](size_t uIdx) const { return m_pData[uIdx]; }
+
+		void copyTo(tCollData &collData) const { collData.assign(m_pData, m_pData + m_uSize); }
+
+	private:
+		const unsigned char *m_pData;
+		size_t m_uSize;
+		unsigned m_uAddress;
+	};
+
+	// Function symbol, the name points into the loaded file as well
+	typedef struct
+	{
+		const char *pName;
+		unsigned uOffset;
+		unsigned uSize;
+	} tSymbol;
+
+	typedef std::vector<tSymbol> tCollSymbols;
+
 	virtual bool loadFile(const std::string &strFileName) = 0;
 	virtual eArchType getArchType() = 0;
-	virtual bool getCodeSectionByName(const std::string &strName, tCollData &collData) = 0;
-	virtual bool getCodeSectionByAddress(unsigned uAddress, tCollData &collData) = 0;
-	virtual bool getMainCodeSection(tCollData &collData) = 0;
+	virtual bool getCodeSectionByName(const std::string &strName, SectionView &aView) = 0;
+	virtual bool getCodeSectionByAddress(unsigned uAddress, SectionView &aView) = 0;
+	virtual bool getMainCodeSection(SectionView &aView) = 0;
+
+	// Functions defined in a section, sorted by their offset into it
+	virtual bool getFunctionSymbols(const std::string &strSectionName, tCollSymbols &collSymbols) = 0;
+	virtual bool getFunctionSymbolByName(const std::string &strSectionName, const std::string &strName, tSymbol &aSymbol) = 0;
 };
 
 #endif
\ No newline at end of file
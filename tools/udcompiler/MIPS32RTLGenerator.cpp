@@ -0,0 +1,339 @@
+#include "MIPS32RTLGenerator.h"
+#include <stdio.h>
+
+static const char *s_pRegisterNames[32] =
+{
+	"ZERO", "AT", "V0", "V1", "A0", "A1", "A2", "A3",
+	"T0", "T1", "T2", "T3", "T4", "T5", "T6", "T7",
+	"S0", "S1", "S2", "S3", "S4", "S5", "S6", "S7",
+	"T8", "T9", "K0", "K1", "GP", "SP", "FP", "RA"
+};
+
+// The ELF loader only handles little endian files, which is what the
+// BCM47xx firmware is built as
+static unsigned readWord(const unsigned char *pData)
+{
+	return pData[0] | (pData[1] << 8) | (pData[2] << 16) | (pData[3] << 24);
+}
+
+static void setRegisterArg(RTLGeneratorBase::Argument &aArg, unsigned uRegister)
+{
+	aArg.setType(RTLGeneratorBase::Argument::TYPE_REGISTER);
+	aArg.setRegister(static_cast<RTLGeneratorBase::Argument::eRegister>(MIPS32RTLGenerator::REGISTER_MIPS32_ZERO + uRegister));
+	aArg.setDataWidth(RTLGeneratorBase::Argument::DATA_WIDTH_32);
+}
+
+static void setValueArg(RTLGeneratorBase::Argument &aArg, unsigned uValue)
+{
+	aArg.setType(RTLGeneratorBase::Argument::TYPE_VALUE);
+	aArg.setValue(uValue);
+	aArg.setDataWidth(RTLGeneratorBase::Argument::DATA_WIDTH_32);
+}
+
+// Base register and offset of a load or store
+static void setMemoryArg(RTLGeneratorBase::Argument &aArg, const tDecodedInstruction &aDecoded, RTLGeneratorBase::Argument::eDataWidth enDataWidth)
+{
+	aArg.setType(RTLGeneratorBase::Argument::TYPE_MEMORY_LOC);
+	aArg.setRegister(static_cast<RTLGeneratorBase::Argument::eRegister>(MIPS32RTLGenerator::REGISTER_MIPS32_ZERO + aDecoded.uRS));
+	aArg.setValue(static_cast<signed short>(aDecoded.uImmediate));
+	aArg.setDataWidth(enDataWidth);
+}
+
+// Linear sweep like the x86 generator. Delay slots stay where they are,
+// the RTL follows the instruction order.
+bool MIPS32RTLGenerator::generateRTL(const LoaderBase::SectionView &aCode, RTLCode &aRTLCode)
+{
+	for(unsigned uIdx = 0; (uIdx + 4) <= aCode.getSize(); uIdx += 4)
+	{
+		tDecodedInstruction aDecoded;
+		unsigned uAddress = aCode.getAddress() + uIdx;
+
+		if(!decodeInstruction(readWord(aCode.getData() + uIdx), uAddress, aDecoded))
+		{
+			RTLOp aRTLOp;
+
+			aRTLOp.setAddress(uAddress);
+			aRTLCode.addOp(aRTLOp);
+			continue;
+		}
+
+		parseInstruction(aDecoded, uAddress, aRTLCode);
+	}
+
+	return true;
+}
+
+bool MIPS32RTLGenerator::dumpDisassembly(const LoaderBase::SectionView &aCode) const
+{
+	for(unsigned uIdx = 0; (uIdx + 4) <= aCode.getSize(); uIdx += 4)
+	{
+		tDecodedInstruction aDecoded;
+		unsigned uAddress = aCode.getAddress() + uIdx;
+		unsigned uData = readWord(aCode.getData() + uIdx);
+
+		if(!decodeInstruction(uData, uAddress, aDecoded))
+		{
+			printf("0x%08X: %08X (bad)\n", uAddress, uData);
+			continue;
+		}
+
+		const char *pRS = s_pRegisterNames[aDecoded.uRS];
+		const char *pRT = s_pRegisterNames[aDecoded.uRT];
+		const char *pRD = s_pRegisterNames[aDecoded.uRD];
+		signed short iSI = static_cast<signed short>(aDecoded.uImmediate);
+
+		// The hazard barrier variants have no table entry of their own
+		switch(aDecoded.eType)
+		{
+			case IT_JALR_HB:
+				printf("0x%08X: %08X JALR.HB", uAddress, uData);
+				break;
+			case IT_JR_HB:
+				printf("0x%08X: %08X JR.HB", uAddress, uData);
+				break;
+			default:
+				printf("0x%08X: %08X %s", uAddress, uData, getInstructionInfo(aDecoded.eType)->pName);
+				break;
+		}
+
+		// Operands in encoding order, like the listing of mipsdec
+		switch(aDecoded.eFormat)
+		{
+			case IF_RSRTRD:
+				printf("\t%s,%s,%s\n", pRS, pRT, pRD);
+				break;
+			case IF_RSRT:
+				printf("\t%s,%s\n", pRS, pRT);
+				break;
+			case IF_RSRTSI:
+				printf("\t%s,%s,%d\n", pRS, pRT, iSI);
+				break;
+			case IF_RSSI:
+				printf("\t%s,%d\n", pRS, iSI);
+				break;
+			case IF_RSRTUI:
+				printf("\t%s,%s,0x%X\n", pRS, pRT, aDecoded.uImmediate);
+				break;
+			case IF_RTUI:
+				printf("\t%s,0x%X\n", pRT, aDecoded.uImmediate);
+				break;
+			case IF_RTRDSA:
+				printf("\t%s,%s,%u\n", pRT, pRD, aDecoded.uSA);
+				break;
+			case IF_RSRD:
+				printf("\t%s,%s\n", pRS, pRD);
+				break;
+			case IF_RD:
+				printf("\t%s\n", pRD);
+				break;
+			case IF_RS:
+				printf("\t%s\n", pRS);
+				break;
+			case IF_RTRDSEL:
+				printf("\t%s,%u,%u\n", pRT, aDecoded.uRD, aDecoded.uSEL);
+				break;
+			default:
+				if(aDecoded.eType == IT_J)
+				{
+					printf("\t0x%08X\n", aDecoded.uJumpAddress);
+				}
+				else
+				{
+					printf("\n");
+				}
+				break;
+		}
+	}
+
+	return true;
+}
+
+// Branches compare and jump in one instruction, they become an
+// OP_COMPARE followed by an OP_JUMP at the same address
+void MIPS32RTLGenerator::addBranch(const tDecodedInstruction &aDecoded, unsigned uAddress, unsigned uNumCompareArgs, RTLCode &aRTLCode) const
+{
+	RTLOp aCompare;
+	RTLOp aJump;
+
+	// The shared decoder leaves the target of BGEZ empty
+	unsigned uTarget = uAddress + 4 + (static_cast<signed short>(aDecoded.uImmediate) << 2);
+
+	if((uNumCompareArgs != 2) || (aDecoded.uRS != 0) || (aDecoded.uRT != 0))
+	{
+		aCompare.setType(RTLOp::OP_COMPARE);
+		aCompare.setAddress(uAddress);
+		setRegisterArg(aCompare.getArg1(), aDecoded.uRS);
+
+		if(uNumCompareArgs == 2)
+		{
+			setRegisterArg(aCompare.getArg2(), aDecoded.uRT);
+		}
+
+		aRTLCode.addOp(aCompare);
+	}
+
+	aJump.setType(RTLOp::OP_JUMP);
+	aJump.setAddress(uAddress);
+	setValueArg(aJump.getArg1(), uTarget);
+	aRTLCode.addOp(aJump);
+}
+
+void MIPS32RTLGenerator::parseInstruction(const tDecodedInstruction &aDecoded, unsigned uAddress, RTLCode &aRTLCode) const
+{
+	RTLOp aRTLOp;
+	unsigned uSignedImmediate = static_cast<signed short>(aDecoded.uImmediate);
+
+	aRTLOp.setAddress(uAddress);
+
+	switch(aDecoded.eType)
+	{
+		case IT_ADDU:
+		case IT_OR:
+			if(aDecoded.uRT == 0)
+			{
+				aRTLOp.setType(RTLOp::OP_ASSIGN);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRD);
+				setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+			}
+			else if(aDecoded.eType == IT_ADDU)
+			{
+				aRTLOp.setType(RTLOp::OP_ADD);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRD);
+				setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+				setRegisterArg(aRTLOp.getArg3(), aDecoded.uRT);
+			}
+			break;
+		case IT_ADDIU:
+			if(aDecoded.uRS == 0)
+			{
+				aRTLOp.setType(RTLOp::OP_ASSIGN);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+				setValueArg(aRTLOp.getArg2(), uSignedImmediate);
+			}
+			else
+			{
+				aRTLOp.setType(RTLOp::OP_ADD);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+				setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+				setValueArg(aRTLOp.getArg3(), uSignedImmediate);
+			}
+			break;
+		case IT_ORI:
+			if(aDecoded.uRS == 0)
+			{
+				aRTLOp.setType(RTLOp::OP_ASSIGN);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+				setValueArg(aRTLOp.getArg2(), aDecoded.uImmediate);
+			}
+			break;
+		case IT_SUBU:
+			aRTLOp.setType(RTLOp::OP_SUBTRACT);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRD);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+			setRegisterArg(aRTLOp.getArg3(), aDecoded.uRT);
+			break;
+		case IT_LUI:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+			setValueArg(aRTLOp.getArg2(), aDecoded.uImmediate << 16);
+			break;
+		case IT_LB:
+		case IT_LBU:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+			setMemoryArg(aRTLOp.getArg2(), aDecoded, Argument::DATA_WIDTH_8_LW_LB);
+			break;
+		case IT_LH:
+		case IT_LHU:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+			setMemoryArg(aRTLOp.getArg2(), aDecoded, Argument::DATA_WIDTH_16_LW);
+			break;
+		case IT_LW:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+			setMemoryArg(aRTLOp.getArg2(), aDecoded, Argument::DATA_WIDTH_32);
+			break;
+		case IT_SB:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setMemoryArg(aRTLOp.getArg1(), aDecoded, Argument::DATA_WIDTH_8_LW_LB);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRT);
+			break;
+		case IT_SH:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setMemoryArg(aRTLOp.getArg1(), aDecoded, Argument::DATA_WIDTH_16_LW);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRT);
+			break;
+		case IT_SW:
+			aRTLOp.setType(RTLOp::OP_ASSIGN);
+			setMemoryArg(aRTLOp.getArg1(), aDecoded, Argument::DATA_WIDTH_32);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRT);
+			break;
+		case IT_SLTI:
+		case IT_SLTIU:
+			aRTLOp.setType(RTLOp::OP_COMPARE);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRT);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+			setValueArg(aRTLOp.getArg3(), uSignedImmediate);
+			break;
+		case IT_SLTU:
+			aRTLOp.setType(RTLOp::OP_COMPARE);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRD);
+			setRegisterArg(aRTLOp.getArg2(), aDecoded.uRS);
+			setRegisterArg(aRTLOp.getArg3(), aDecoded.uRT);
+			break;
+		case IT_BEQ:
+		case IT_BEQL:
+		case IT_BNE:
+		case IT_BNEL:
+			addBranch(aDecoded, uAddress, 2, aRTLCode);
+			return;
+		case IT_BGEZ:
+		case IT_BGTZ:
+		case IT_BLEZ:
+		case IT_BLTZ:
+			addBranch(aDecoded, uAddress, 1, aRTLCode);
+			return;
+		case IT_J:
+			aRTLOp.setType(RTLOp::OP_JUMP);
+			setValueArg(aRTLOp.getArg1(), aDecoded.uJumpAddress);
+			break;
+		case IT_JR:
+		case IT_JR_HB:
+			if(aDecoded.uRS == (REGISTER_MIPS32_RA - REGISTER_MIPS32_ZERO))
+			{
+				aRTLOp.setType(RTLOp::OP_RETURN);
+			}
+			else
+			{
+				aRTLOp.setType(RTLOp::OP_JUMP);
+				setRegisterArg(aRTLOp.getArg1(), aDecoded.uRS);
+			}
+			break;
+		case IT_JALR:
+		case IT_JALR_HB:
+			aRTLOp.setType(RTLOp::OP_CALL);
+			setRegisterArg(aRTLOp.getArg1(), aDecoded.uRS);
+			break;
+		case IT_NOP:
+		case IT_SSNOP:
+			aRTLOp.setType(RTLOp::OP_NOP);
+			break;
+		default:
+			break;
+	}
+
+	aRTLCode.addOp(aRTLOp);
+}
+
+std::string MIPS32RTLGenerator::getRegisterName(Argument::eRegister enRegister, Argument::eDataWidth enDataWidth) const
+{
+	eRegisterMIPS32 enRegisterMIPS32 = (eRegisterMIPS32)enRegister;
+
+	if((enRegisterMIPS32 < REGISTER_MIPS32_ZERO) || (enRegisterMIPS32 > REGISTER_MIPS32_RA))
+	{
+		return "UNKNOWN";
+	}
+
+	return std::string(s_pRegisterNames[enRegisterMIPS32 - REGISTER_MIPS32_ZERO]) + "." + getDataWidthSuffix(enDataWidth);
+}
@@ -0,0 +1,31 @@
+#ifndef MIPS32RTLGENERATOR_H
+#define MIPS32RTLGENERATOR_H
+
+#ifndef RTLGENERATORBASE_H
+#include "RTLGeneratorBase.h"
+#endif
+
+#include "../mipsdecode/mipsdecode.h"
+
+class MIPS32RTLGenerator : public RTLGeneratorBase
+{
+public:
+	enum eRegisterMIPS32
+	{
+		REGISTER_MIPS32_UNKNOWN = Argument::REGISTER_UNKNOWN,
+
+		// Register n maps to REGISTER_R001 + n
+		REGISTER_MIPS32_ZERO = Argument::REGISTER_R001,
+		REGISTER_MIPS32_RA = Argument::REGISTER_R032
+	};
+
+	bool generateRTL(const LoaderBase::SectionView &aCode, RTLCode &aRTLCode);
+	bool dumpDisassembly(const LoaderBase::SectionView &aCode) const;
+
+private:
+	void parseInstruction(const tDecodedInstruction &aDecoded, unsigned uAddress, RTLCode &aRTLCode) const;
+	void addBranch(const tDecodedInstruction &aDecoded, unsigned uAddress, unsigned uNumCompareArgs, RTLCode &aRTLCode) const;
+	std::string getRegisterName(Argument::eRegister enRegister, Argument::eDataWidth enDataWidth) const;
+};
+
+#endif
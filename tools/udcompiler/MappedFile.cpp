@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	m_pData(NULL),
+	m_uSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &strFileName)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE hFile = ::CreateFileA(strFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if(hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	DWORD uFileSize = ::GetFileSize(hFile, NULL);
+
+	// Empty files can't be mapped
+	if((uFileSize == INVALID_FILE_SIZE) || (!uFileSize))
+	{
+		::CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = ::CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	::CloseHandle(hFile);
+
+	if(!hMapping)
+	{
+		return false;
+	}
+
+	void *pView = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(hMapping);
+
+	if(!pView)
+	{
+		return false;
+	}
+
+	m_pData = reinterpret_cast<const unsigned char *>(pView);
+	m_uSize = uFileSize;
+#else
+	int iFile = ::open(strFileName.c_str(), O_RDONLY);
+
+	if(iFile < 0)
+	{
+		return false;
+	}
+
+	struct stat aStat;
+
+	// Empty files can't be mapped
+	if((::fstat(iFile, &aStat) != 0) || (aStat.st_size <= 0))
+	{
+		::close(iFile);
+		return false;
+	}
+
+	void *pView = ::mmap(NULL, aStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+	::close(iFile);
+
+	if(pView == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_pData = reinterpret_cast<const unsigned char *>(pView);
+	m_uSize = aStat.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(!m_pData)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	::UnmapViewOfFile(m_pData);
+#else
+	::munmap(const_cast<unsigned char *>(m_pData), m_uSize);
+#endif
+
+	m_pData = NULL;
+	m_uSize = 0;
+}
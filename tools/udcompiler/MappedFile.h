@@ -0,0 +1,28 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+// Read-only mapping of a whole file. The contents stay valid until
+// close() or destruction, the file handle itself is not kept open.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const std::string &strFileName);
+	void close();
+
+	const unsigned char *getData() const { return m_pData; }
+	size_t getSize() const { return m_uSize; }
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+	const unsigned char *m_pData;
+	size_t m_uSize;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "RTLBasicPasses.h"
+#include <stdio.h>
+
+bool RTLRemoveNopPass::run(RTLGeneratorBase::tCollFunctionRTL &collFunctions)
+{
+	for(unsigned uIdx = 0; uIdx < collFunctions.size(); uIdx++)
+	{
+		RTLGeneratorBase::RTLCode &aCode = collFunctions[uIdx].getCode();
+		unsigned uNumOps = aCode.getNumOps();
+
+		aCode.removeOps(RTLGeneratorBase::RTLOp::OP_NOP);
+		m_uNumRemoved += uNumOps - aCode.getNumOps();
+	}
+
+	return true;
+}
+
+RTLStatisticsPass::RTLStatisticsPass() :
+	m_uNumDistinctArgs(0),
+	m_uMemoryUsage(0)
+{
+	for(unsigned uType = 0; uType < NUM_OP_TYPES; uType++)
+	{
+		m_aNumOps[uType] = 0;
+	}
+}
+
+bool RTLStatisticsPass::run(RTLGeneratorBase::tCollFunctionRTL &collFunctions)
+{
+	for(unsigned uIdx = 0; uIdx < collFunctions.size(); uIdx++)
+	{
+		const RTLGeneratorBase::RTLCode &aCode = collFunctions[uIdx].getCode();
+
+		for(unsigned uOpIdx = 0; uOpIdx < aCode.getNumOps(); uOpIdx++)
+		{
+			m_aNumOps[aCode.getType(uOpIdx)]++;
+		}
+
+		m_uNumDistinctArgs += aCode.getNumDistinctArgs();
+		m_uMemoryUsage += aCode.getMemoryUsage();
+	}
+
+	return true;
+}
+
+void RTLStatisticsPass::print() const
+{
+	unsigned uNumOps = 0;
+
+	for(unsigned uType = 0; uType < NUM_OP_TYPES; uType++)
+	{
+		printf("%-24s %10u\n", RTLGeneratorBase::getOpName(static_cast<RTLGeneratorBase::RTLOp::eType>(uType)), m_aNumOps[uType]);
+		uNumOps += m_aNumOps[uType];
+	}
+
+	printf("%u distinct arguments, %u bytes of RTL (%.1f bytes per op)\n", m_uNumDistinctArgs,
+		static_cast<unsigned>(m_uMemoryUsage), uNumOps ? (static_cast<double>(m_uMemoryUsage) / uNumOps) : 0.0);
+}
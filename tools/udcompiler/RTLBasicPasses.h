@@ -0,0 +1,47 @@
+#ifndef RTLBASICPASSES_H
+#define RTLBASICPASSES_H
+
+#ifndef RTLPASSMANAGER_H
+#include "RTLPassManager.h"
+#endif
+
+// Drops all OP_NOP, they carry nothing for the later stages
+class RTLRemoveNopPass : public RTLPass
+{
+public:
+	RTLRemoveNopPass() :
+		m_uNumRemoved(0)
+	{}
+
+	const char *getName() const { return "remove nops"; }
+	bool run(RTLGeneratorBase::tCollFunctionRTL &collFunctions);
+
+	unsigned getNumRemoved() const { return m_uNumRemoved; }
+
+private:
+	unsigned m_uNumRemoved;
+};
+
+// Counts the ops per type and the memory the RTL takes up
+class RTLStatisticsPass : public RTLPass
+{
+public:
+	RTLStatisticsPass();
+
+	const char *getName() const { return "statistics"; }
+	bool run(RTLGeneratorBase::tCollFunctionRTL &collFunctions);
+
+	void print() const;
+
+private:
+	enum
+	{
+		NUM_OP_TYPES = RTLGeneratorBase::RTLOp::OP_SUBTRACT + 1
+	};
+
+	unsigned m_aNumOps[NUM_OP_TYPES];
+	unsigned m_uNumDistinctArgs;
+	size_t m_uMemoryUsage;
+};
+
+#endif
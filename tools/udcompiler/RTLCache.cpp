@@ -0,0 +1,292 @@
+#include "RTLCache.h"
+#include "MappedFile.h"
+#include <stdio.h>
+#include <string.h>
+
+// 64 bit FNV-1a
+static RTLCache::tKey hashBytes(RTLCache::tKey uHash, const void *pData, size_t uSize)
+{
+	const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+
+	for(size_t uIdx = 0; uIdx < uSize; uIdx++)
+	{
+		uHash = (uHash ^ pBytes[uIdx]) * 1099511628211ULL;
+	}
+
+	return uHash;
+}
+
+static RTLCache::tKey hashValue(RTLCache::tKey uHash, unsigned uValue)
+{
+	return hashBytes(uHash, &uValue, sizeof(uValue));
+}
+
+RTLCache::tKey RTLCache::getKey(LoaderBase::eArchType enArchType, const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols)
+{
+	tKey uHash = 14695981039346656037ULL;
+
+	uHash = hashValue(uHash, enArchType);
+	uHash = hashValue(uHash, aCode.getAddress());
+	uHash = hashValue(uHash, static_cast<unsigned>(aCode.getSize()));
+	uHash = hashBytes(uHash, aCode.getData(), aCode.getSize());
+
+	for(unsigned uIdx = 0; uIdx < collSymbols.size(); uIdx++)
+	{
+		const LoaderBase::tSymbol &aSymbol = collSymbols[uIdx];
+
+		uHash = hashValue(uHash, aSymbol.uOffset);
+		uHash = hashValue(uHash, aSymbol.uSize);
+		uHash = hashBytes(uHash, aSymbol.pName, ::strlen(aSymbol.pName) + 1);
+	}
+
+	return uHash;
+}
+
+std::string RTLCache::getFileName(tKey uKey) const
+{
+	char pName[32];
+
+	::sprintf(pName, "%08X%08X.rtl", static_cast<unsigned>(uKey >> 32), static_cast<unsigned>(uKey));
+
+	return m_strDirectory + "/" + pName;
+}
+
+// Accounts for uCount entries of the file, false if there aren't as
+// many bytes left
+static bool takeEntries(size_t &uRemaining, unsigned uCount, size_t uEntrySize)
+{
+	if(uCount > (uRemaining / uEntrySize))
+	{
+		return false;
+	}
+
+	uRemaining -= uCount * uEntrySize;
+
+	return true;
+}
+
+// Everything read from the file is checked before use, a damaged file
+// only costs a cache miss
+bool RTLCache::load(tKey uKey, RTLGeneratorBase::tCollFunctionRTL &collFunctions) const
+{
+	MappedFile aFile;
+
+	if((!aFile.open(getFileName(uKey))) || (aFile.getSize() < sizeof(tFileHeader)))
+	{
+		return false;
+	}
+
+	const tFileHeader *pHeader = reinterpret_cast<const tFileHeader *>(aFile.getData());
+
+	if((pHeader->uMagic != FILE_MAGIC) || (pHeader->uVersion != FILE_VERSION) ||
+		(pHeader->uKeyLow != static_cast<unsigned>(uKey)) || (pHeader->uKeyHigh != static_cast<unsigned>(uKey >> 32)))
+	{
+		return false;
+	}
+
+	size_t uRemaining = aFile.getSize() - sizeof(tFileHeader);
+
+	if((!takeEntries(uRemaining, pHeader->uNumFunctions, sizeof(tFunctionRecord))) ||
+		(!takeEntries(uRemaining, pHeader->uNumOps, sizeof(RTLGeneratorBase::RTLCode::tOp))) ||
+		(!takeEntries(uRemaining, pHeader->uNumArgRefs, sizeof(unsigned))) ||
+		(!takeEntries(uRemaining, pHeader->uNumArgs, sizeof(tArgRecord))) ||
+		(uRemaining != pHeader->uStringsSize))
+	{
+		return false;
+	}
+
+	const tFunctionRecord *pFunctions = reinterpret_cast<const tFunctionRecord *>(pHeader + 1);
+	const RTLGeneratorBase::RTLCode::tOp *pOps = reinterpret_cast<const RTLGeneratorBase::RTLCode::tOp *>(pFunctions + pHeader->uNumFunctions);
+	const unsigned *pArgRefs = reinterpret_cast<const unsigned *>(pOps + pHeader->uNumOps);
+	const tArgRecord *pArgs = reinterpret_cast<const tArgRecord *>(pArgRefs + pHeader->uNumArgRefs);
+	const char *pStrings = reinterpret_cast<const char *>(pArgs + pHeader->uNumArgs);
+
+	if((pHeader->uStringsSize) && (pStrings[pHeader->uStringsSize - 1]))
+	{
+		return false;
+	}
+
+	unsigned uNumOps = 0;
+	unsigned uNumArgRefs = 0;
+	unsigned uNumArgs = 0;
+
+	collFunctions.clear();
+	collFunctions.resize(pHeader->uNumFunctions);
+
+	for(unsigned uIdx = 0; uIdx < pHeader->uNumFunctions; uIdx++)
+	{
+		const tFunctionRecord &aRecord = pFunctions[uIdx];
+		RTLGeneratorBase::FunctionRTL &aFunction = collFunctions[uIdx];
+		RTLGeneratorBase::RTLCode &aCode = aFunction.getCode();
+
+		if((aRecord.uNameOffset >= pHeader->uStringsSize) ||
+			(aRecord.uNumOps > (pHeader->uNumOps - uNumOps)) ||
+			(aRecord.uNumArgRefs > (pHeader->uNumArgRefs - uNumArgRefs)) ||
+			(aRecord.uNumArgs > (pHeader->uNumArgs - uNumArgs)))
+		{
+			collFunctions.clear();
+			return false;
+		}
+
+		aFunction.setName(pStrings + aRecord.uNameOffset);
+		aFunction.setAddress(aRecord.uAddress);
+		aFunction.setSize(aRecord.uSize);
+
+		aCode.m_collOps.assign(pOps + uNumOps, pOps + uNumOps + aRecord.uNumOps);
+		aCode.m_collArgRefs.assign(pArgRefs + uNumArgRefs, pArgRefs + uNumArgRefs + aRecord.uNumArgRefs);
+		aCode.m_collArgs.resize(aRecord.uNumArgs);
+
+		for(unsigned uOpIdx = 0; uOpIdx < aRecord.uNumOps; uOpIdx++)
+		{
+			const RTLGeneratorBase::RTLCode::tOp &aOp = aCode.m_collOps[uOpIdx];
+
+			if((aOp.uType > RTLGeneratorBase::RTLOp::OP_SUBTRACT) ||
+				(aOp.uFirstArg > aRecord.uNumArgRefs) || (aOp.uNumArgs > (aRecord.uNumArgRefs - aOp.uFirstArg)))
+			{
+				collFunctions.clear();
+				return false;
+			}
+		}
+
+		for(unsigned uRefIdx = 0; uRefIdx < aRecord.uNumArgRefs; uRefIdx++)
+		{
+			if(aCode.m_collArgRefs[uRefIdx] >= aRecord.uNumArgs)
+			{
+				collFunctions.clear();
+				return false;
+			}
+		}
+
+		for(unsigned uArgIdx = 0; uArgIdx < aRecord.uNumArgs; uArgIdx++)
+		{
+			const tArgRecord &aArgRecord = pArgs[uNumArgs + uArgIdx];
+			RTLGeneratorBase::Argument &aArg = aCode.m_collArgs[uArgIdx];
+
+			aArg.setType(static_cast<RTLGeneratorBase::Argument::eType>(aArgRecord.uType));
+			aArg.setRegister(static_cast<RTLGeneratorBase::Argument::eRegister>(aArgRecord.uRegister));
+			aArg.setDataWidth(static_cast<RTLGeneratorBase::Argument::eDataWidth>(aArgRecord.uDataWidth));
+			aArg.setValue(aArgRecord.uValue);
+		}
+
+		uNumOps += aRecord.uNumOps;
+		uNumArgRefs += aRecord.uNumArgRefs;
+		uNumArgs += aRecord.uNumArgs;
+	}
+
+	return true;
+}
+
+// Written to a temporary file first, so readers never see half a file
+bool RTLCache::store(tKey uKey, const RTLGeneratorBase::tCollFunctionRTL &collFunctions) const
+{
+	tFileHeader aHeader;
+	std::vector<tFunctionRecord> collRecords(collFunctions.size());
+	std::vector<tArgRecord> collArgs;
+	std::string strStrings;
+
+	::memset(&aHeader, 0, sizeof(aHeader));
+	aHeader.uMagic = FILE_MAGIC;
+	aHeader.uVersion = FILE_VERSION;
+	aHeader.uKeyLow = static_cast<unsigned>(uKey);
+	aHeader.uKeyHigh = static_cast<unsigned>(uKey >> 32);
+	aHeader.uNumFunctions = collFunctions.size();
+
+	for(unsigned uIdx = 0; uIdx < collFunctions.size(); uIdx++)
+	{
+		const RTLGeneratorBase::FunctionRTL &aFunction = collFunctions[uIdx];
+		const RTLGeneratorBase::RTLCode &aCode = aFunction.getCode();
+		tFunctionRecord &aRecord = collRecords[uIdx];
+
+		aRecord.uNameOffset = strStrings.size();
+		aRecord.uAddress = aFunction.getAddress();
+		aRecord.uSize = aFunction.getSize();
+		aRecord.uNumOps = aCode.m_collOps.size();
+		aRecord.uNumArgRefs = aCode.m_collArgRefs.size();
+		aRecord.uNumArgs = aCode.m_collArgs.size();
+
+		strStrings.append(aFunction.getName().c_str(), aFunction.getName().size() + 1);
+
+		for(unsigned uArgIdx = 0; uArgIdx < aCode.m_collArgs.size(); uArgIdx++)
+		{
+			const RTLGeneratorBase::Argument &aArg = aCode.m_collArgs[uArgIdx];
+			tArgRecord aArgRecord;
+
+			aArgRecord.uType = aArg.getType();
+			aArgRecord.uRegister = aArg.getRegister();
+			aArgRecord.uDataWidth = aArg.getDataWidth();
+			aArgRecord.uValue = aArg.getValue();
+			collArgs.push_back(aArgRecord);
+		}
+
+		aHeader.uNumOps += aRecord.uNumOps;
+		aHeader.uNumArgRefs += aRecord.uNumArgRefs;
+	}
+
+	aHeader.uNumArgs = collArgs.size();
+	aHeader.uStringsSize = strStrings.size();
+
+	std::string strFileName = getFileName(uKey);
+	std::string strTempFileName = strFileName + ".tmp";
+	FILE *pFile = ::fopen(strTempFileName.c_str(), "wb");
+
+	if(!pFile)
+	{
+		return false;
+	}
+
+	bool bResult = (::fwrite(&aHeader, sizeof(aHeader), 1, pFile) == 1);
+
+	if((bResult) && (!collRecords.empty()))
+	{
+		bResult = (::fwrite(&collRecords[0], sizeof(tFunctionRecord), collRecords.size(), pFile) == collRecords.size());
+	}
+
+	for(unsigned uIdx = 0; (bResult) && (uIdx < collFunctions.size()); uIdx++)
+	{
+		const RTLGeneratorBase::RTLCode &aCode = collFunctions[uIdx].getCode();
+
+		if(!aCode.m_collOps.empty())
+		{
+			bResult = (::fwrite(&aCode.m_collOps[0], sizeof(RTLGeneratorBase::RTLCode::tOp), aCode.m_collOps.size(), pFile) == aCode.m_collOps.size());
+		}
+	}
+
+	for(unsigned uIdx = 0; (bResult) && (uIdx < collFunctions.size()); uIdx++)
+	{
+		const RTLGeneratorBase::RTLCode &aCode = collFunctions[uIdx].getCode();
+
+		if(!aCode.m_collArgRefs.empty())
+		{
+			bResult = (::fwrite(&aCode.m_collArgRefs[0], sizeof(unsigned), aCode.m_collArgRefs.size(), pFile) == aCode.m_collArgRefs.size());
+		}
+	}
+
+	if((bResult) && (!collArgs.empty()))
+	{
+		bResult = (::fwrite(&collArgs[0], sizeof(tArgRecord), collArgs.size(), pFile) == collArgs.size());
+	}
+
+	if((bResult) && (!strStrings.empty()))
+	{
+		bResult = (::fwrite(strStrings.data(), 1, strStrings.size(), pFile) == strStrings.size());
+	}
+
+	if(::fclose(pFile))
+	{
+		bResult = false;
+	}
+
+	if(bResult)
+	{
+		// rename() doesn't replace existing files everywhere
+		::remove(strFileName.c_str());
+		bResult = (::rename(strTempFileName.c_str(), strFileName.c_str()) == 0);
+	}
+
+	if(!bResult)
+	{
+		::remove(strTempFileName.c_str());
+	}
+
+	return bResult;
+}
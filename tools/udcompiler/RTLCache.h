@@ -0,0 +1,81 @@
+#ifndef RTLCACHE_H
+#define RTLCACHE_H
+
+#ifndef RTLGENERATORBASE_H
+#include "RTLGeneratorBase.h"
+#endif
+
+#include <string>
+
+// On-disk cache of the generated RTL, one file per code section. The
+// file name is derived from a hash over the section contents and the
+// function symbols, so a changed section simply misses the cache.
+//
+// Layout, all values in host byte order:
+//   tFileHeader
+//   tFunctionRecord  * uNumFunctions
+//   RTLCode::tOp     * uNumOps       (ops of all functions back to back)
+//   unsigned         * uNumArgRefs
+//   tArgRecord       * uNumArgs
+//   char             * uStringsSize  (function names, NUL terminated)
+class RTLCache
+{
+public:
+	typedef unsigned long long tKey;
+
+	RTLCache(const std::string &strDirectory) :
+		m_strDirectory(strDirectory)
+	{}
+
+	static tKey getKey(LoaderBase::eArchType enArchType, const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols);
+
+	bool load(tKey uKey, RTLGeneratorBase::tCollFunctionRTL &collFunctions) const;
+	bool store(tKey uKey, const RTLGeneratorBase::tCollFunctionRTL &collFunctions) const;
+
+private:
+	// Bump whenever the layout or the RTL produced by the generators
+	// changes, older files are then ignored
+	enum
+	{
+		FILE_MAGIC = 0x4C545255, // "URTL"
+		FILE_VERSION = 1
+	};
+
+	typedef struct
+	{
+		unsigned uMagic;
+		unsigned uVersion;
+		unsigned uKeyLow;
+		unsigned uKeyHigh;
+		unsigned uNumFunctions;
+		unsigned uNumOps;
+		unsigned uNumArgRefs;
+		unsigned uNumArgs;
+		unsigned uStringsSize;
+	} tFileHeader;
+
+	// Counts of the function, its entries follow those of the previous one
+	typedef struct
+	{
+		unsigned uNameOffset;
+		unsigned uAddress;
+		unsigned uSize;
+		unsigned uNumOps;
+		unsigned uNumArgRefs;
+		unsigned uNumArgs;
+	} tFunctionRecord;
+
+	typedef struct
+	{
+		unsigned uType;
+		unsigned uRegister;
+		unsigned uDataWidth;
+		unsigned uValue;
+	} tArgRecord;
+
+	std::string getFileName(tKey uKey) const;
+
+	std::string m_strDirectory;
+};
+
+#endif
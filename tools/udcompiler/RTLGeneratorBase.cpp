@@ -1,66 +1,305 @@
 #include "RTLGeneratorBase.h"
+#include "Thread.h"
+#include <stdio.h>
 
-bool RTLGeneratorBase::dumpRTL(const tCollRTLOps &collRTLOps) const
+typedef struct
 {
-	tCollRTLOps::const_iterator it = collRTLOps.begin();
-	tCollRTLOps::const_iterator itEnd = collRTLOps.end();
+	RTLGeneratorBase *pGenerator;
+	const LoaderBase::SectionView *pCode;
+	RTLGeneratorBase::tCollFunctionRTL *pFunctions;
+	Mutex aMutex;
+	unsigned uNextFunctionIdx;
+	bool bResult;
+} tGenerateState;
 
-	for(; it != itEnd; it++)
+// One chunk per function, from its symbol up to the next one. Aliases
+// at the same offset keep the name of the first symbol.
+void RTLGeneratorBase::splitAtSymbols(const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols, tCollFunctionRTL &collFunctions)
+{
+	collFunctions.clear();
+
+	unsigned uOffset = 0;
+	const char *pName = "";
+	bool bNamed = false;
+
+	for(unsigned uIdx = 0; uIdx <= collSymbols.size(); uIdx++)
 	{
-		const RTLOp &aRTLOp = *it;
+		unsigned uEndOffset = (uIdx < collSymbols.size()) ? collSymbols[uIdx].uOffset : aCode.getSize();
 
-		switch(aRTLOp.getType())
+		if(uEndOffset > uOffset)
 		{
-			case RTLOp::OP_ADD:
-				printf("OP_ADD\n");
-				break;
-			case RTLOp::OP_ASSIGN:
-				printf("OP_ASSIGN\n");
-				break;
-			case RTLOp::OP_CALL:
-				printf("OP_CALL\n");
-				break;
-			case RTLOp::OP_COMPARE:
-				printf("OP_COMPARE\n");
-				break;
-			case RTLOp::OP_JUMP:
-				printf("OP_JUMP\n");
-				break;
-			case RTLOp::OP_NOP:
-				printf("OP_NOP\n");
-				break;
-			case RTLOp::OP_RETURN:
-				printf("OP_RETURN\n");
-				break;
-			case RTLOp::OP_SUBTRACT:
-				printf("OP_SUBTRACT\n");
-				break;
-			case RTLOp::OP_UNKNOWN:
-				printf("OP_UNKNOWN\n");
-				break;
-			default:
-				return false;
+			FunctionRTL aFunction;
+
+			aFunction.setName(pName);
+			aFunction.setAddress(aCode.getAddress() + uOffset);
+			aFunction.setSize(uEndOffset - uOffset);
+			collFunctions.push_back(aFunction);
+
+			uOffset = uEndOffset;
+			bNamed = false;
 		}
 
-		if(aRTLOp.getArg1().getType() != Argument::TYPE_UNKNOWN)
+		if((uIdx < collSymbols.size()) && (!bNamed))
 		{
-			if(!dumpArg(aRTLOp.getArg1()))
-			{
-				return false;
-			}
+			pName = collSymbols[uIdx].pName;
+			bNamed = true;
 		}
+	}
+}
+
+void RTLGeneratorBase::generateWorker(void *pArg)
+{
+	tGenerateState *pState = reinterpret_cast<tGenerateState *>(pArg);
+
+	while(true)
+	{
+		pState->aMutex.lock();
+		unsigned uFunctionIdx = pState->uNextFunctionIdx++;
+		pState->aMutex.unlock();
 
-		if(aRTLOp.getArg2().getType() != Argument::TYPE_UNKNOWN)
+		if(uFunctionIdx >= pState->pFunctions->size())
 		{
-			if(!dumpArg(aRTLOp.getArg2()))
-			{
-				return false;
-			}
+			break;
+		}
+
+		// Every function has its own slot, so no locking is needed
+		FunctionRTL &aFunction = (*pState->pFunctions)[uFunctionIdx];
+		unsigned uOffset = aFunction.getAddress() - pState->pCode->getAddress();
+		LoaderBase::SectionView aChunk(pState->pCode->getData() + uOffset, aFunction.getSize(), aFunction.getAddress());
+
+		if(!pState->pGenerator->generateRTL(aChunk, aFunction.getCode()))
+		{
+			pState->aMutex.lock();
+			pState->bResult = false;
+			pState->aMutex.unlock();
+		}
+	}
+}
+
+// Linear sweep over a whole code section. The section is split at the
+// function symbols and the functions are decoded concurrently, the
+// result keeps the order of the section.
+bool RTLGeneratorBase::generateFunctionRTL(const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols, unsigned uNumThreads, tCollFunctionRTL &collFunctions)
+{
+	tGenerateState aState;
+
+	splitAtSymbols(aCode, collSymbols, collFunctions);
+
+	aState.pGenerator = this;
+	aState.pCode = &aCode;
+	aState.pFunctions = &collFunctions;
+	aState.uNextFunctionIdx = 0;
+	aState.bResult = true;
+
+	if(uNumThreads > collFunctions.size())
+	{
+		uNumThreads = collFunctions.size();
+	}
+
+	std::vector<Thread *> collThreads;
+
+	// The calling thread is worker number one
+	for(unsigned uThreadIdx = 1; uThreadIdx < uNumThreads; uThreadIdx++)
+	{
+		Thread *pThread = new Thread;
+
+		if(!pThread->start(generateWorker, &aState))
+		{
+			delete pThread;
+			break;
+		}
+
+		collThreads.push_back(pThread);
+	}
+
+	generateWorker(&aState);
+
+	for(unsigned uThreadIdx = 0; uThreadIdx < collThreads.size(); uThreadIdx++)
+	{
+		collThreads[uThreadIdx]->join();
+		delete collThreads[uThreadIdx];
+	}
+
+	return aState.bResult;
+}
+
+void RTLGeneratorBase::RTLCode::clear()
+{
+	m_collOps.clear();
+	m_collArgRefs.clear();
+	m_collArgs.clear();
+	m_collArgIndex.clear();
+}
+
+// Only the arguments up to the last one in use are stored
+void RTLGeneratorBase::RTLCode::addOp(const RTLOp &aRTLOp)
+{
+	const Argument *pArgs[3] = { &aRTLOp.getArg1(), &aRTLOp.getArg2(), &aRTLOp.getArg3() };
+	unsigned uNumArgs = 3;
+	tOp aOp;
+
+	while((uNumArgs > 0) && (pArgs[uNumArgs - 1]->getType() == Argument::TYPE_UNKNOWN))
+	{
+		uNumArgs--;
+	}
+
+	aOp.uAddress = aRTLOp.getAddress();
+	aOp.uFirstArg = m_collArgRefs.size();
+	aOp.uType = aRTLOp.getType();
+	aOp.uNumArgs = uNumArgs;
+
+	for(unsigned uIdx = 0; uIdx < uNumArgs; uIdx++)
+	{
+		m_collArgRefs.push_back(internArg(*pArgs[uIdx]));
+	}
+
+	m_collOps.push_back(aOp);
+}
+
+// Rewrite passes mark ops by changing their type, this drops them and
+// closes the gaps in both arrays
+void RTLGeneratorBase::RTLCode::removeOps(RTLOp::eType enType)
+{
+	unsigned uNumOps = 0;
+	unsigned uNumArgRefs = 0;
+
+	for(unsigned uIdx = 0; uIdx < m_collOps.size(); uIdx++)
+	{
+		tOp aOp = m_collOps[uIdx];
+
+		if(aOp.uType == enType)
+		{
+			continue;
+		}
+
+		for(unsigned uArgIdx = 0; uArgIdx < aOp.uNumArgs; uArgIdx++)
+		{
+			m_collArgRefs[uNumArgRefs + uArgIdx] = m_collArgRefs[aOp.uFirstArg + uArgIdx];
 		}
 
-		if(aRTLOp.getArg3().getType() != Argument::TYPE_UNKNOWN)
+		aOp.uFirstArg = uNumArgRefs;
+		uNumArgRefs += aOp.uNumArgs;
+		m_collOps[uNumOps++] = aOp;
+	}
+
+	m_collOps.resize(uNumOps);
+	m_collArgRefs.resize(uNumArgRefs);
+}
+
+size_t RTLGeneratorBase::RTLCode::getMemoryUsage() const
+{
+	return (m_collOps.capacity() * sizeof(tOp)) + (m_collArgRefs.capacity() * sizeof(unsigned)) +
+		(m_collArgs.capacity() * sizeof(Argument)) + (m_collArgIndex.capacity() * sizeof(unsigned));
+}
+
+static unsigned hashArg(const RTLGeneratorBase::Argument &aArg)
+{
+	unsigned uHash = aArg.getType();
+
+	uHash = (uHash * 31) + aArg.getRegister();
+	uHash = (uHash * 31) + aArg.getDataWidth();
+	uHash = (uHash * 31) + aArg.getValue();
+
+	return uHash * 2654435761U;
+}
+
+unsigned RTLGeneratorBase::RTLCode::internArg(const Argument &aArg)
+{
+	// Keep the table at most half full
+	if((m_collArgs.size() * 2) >= m_collArgIndex.size())
+	{
+		growArgIndex();
+	}
+
+	unsigned uMask = m_collArgIndex.size() - 1;
+	unsigned uSlot = hashArg(aArg) & uMask;
+
+	for(; m_collArgIndex[uSlot]; uSlot = (uSlot + 1) & uMask)
+	{
+		if(m_collArgs[m_collArgIndex[uSlot] - 1] == aArg)
 		{
-			if(!dumpArg(aRTLOp.getArg3()))
+			return m_collArgIndex[uSlot] - 1;
+		}
+	}
+
+	m_collArgs.push_back(aArg);
+	m_collArgIndex[uSlot] = m_collArgs.size();
+
+	return m_collArgs.size() - 1;
+}
+
+void RTLGeneratorBase::RTLCode::growArgIndex()
+{
+	unsigned uNumSlots = m_collArgIndex.empty() ? 16 : (m_collArgIndex.size() * 2);
+
+	// The arguments of RTL loaded from the cache come without an index
+	while(uNumSlots <= (m_collArgs.size() * 2))
+	{
+		uNumSlots *= 2;
+	}
+
+	m_collArgIndex.assign(uNumSlots, 0);
+
+	for(unsigned uIdx = 0; uIdx < m_collArgs.size(); uIdx++)
+	{
+		unsigned uSlot = hashArg(m_collArgs[uIdx]) & (uNumSlots - 1);
+
+		while(m_collArgIndex[uSlot])
+		{
+			uSlot = (uSlot + 1) & (uNumSlots - 1);
+		}
+
+		m_collArgIndex[uSlot] = uIdx + 1;
+	}
+}
+
+const char *RTLGeneratorBase::getOpName(RTLOp::eType enType)
+{
+	switch(enType)
+	{
+		case RTLOp::OP_ADD:
+			return "OP_ADD";
+		case RTLOp::OP_ASSIGN:
+			return "OP_ASSIGN";
+		case RTLOp::OP_CALL:
+			return "OP_CALL";
+		case RTLOp::OP_COMPARE:
+			return "OP_COMPARE";
+		case RTLOp::OP_JUMP:
+			return "OP_JUMP";
+		case RTLOp::OP_NOP:
+			return "OP_NOP";
+		case RTLOp::OP_RETURN:
+			return "OP_RETURN";
+		case RTLOp::OP_SUBTRACT:
+			return "OP_SUBTRACT";
+		case RTLOp::OP_UNKNOWN:
+			return "OP_UNKNOWN";
+		default:
+			return NULL;
+	}
+}
+
+bool RTLGeneratorBase::dumpRTL(const RTLCode &aRTLCode) const
+{
+	for(unsigned uOpIdx = 0; uOpIdx < aRTLCode.getNumOps(); uOpIdx++)
+	{
+		printf("0x%08X: ", aRTLCode.getAddress(uOpIdx));
+
+		const char *pOpName = getOpName(aRTLCode.getType(uOpIdx));
+
+		if(pOpName == NULL)
+		{
+			return false;
+		}
+
+		printf("%s\n", pOpName);
+
+		for(unsigned uArgIdx = 0; uArgIdx < aRTLCode.getNumArgs(uOpIdx); uArgIdx++)
+		{
+			const Argument &aArg = aRTLCode.getArg(uOpIdx, uArgIdx);
+
+			if((aArg.getType() != Argument::TYPE_UNKNOWN) && (!dumpArg(aArg)))
 			{
 				return false;
 			}
@@ -5,7 +5,7 @@
 #include "LoaderBase.h"
 #endif
 
-#include <list>
+#include <vector>
 
 class RTLGeneratorBase
 {
@@ -20,7 +20,35 @@ public:
 			REGISTER_R001,
 			REGISTER_R002,
 			REGISTER_R003,
-			REGISTER_R004
+			REGISTER_R004,
+			REGISTER_R005,
+			REGISTER_R006,
+			REGISTER_R007,
+			REGISTER_R008,
+			REGISTER_R009,
+			REGISTER_R010,
+			REGISTER_R011,
+			REGISTER_R012,
+			REGISTER_R013,
+			REGISTER_R014,
+			REGISTER_R015,
+			REGISTER_R016,
+			REGISTER_R017,
+			REGISTER_R018,
+			REGISTER_R019,
+			REGISTER_R020,
+			REGISTER_R021,
+			REGISTER_R022,
+			REGISTER_R023,
+			REGISTER_R024,
+			REGISTER_R025,
+			REGISTER_R026,
+			REGISTER_R027,
+			REGISTER_R028,
+			REGISTER_R029,
+			REGISTER_R030,
+			REGISTER_R031,
+			REGISTER_R032
 		};
 
 		enum eType
@@ -64,6 +92,12 @@ public:
 		unsigned getValue() const { return m_uValue; }
 		void setValue(unsigned uValue) { m_uValue = uValue; }
 
+		bool operator==(const Argument &aOther) const
+		{
+			return (m_enType == aOther.m_enType) && (m_enRegister == aOther.m_enRegister) &&
+				(m_enDataWidth == aOther.m_enDataWidth) && (m_uValue == aOther.m_uValue);
+		}
+
 	private:
 		eType m_enType;
 		eRegister m_enRegister;
@@ -89,12 +123,16 @@ public:
 		};
 
 		RTLOp() :
-		  m_enType(OP_UNKNOWN)
+		  m_enType(OP_UNKNOWN),
+		  m_uAddress(0)
 		{}
 
 		eType getType() const { return m_enType; }
 		void setType(eType enType) { m_enType = enType; }
 
+		unsigned getAddress() const { return m_uAddress; }
+		void setAddress(unsigned uAddress) { m_uAddress = uAddress; }
+
 		Argument &getArg1() { return m_aArg1; }
 		Argument &getArg2() { return m_aArg2; }
 		Argument &getArg3() { return m_aArg3; }
@@ -104,21 +142,103 @@ public:
 
 	private:
 		eType m_enType;
+		unsigned m_uAddress;
 		Argument m_aArg1;
 		Argument m_aArg2;
 		Argument m_aArg3;
 	};
 
-	typedef std::list<RTLOp> tCollRTLOps;
+	// Dense RTL of one function. The ops are kept back to back, their
+	// arguments in a side array of indices into a table holding every
+	// distinct argument once. RTLOp is only used to build an op.
+	class RTLCode
+	{
+	public:
+		void clear();
+		void addOp(const RTLOp &aRTLOp);
+		void removeOps(RTLOp::eType enType);
+
+		unsigned getNumOps() const { return m_collOps.size(); }
+		RTLOp::eType getType(unsigned uOpIdx) const { return static_cast<RTLOp::eType>(m_collOps[uOpIdx].uType); }
+		void setType(unsigned uOpIdx, RTLOp::eType enType) { m_collOps[uOpIdx].uType = enType; }
+		unsigned getAddress(unsigned uOpIdx) const { return m_collOps[uOpIdx].uAddress; }
+		unsigned getNumArgs(unsigned uOpIdx) const { return m_collOps[uOpIdx].uNumArgs; }
+		const Argument &getArg(unsigned uOpIdx, unsigned uArgIdx) const { return m_collArgs[m_collArgRefs[m_collOps[uOpIdx].uFirstArg + uArgIdx]]; }
+
+		unsigned getNumDistinctArgs() const { return m_collArgs.size(); }
+		size_t getMemoryUsage() const;
+
+	private:
+		friend class RTLCache;
+
+		typedef struct
+		{
+			unsigned uAddress;
+			unsigned uFirstArg;
+			unsigned short uType;
+			unsigned short uNumArgs;
+		} tOp;
+
+		unsigned internArg(const Argument &aArg);
+		void growArgIndex();
+
+		std::vector<tOp> m_collOps;
+		std::vector<unsigned> m_collArgRefs;
+		std::vector<Argument> m_collArgs;
+
+		// Open addressed, slots hold the index into m_collArgs + 1
+		std::vector<unsigned> m_collArgIndex;
+	};
+
+	// RTL of a single function, code in front of the first function
+	// symbol gets an entry without a name
+	class FunctionRTL
+	{
+	public:
+		FunctionRTL() :
+			m_uAddress(0),
+			m_uSize(0)
+		{}
+
+		const std::string &getName() const { return m_strName; }
+		void setName(const std::string &strName) { m_strName = strName; }
+
+		unsigned getAddress() const { return m_uAddress; }
+		void setAddress(unsigned uAddress) { m_uAddress = uAddress; }
 
-	virtual bool generateRTL(const LoaderBase::tCollData &collData, tCollRTLOps &collRTLOps) = 0;
-	bool dumpRTL(const tCollRTLOps &collRTLOps) const;
+		unsigned getSize() const { return m_uSize; }
+		void setSize(unsigned uSize) { m_uSize = uSize; }
+
+		RTLCode &getCode() { return m_aCode; }
+		const RTLCode &getCode() const { return m_aCode; }
+
+	private:
+		std::string m_strName;
+		unsigned m_uAddress;
+		unsigned m_uSize;
+		RTLCode m_aCode;
+	};
+
+	typedef std::vector<FunctionRTL> tCollFunctionRTL;
+
+	// Decodes the whole view. Called from several threads at once by
+	// generateFunctionRTL, so implementations must not keep any state.
+	virtual bool generateRTL(const LoaderBase::SectionView &aCode, RTLCode &aRTLCode) = 0;
+	virtual bool dumpDisassembly(const LoaderBase::SectionView &aCode) const = 0;
+
+	bool generateFunctionRTL(const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols, unsigned uNumThreads, tCollFunctionRTL &collFunctions);
+	bool dumpRTL(const RTLCode &aRTLCode) const;
+
+	static const char *getOpName(RTLOp::eType enType);
 
 protected:
 	virtual std::string getRegisterName(Argument::eRegister enRegister, Argument::eDataWidth enDataWidth) const = 0;
 	std::string getDataWidthSuffix(Argument::eDataWidth enDataWidth) const;
 
 private:
+	static void generateWorker(void *pArg);
+	static void splitAtSymbols(const LoaderBase::SectionView &aCode, const LoaderBase::tCollSymbols &collSymbols, tCollFunctionRTL &collFunctions);
+
 	bool dumpArg(const Argument &aArg) const;
 };
 
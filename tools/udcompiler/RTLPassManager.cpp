@@ -0,0 +1,41 @@
+#include "RTLPassManager.h"
+#include "Timer.h"
+#include <stdio.h>
+
+void RTLPassManager::addPass(RTLPass *pPass)
+{
+	tPassEntry aEntry;
+
+	aEntry.pPass = pPass;
+	aEntry.dTime = 0.0;
+
+	m_collPasses.push_back(aEntry);
+}
+
+bool RTLPassManager::run(RTLGeneratorBase::tCollFunctionRTL &collFunctions)
+{
+	for(unsigned uIdx = 0; uIdx < m_collPasses.size(); uIdx++)
+	{
+		tPassEntry &aEntry = m_collPasses[uIdx];
+		double dStartTime = getTimeSeconds();
+		bool bResult = aEntry.pPass->run(collFunctions);
+
+		aEntry.dTime += getTimeSeconds() - dStartTime;
+
+		if(!bResult)
+		{
+			printf("Pass %s failed\n", aEntry.pPass->getName());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RTLPassManager::printTimes() const
+{
+	for(unsigned uIdx = 0; uIdx < m_collPasses.size(); uIdx++)
+	{
+		printf("%-24s %10.3f ms\n", m_collPasses[uIdx].pPass->getName(), m_collPasses[uIdx].dTime * 1000.0);
+	}
+}
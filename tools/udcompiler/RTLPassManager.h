@@ -0,0 +1,40 @@
+#ifndef RTLPASSMANAGER_H
+#define RTLPASSMANAGER_H
+
+#ifndef RTLGENERATORBASE_H
+#include "RTLGeneratorBase.h"
+#endif
+
+#include <vector>
+
+// Analysis or rewrite step over the RTL of all functions
+class RTLPass
+{
+public:
+	virtual ~RTLPass() {}
+
+	virtual const char *getName() const = 0;
+	virtual bool run(RTLGeneratorBase::tCollFunctionRTL &collFunctions) = 0;
+};
+
+// Runs the passes in the order they were added and keeps the time
+// each of them took. The passes are not owned by the manager.
+class RTLPassManager
+{
+public:
+	void addPass(RTLPass *pPass);
+
+	bool run(RTLGeneratorBase::tCollFunctionRTL &collFunctions);
+	void printTimes() const;
+
+private:
+	typedef struct
+	{
+		RTLPass *pPass;
+		double dTime;
+	} tPassEntry;
+
+	std::vector<tPassEntry> m_collPasses;
+};
+
+#endif
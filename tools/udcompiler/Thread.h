@@ -0,0 +1,63 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+class Mutex
+{
+public:
+	Mutex();
+	~Mutex();
+
+	void lock();
+	void unlock();
+
+private:
+	Mutex(const Mutex &);
+	Mutex &operator=(const Mutex &);
+
+#ifdef _WIN32
+	CRITICAL_SECTION m_aMutex;
+#else
+	pthread_mutex_t m_aMutex;
+#endif
+};
+
+class Thread
+{
+public:
+	typedef void (*tThreadFunc)(void *pArg);
+
+	Thread() :
+		m_pFunc(NULL),
+		m_pArg(NULL),
+		m_bRunning(false)
+	{}
+
+	bool start(tThreadFunc pFunc, void *pArg);
+	void join();
+
+	static unsigned getNumCPUs();
+
+private:
+	Thread(const Thread &);
+	Thread &operator=(const Thread &);
+
+#ifdef _WIN32
+	static DWORD WINAPI threadEntry(LPVOID pThread);
+	HANDLE m_hThread;
+#else
+	static void *threadEntry(void *pThread);
+	pthread_t m_aThread;
+#endif
+
+	tThreadFunc m_pFunc;
+	void *m_pArg;
+	bool m_bRunning;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "Timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <stddef.h>
+#endif
+
+double getTimeSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER aFrequency;
+	LARGE_INTEGER aCounter;
+
+	::QueryPerformanceFrequency(&aFrequency);
+	::QueryPerformanceCounter(&aCounter);
+
+	return static_cast<double>(aCounter.QuadPart) / static_cast<double>(aFrequency.QuadPart);
+#else
+	struct timeval aTime;
+	::gettimeofday(&aTime, NULL);
+
+	return aTime.tv_sec + (aTime.tv_usec / 1000000.0);
+#endif
+}
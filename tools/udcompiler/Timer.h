@@ -0,0 +1,7 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+// Wall clock time in seconds, only meaningful as a difference
+double getTimeSeconds();
+
+#endif
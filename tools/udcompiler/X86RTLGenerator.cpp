@@ -1,27 +1,68 @@
 #include "X86RTLGenerator.h"
+#include <stdio.h>
 
-bool X86RTLGenerator::generateRTL(const LoaderBase::tCollData &collData, tCollRTLOps &collRTLOps)
+// Linear sweep over the whole view. Bytes that don't decode and
+// instructions without a translation become OP_UNKNOWN, so one bad
+// spot doesn't end the sweep.
+bool X86RTLGenerator::generateRTL(const LoaderBase::SectionView &aCode, RTLCode &aRTLCode)
 {
+	unsigned char *pData = const_cast<unsigned char *>(aCode.getData());
 	unsigned uIdx = 0;
 
-	while(uIdx < 52)
-	//while(uIdx < collData.size())
+	while(uIdx < aCode.getSize())
 	{
 		x86_insn_t aInsn;
-		uIdx += x86_disasm((unsigned char *)&collData[0], collData.size(), 0, uIdx, &aInsn);
-
 		RTLOp aRTLOp;
+		unsigned uSize = x86_disasm(pData, aCode.getSize(), aCode.getAddress(), uIdx, &aInsn);
 
-		if(!parseInsn(aInsn, aRTLOp))
+		if(uSize)
 		{
-			return false;
+			if(!parseInsn(aInsn, aRTLOp))
+			{
+				aRTLOp = RTLOp();
+			}
+
+			x86_oplist_free(&aInsn);
 		}
+		else
+		{
+			uSize = 1;
+		}
+
+		aRTLOp.setAddress(aCode.getAddress() + uIdx);
+		aRTLCode.addOp(aRTLOp);
+		uIdx += uSize;
+	}
+
+	return true;
+}
+
+// Listing in libdisasm syntax, kept apart from the RTL generation as
+// formatting costs more than decoding
+bool X86RTLGenerator::dumpDisassembly(const LoaderBase::SectionView &aCode) const
+{
+	unsigned char *pData = const_cast<unsigned char *>(aCode.getData());
+	unsigned uIdx = 0;
 
-		collRTLOps.push_back(aRTLOp);
+	while(uIdx < aCode.getSize())
+	{
+		x86_insn_t aInsn;
+		unsigned uSize = x86_disasm(pData, aCode.getSize(), aCode.getAddress(), uIdx, &aInsn);
+
+		if(uSize)
+		{
+			char buf[1024];
+			x86_format_insn(&aInsn, buf, sizeof(buf), intel_syntax);
+			printf("0x%08X: %s\n", aCode.getAddress() + uIdx, buf);
+			x86_oplist_free(&aInsn);
+		}
+		else
+		{
+			printf("0x%08X: (bad)\n", aCode.getAddress() + uIdx);
+			uSize = 1;
+		}
 
-		char buf[1024];
-		x86_format_insn(&aInsn, buf, sizeof(buf), intel_syntax);
-		printf("0x%08X: %s\n", uIdx, buf);
+		uIdx += uSize;
 	}
 
 	return true;
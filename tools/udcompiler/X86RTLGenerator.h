@@ -21,7 +21,8 @@ public:
 		REGISTER_X86_ESP = Argument::REGISTER_R003
 	};
 
-	bool generateRTL(const LoaderBase::tCollData &collData, tCollRTLOps &collRTLOps);
+	bool generateRTL(const LoaderBase::SectionView &aCode, RTLCode &aRTLCode);
+	bool dumpDisassembly(const LoaderBase::SectionView &aCode) const;
 
 private:
 	bool parseInsn(x86_insn_t &aInsn, RTLOp &aRTLOp);
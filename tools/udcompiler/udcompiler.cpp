@@ -1,24 +1,75 @@
 #include "ElfBinaryLoader.h"
 #include "X86RTLGenerator.h"
+#include "MIPS32RTLGenerator.h"
+#include "RTLBasicPasses.h"
+#include "RTLCache.h"
+#include "Thread.h"
+#include "Timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void printSyntax(const char *pName)
+{
+	printf("Syntax: %s [--dump] [--disasm] [--cache <directory>] <object> [<threads>]\n", pName);
+}
 
 int main(int argc, char *argv[])
 {
+	bool bDumpRTL = false;
+	bool bDumpDisassembly = false;
+	std::string strCacheDirectory;
+	int iArgIdx = 1;
+
+	for(; (iArgIdx < argc) && (argv[iArgIdx][0] == '-'); iArgIdx++)
+	{
+		std::string strOption = argv[iArgIdx];
+
+		if(strOption == "--dump")
+		{
+			bDumpRTL = true;
+		}
+		else if(strOption == "--disasm")
+		{
+			bDumpDisassembly = true;
+		}
+		else if((strOption == "--cache") && ((iArgIdx + 1) < argc))
+		{
+			strCacheDirectory = argv[++iArgIdx];
+		}
+		else
+		{
+			printSyntax(argv[0]);
+			return -1;
+		}
+	}
+
+	if(iArgIdx >= argc)
+	{
+		printSyntax(argv[0]);
+		return -1;
+	}
+
+	std::string strFileName = argv[iArgIdx++];
+	unsigned uNumThreads = (iArgIdx < argc) ? strtoul(argv[iArgIdx], NULL, 0) : Thread::getNumCPUs();
+
 	ElfBinaryLoader aElfLoader;
 	LoaderBase &aLoader = aElfLoader;
 
-	if(!aLoader.loadFile("D:\\Dokumente und Einstellungen\\Florian Schirmer\\Desktop\\rec2\\gp.o"))
+	if(!aLoader.loadFile(strFileName))
 	{
 		return -1;
 	}
 
-	LoaderBase::tCollData collData;
+	LoaderBase::SectionView aCode;
+	LoaderBase::tCollSymbols collSymbols;
 
-	if(!aLoader.getMainCodeSection(collData))
+	if((!aLoader.getMainCodeSection(aCode)) || (!aLoader.getFunctionSymbols(".text", collSymbols)))
 	{
 		return -2;
 	}
 
 	X86RTLGenerator aX86RTLGenerator;
+	MIPS32RTLGenerator aMIPS32RTLGenerator;
 	RTLGeneratorBase *pRTLGenerator = NULL;
 
 	switch(aLoader.getArchType())
@@ -26,24 +77,90 @@ int main(int argc, char *argv[])
 		case LoaderBase::ARCH_TYPE_X86:
 			pRTLGenerator = &aX86RTLGenerator;
 			break;
-		//case LoaderBase::ARCH_TYPE_MIPS32:
-		//	break;
+		case LoaderBase::ARCH_TYPE_MIPS32:
+			pRTLGenerator = &aMIPS32RTLGenerator;
+			break;
 		default:
 			return -3;
 	}
 
-	RTLGeneratorBase::tCollRTLOps collRTLOps;
+	if(bDumpDisassembly)
+	{
+		pRTLGenerator->dumpDisassembly(aCode);
+	}
+
+	RTLGeneratorBase::tCollFunctionRTL collFunctions;
+	RTLCache aCache(strCacheDirectory);
+	RTLCache::tKey uCacheKey = 0;
+	bool bCached = false;
+	double dStartTime = getTimeSeconds();
 
-	if(!pRTLGenerator->generateRTL(collData, collRTLOps))
+	if(!strCacheDirectory.empty())
+	{
+		uCacheKey = RTLCache::getKey(aLoader.getArchType(), aCode, collSymbols);
+		bCached = aCache.load(uCacheKey, collFunctions);
+	}
+
+	if((!bCached) && (!pRTLGenerator->generateFunctionRTL(aCode, collSymbols, uNumThreads, collFunctions)))
 	{
 		return -4;
 	}
 
-	if(!pRTLGenerator->dumpRTL(collRTLOps))
+	double dElapsedTime = getTimeSeconds() - dStartTime;
+
+	// Stored before the passes change anything
+	if((!bCached) && (!strCacheDirectory.empty()) && (!aCache.store(uCacheKey, collFunctions)))
+	{
+		printf("Failed to write the RTL cache to %s\n", strCacheDirectory.c_str());
+	}
+	size_t uNumRTLOps = 0;
+
+	for(unsigned uIdx = 0; uIdx < collFunctions.size(); uIdx++)
+	{
+		uNumRTLOps += collFunctions[uIdx].getCode().getNumOps();
+	}
+
+	printf("%u bytes, %u functions, %u RTL ops in %.3f ms ", static_cast<unsigned>(aCode.getSize()),
+		static_cast<unsigned>(collFunctions.size()), static_cast<unsigned>(uNumRTLOps), dElapsedTime * 1000.0);
+
+	if(bCached)
+	{
+		printf("from the cache");
+	}
+	else
+	{
+		printf("using %u threads", uNumThreads);
+	}
+
+	printf(" (%.2f MB/s)\n", (dElapsedTime > 0.0) ? ((aCode.getSize() / dElapsedTime) / (1024.0 * 1024.0)) : 0.0);
+
+	RTLRemoveNopPass aRemoveNopPass;
+	RTLStatisticsPass aStatisticsPass;
+	RTLPassManager aPassManager;
+
+	aPassManager.addPass(&aRemoveNopPass);
+	aPassManager.addPass(&aStatisticsPass);
+
+	if(!aPassManager.run(collFunctions))
 	{
 		return -5;
 	}
 
+	for(unsigned uIdx = 0; bDumpRTL && (uIdx < collFunctions.size()); uIdx++)
+	{
+		const RTLGeneratorBase::FunctionRTL &aFunction = collFunctions[uIdx];
+
+		printf("%s (0x%08X, %u bytes):\n", aFunction.getName().c_str(), aFunction.getAddress(), aFunction.getSize());
+
+		if(!pRTLGenerator->dumpRTL(aFunction.getCode()))
+		{
+			return -6;
+		}
+	}
+
+	printf("%u NOPs removed\n", aRemoveNopPass.getNumRemoved());
+	aStatisticsPass.print();
+	aPassManager.printTimes();
+
 	return 0;
 }
-